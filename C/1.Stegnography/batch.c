@@ -0,0 +1,288 @@
+/* Header file */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "batch.h"
+#include "encode.h"
+#include "decode.h"
+#include "pool.h"
+#include "util.h"
+
+/* Function Definitions */
+/* Batch mode
+ * Input: Manifest file, number of threads
+ * Output: Every stego image of the manifest, failures and MB/s summary
+ * Description: Jobs are claimed in manifest order by a pool of workers,
+ * each with its own EncodeInfo and DecodeInfo, so one job computes while
+ * the others wait on their files. A worker also asks the kernel to read
+ * ahead the files of the job one round later, overlapping disk reads with
+ * embedding. A failed job is recorded and the batch goes on. The progress
+ * messages of the single run are dropped, only the report is printed
+ */
+
+typedef struct _BatchJob
+{
+    int line;			// Line number in the manifest
+    char *text;			// Copy of the line, argv points into it
+    int argc;
+    char *argv[MAX_BATCH_ARGS + 1];
+    OperationType type;
+    Status status;
+    long payload_bytes;		// Secret bytes embedded or extracted
+    long image_bytes;		// Size of the cover or stego image
+} BatchJob;
+
+typedef struct _BatchQueue
+{
+    BatchJob *jobs;
+    int count;
+    Pool pool;
+} BatchQueue;
+
+/* Function definition for parsing a manifest line into arguments */
+static Status batch_parse( BatchJob *job , const char *line , int number )
+{
+    char *save , *token ;
+
+    job->line = number ;
+    job->status = e_failure ;
+    job->text = strdup( line ) ;
+    job->argc = 1 ;
+    job->argv[0] = "batch" ;
+    if ( job->text == NULL )
+    {
+	return e_failure ;
+    }
+    for ( token = strtok_r( job->text , " \t\r\n" , &save ) ; token != NULL ; token = strtok_r( NULL , " \t\r\n" , &save ) )
+    {
+	/* Bare cover, secret and stego image is an encoding */
+	if ( job->argc == 1 && token[0] != '-' )
+	{
+	    job->argv[job->argc++] = "-e" ;
+	}
+	if ( job->argc == MAX_BATCH_ARGS )
+	{
+	    return e_failure ;
+	}
+	job->argv[job->argc++] = token ;
+    }
+    job->argv[job->argc] = NULL ;
+    if ( job->argc < 2 )
+    {
+	return e_failure ;
+    }
+    /* Same argument counts as a single run */
+    job->type = check_operation_type( job->argv ) ;
+    if ( job->type == e_encode )
+    {
+	return job->argc >= 4 ? e_success : e_failure ;
+    }
+    if ( job->type == e_decode )
+    {
+	return job->argc >= 3 && job->argc <= 6 ? e_success : e_failure ;
+    }
+    return e_failure ;
+}
+
+/* Function definition for reading ahead the input files of a job */
+static void batch_prefetch( const BatchJob *job )
+{
+    /* Cover or stego image, and the secret file of an encoding */
+    for ( int i = 2 ; i <= ( job->type == e_encode ? 3 : 2 ) && i < job->argc ; i++ )
+    {
+	int fd = open( job->argv[i] , O_RDONLY ) ;
+	if ( fd >= 0 )
+	{
+	    posix_fadvise( fd , 0 , 0 , POSIX_FADV_WILLNEED );
+	    close( fd );
+	}
+    }
+}
+
+/* Function definition for running one encoding job */
+static void batch_encode( BatchJob *job , EncodeInfo *encInfo )
+{
+    memset( encInfo , 0 , sizeof(*encInfo) );
+    if ( read_and_validate_encode_args( job->argc , job->argv , encInfo ) == e_success && do_encoding( encInfo ) == e_success )
+    {
+	job->status = e_success ;
+	job->payload_bytes = encInfo->size_secret_file ;
+	job->image_bytes = get_file_size( encInfo->fptr_src_image ) ;
+    }
+    util_close( encInfo->fptr_src_image );
+    util_close( encInfo->fptr_secret );
+    /* A write error may only show up when the stego image is flushed */
+    if ( encInfo->fptr_stego_image != NULL && fclose( encInfo->fptr_stego_image ) != 0 )
+    {
+	job->status = e_failure ;
+    }
+}
+
+/* Function definition for running one decoding job */
+static void batch_decode( BatchJob *job , DecodeInfo *decInfo )
+{
+    memset( decInfo , 0 , sizeof(*decInfo) );
+    if ( read_and_validate_decode_args( job->argv , decInfo ) == e_success && do_decoding( decInfo ) == e_success )
+    {
+	job->status = e_success ;
+	job->payload_bytes = decInfo->file_size ;
+	job->image_bytes = get_file_size( decInfo->fptr_stego_image ) ;
+    }
+    util_close( decInfo->fptr_stego_image );
+    if ( decInfo->fptr_decode != NULL && fclose( decInfo->fptr_decode ) != 0 )
+    {
+	job->status = e_failure ;
+    }
+}
+
+/* Function definition for a worker thread */
+static void *batch_worker( void *arg )
+{
+    BatchQueue *queue = arg ;
+    EncodeInfo *encInfo = malloc( sizeof(EncodeInfo) ) ;
+    DecodeInfo *decInfo = malloc( sizeof(DecodeInfo) ) ;
+
+    while ( encInfo != NULL && decInfo != NULL )
+    {
+	int i = pool_claim( &queue->pool ) ;
+	if ( i < 0 )
+	{
+	    break ;
+	}
+	/* Files of the job claimed one round later are read while this one runs */
+	if ( i + queue->pool.threads < queue->count )
+	{
+	    batch_prefetch( &queue->jobs[i + queue->pool.threads] );
+	}
+
+	BatchJob *job = &queue->jobs[i] ;
+	if ( job->argc == 0 )
+	{
+	    continue ;
+	}
+	if ( job->type == e_encode )
+	{
+	    batch_encode( job , encInfo );
+	}
+	else
+	{
+	    batch_decode( job , decInfo );
+	}
+    }
+    free( encInfo );
+    free( decInfo );
+    return NULL ;
+}
+
+/* Function definition for reading the manifest into jobs */
+static int batch_read_manifest( FILE *fptr , BatchJob **jobs , FILE *report )
+{
+    char line[MAX_MANIFEST_LINE] ;
+    int count = 0 , size = 0 , number = 0 ;
+
+    *jobs = NULL ;
+    while ( fgets( line , sizeof(line) , fptr ) != NULL )
+    {
+	number++ ;
+	char *text = line + strspn( line , " \t\r\n" ) ;
+	if ( *text == '\0' || *text == '#' )
+	{
+	    continue ;
+	}
+	if ( count == size )
+	{
+	    size = size ? 2 * size : 64 ;
+	    BatchJob *grown = realloc( *jobs , size * sizeof(BatchJob) ) ;
+	    if ( grown == NULL )
+	    {
+		while ( count > 0 )
+		{
+		    free( (*jobs)[--count].text );
+		}
+		free( *jobs );
+		return -1 ;
+	    }
+	    *jobs = grown ;
+	}
+	BatchJob *job = &(*jobs)[count++] ;
+	memset( job , 0 , sizeof(*job) );
+	if ( batch_parse( job , text , number ) != e_success )
+	{
+	    fprintf( report , "Line %d: invalid job: %s" , number , line );
+	    /* Kept as a failed job without arguments, the workers skip it */
+	    job->argc = 0 ;
+	}
+    }
+    return count ;
+}
+
+/* Function definition for running a manifest */
+Status do_batch( const char *manifest , int threads )
+{
+    FILE *fptr = fopen( manifest , "r" ) ;
+    if ( fptr == NULL )
+    {
+	perror( "fopen" );
+	fprintf( stderr , "ERROR: Unable to open file %s\n" , manifest );
+	return e_failure ;
+    }
+
+    /* The report keeps the real stdout, the messages of the jobs go to /dev/null */
+    FILE *report = util_quiet_stdout() ;
+    if ( report == NULL )
+    {
+	fclose( fptr );
+	return e_failure ;
+    }
+
+    BatchQueue queue ;
+    queue.count = batch_read_manifest( fptr , &queue.jobs , report ) ;
+    fclose( fptr );
+    if ( queue.count < 0 )
+    {
+	fprintf( report , "Out of memory reading %s\n" , manifest );
+	queue.count = 0 ;
+    }
+    double start = util_clock() ;
+    int started = pool_run( &queue.pool , queue.count , threads , batch_worker , &queue ) ;
+    double seconds = util_clock() - start ;
+
+    /* Failures in manifest order, then the totals */
+    int failed = 0 ;
+    long payload = 0 , images = 0 ;
+    for ( int i = 0 ; i < queue.count ; i++ )
+    {
+	BatchJob *job = &queue.jobs[i] ;
+	if ( job->status == e_success )
+	{
+	    payload += job->payload_bytes ;
+	    images += job->image_bytes ;
+	}
+	else if ( job->argc == 0 )
+	{
+	    /* Reported when the manifest was read */
+	    failed++ ;
+	}
+	else
+	{
+	    failed++ ;
+	    fprintf( report , "Line %d: failed to %s %s\n" , job->line , job->type == e_decode ? "decode" : "encode" , job->argc > 2 ? job->argv[2] : "" );
+	}
+	free( job->text );
+    }
+    free( queue.jobs );
+    if ( seconds <= 0 )
+    {
+	seconds = 1e-9 ;
+    }
+    fprintf( report , "Batch of %d images on %d thread%s, %d failed\n" , queue.count , started ? started : 1 , started > 1 ? "s" : "" , failed );
+    fprintf( report , "Payload %.2f MB, images %.2f MB in %.3f s: %.2f MB/s payload, %.2f MB/s images\n" ,
+	    payload / 1e6 , images / 1e6 , seconds , payload / 1e6 / seconds , images / 1e6 / seconds );
+
+    /* Back to the real stdout */
+    util_restore_stdout( report );
+    return failed == 0 ? e_success : e_failure ;
+}
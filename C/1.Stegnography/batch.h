@@ -0,0 +1,21 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * Batch mode runs a manifest of images on a pool of threads.
+ * Each line holds the arguments of a single run:
+ *     -e cover.bmp secret.txt stego.bmp [-k bits] [-z] [-p key]
+ *     -d stego.bmp decoded [-p key]
+ * A line without an operation is cover, secret and stego image
+ * to encode. Blank lines and lines starting with # are skipped
+ */
+
+#define MAX_MANIFEST_LINE 4096
+#define MAX_BATCH_ARGS 10
+
+/* Run every job of the manifest on threads workers, 0 for one per cpu */
+Status do_batch(const char *manifest, int threads);
+
+#endif
@@ -0,0 +1,639 @@
+/* Header file */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+#include "encode.h"
+#include "decode.h"
+#include "common.h"
+#include "bmp.h"
+#include "util.h"
+
+/* Function Definitions */
+/* Benchmark
+ * Input: Number of rounds
+ * Output: Failed cases and the time spent in every stage
+ * Description: The stdio pipeline of do_encoding and do_decoding is run
+ * here one stage at a time, with a clock read between stages, so a kernel
+ * or I/O change shows up in the stage it touched. do_encoding itself is
+ * run too, it takes the mmap path when it can, and its image has to be
+ * the same as the staged one. Pixel data and payloads come from a fixed
+ * seed so a failing case fails again the same way. The progress messages
+ * of the stages are dropped like in batch mode
+ */
+
+#define BENCH_KEY "bench"
+
+/* Synthetic cover */
+typedef struct _BenchCover
+{
+    int width;
+    int height;				// Negative for top-down rows
+    uint bits_per_pixel;
+} BenchCover;
+
+/* Payload of a case, a share of the capacity at bits LSBs per image byte */
+typedef struct _BenchCase
+{
+    int bits;
+    int percent;			// Of the capacity
+    long extra;				// Bytes on top
+    int compress;			// -z, on text that compresses
+    int scatter;			// -p BENCH_KEY
+    int must_fail;			// Too big for the cover
+} BenchCase;
+
+static const BenchCover bench_covers[] =
+{
+    { 64 , 48 , 24 },			// Smaller than one scatter region
+    { 333 , 201 , 24 },			// 3 bytes of padding per row
+    { 641 , -480 , 8 },			// Palette, padding, top-down
+    { 1024 , 768 , 32 },
+    { 1023 , -767 , 24 },		// Padding and top-down
+    { 2048 , 1536 , 24 },
+};
+
+static const BenchCase bench_cases[] =
+{
+    { 1 , 0 , 0 , 0 , 0 , 0 },		// Empty secret file
+    { 1 , 0 , 1 , 0 , 0 , 0 },
+    { 1 , 95 , 0 , 0 , 0 , 0 },
+    { 2 , 95 , 0 , 0 , 0 , 0 },
+    { 3 , 95 , 0 , 0 , 0 , 0 },
+    { 4 , 95 , 0 , 0 , 0 , 0 },
+    { 2 , 50 , 0 , 1 , 0 , 0 },
+    { 3 , 90 , 0 , 0 , 1 , 0 },
+    { 1 , 60 , 0 , 1 , 1 , 0 },
+    { 4 , 100 , 64 , 0 , 0 , 1 },
+};
+
+#define BENCH_COVERS (int)( sizeof(bench_covers) / sizeof(bench_covers[0]) )
+#define BENCH_CASES (int)( sizeof(bench_cases) / sizeof(bench_cases[0]) )
+
+/* Stages of the stdio pipeline */
+enum { STAGE_HEADER , STAGE_MAGIC , STAGE_EXTN , STAGE_SIZE , STAGE_DATA , STAGE_REMAINING , ENCODE_STAGES };
+enum { DSTAGE_MAGIC , DSTAGE_EXTN , DSTAGE_SIZE , DSTAGE_DATA , DECODE_STAGES };
+
+static const char *encode_stage_names[ENCODE_STAGES] = { "header copy" , "magic" , "extension" , "size" , "data" , "remaining copy" } ;
+static const char *decode_stage_names[DECODE_STAGES] = { "magic" , "extension" , "size" , "data" } ;
+
+/* Times over every successful round */
+typedef struct _BenchTotals
+{
+    double encode_stage[ENCODE_STAGES];
+    double decode_stage[DECODE_STAGES];
+    double encode_mmap;			// Whole do_encoding
+    long payload_bytes;
+    long image_bytes;
+    int rounds;
+} BenchTotals;
+
+/* Files of the scratch directory */
+typedef struct _BenchFiles
+{
+    char dir[FILENAME_MAX];
+    char cover[FILENAME_MAX];
+    char payload[FILENAME_MAX];
+    char stego[FILENAME_MAX];
+    char stego_mmap[FILENAME_MAX];
+    char decoded[FILENAME_MAX];		// Name passed to the decoder, without extension
+    char decoded_file[FILENAME_MAX];	// File it writes
+} BenchFiles;
+
+/* Function definition for the time since *lap, which moves to now */
+static double bench_lap( double *lap )
+{
+    double now = util_clock() , elapsed = now - *lap ;
+    *lap = now ;
+    return elapsed ;
+}
+
+/* Function definition for the next pseudo random number, xorshift64* */
+static uint64_t bench_random( uint64_t *state )
+{
+    *state ^= *state >> 12 ;
+    *state ^= *state << 25 ;
+    *state ^= *state >> 27 ;
+    return *state * 0x2545f4914f6cdd1dULL ;
+}
+
+/* Little endian fields of the headers */
+static void put_u16( unsigned char *p , uint value )
+{
+    p[0] = value ;
+    p[1] = value >> 8 ;
+}
+
+static void put_u32( unsigned char *p , uint value )
+{
+    put_u16( p , value );
+    put_u16( p + 2 , value >> 16 );
+}
+
+/* Function definition for writing a cover with random pixels, padding bytes stay zero */
+static Status bench_write_cover( const char *fname , const BenchCover *cover , uint64_t *state )
+{
+    int height = cover->height < 0 ? -cover->height : cover->height ;
+    uint palette = cover->bits_per_pixel == 8 ? 256 * 4 : 0 ;
+    long row_bytes = (long)cover->width * ( cover->bits_per_pixel / 8 ) ;
+    long stride = ( (long)cover->width * cover->bits_per_pixel + 31 ) / 32 * 4 ;
+    uint offset = BMP_FILE_HEADER_SIZE + 40 + palette ;
+    unsigned char header[BMP_FILE_HEADER_SIZE + 40] = { 'B' , 'M' } ;
+    Status status = e_success ;
+
+    put_u32( header + 2 , offset + stride * height );
+    put_u32( header + 10 , offset );
+    put_u32( header + 14 , 40 );
+    put_u32( header + 18 , cover->width );
+    put_u32( header + 22 , cover->height );
+    put_u16( header + 26 , 1 );
+    put_u16( header + 28 , cover->bits_per_pixel );
+    put_u32( header + 34 , stride * height );
+    put_u32( header + 38 , 2835 );
+    put_u32( header + 42 , 2835 );
+    put_u32( header + 46 , palette / 4 );
+
+    FILE *fptr = fopen( fname , "wb" ) ;
+    unsigned char *row = calloc( stride > 4 ? stride : 4 , 1 ) ;
+    if ( fptr == NULL || row == NULL || fwrite( header , sizeof(header) , 1 , fptr ) != 1 )
+    {
+	status = e_failure ;
+    }
+    /* Grey ramp palette */
+    for ( uint i = 0 ; status == e_success && i < palette / 4 ; i++ )
+    {
+	unsigned char entry[4] = { i , i , i , 0 } ;
+	if ( fwrite( entry , 4 , 1 , fptr ) != 1 )
+	{
+	    status = e_failure ;
+	}
+    }
+    for ( int y = 0 ; status == e_success && y < height ; y++ )
+    {
+	for ( long x = 0 ; x < row_bytes ; x++ )
+	{
+	    row[x] = bench_random( state ) >> 56 ;
+	}
+	if ( fwrite( row , 1 , stride , fptr ) != (size_t)stride )
+	{
+	    status = e_failure ;
+	}
+    }
+    free( row );
+    if ( fptr != NULL && fclose( fptr ) != 0 )
+    {
+	status = e_failure ;
+    }
+    return status ;
+}
+
+/* Function definition for writing a payload, random bytes or text made of a few words */
+static Status bench_write_payload( const char *fname , long size , int text , uint64_t *state )
+{
+    static const char *words[] = { "pixel " , "secret " , "image " , "hidden " , "bits " , "stego\n" , "the " , "of " } ;
+    FILE *fptr = fopen( fname , "wb" ) ;
+    Status status = fptr != NULL ? e_success : e_failure ;
+    long written = 0 ;
+
+    while ( status == e_success && written < size )
+    {
+	char buffer[MAX_SECRET_BUF_SIZE] ;
+	long count = 0 ;
+	while ( count < (long)sizeof(buffer) - 8 && written + count < size )
+	{
+	    if ( text )
+	    {
+		const char *word = words[bench_random( state ) >> 61] ;
+		while ( *word && written + count < size )
+		{
+		    buffer[count++] = *word++ ;
+		}
+	    }
+	    else
+	    {
+		buffer[count++] = bench_random( state ) >> 56 ;
+	    }
+	}
+	if ( fwrite( buffer , 1 , count , fptr ) != (size_t)count )
+	{
+	    status = e_failure ;
+	}
+	written += count ;
+    }
+    if ( fptr != NULL && fclose( fptr ) != 0 )
+    {
+	status = e_failure ;
+    }
+    return status ;
+}
+
+/* Function definition for reading a whole file into memory */
+static char *bench_read_file( const char *fname , long *size )
+{
+    FILE *fptr = fopen( fname , "rb" ) ;
+    char *data = NULL ;
+
+    if ( fptr == NULL )
+    {
+	return NULL ;
+    }
+    *size = get_file_size( fptr ) ;
+    fseek( fptr , 0 , SEEK_SET );
+    data = malloc( *size > 0 ? *size : 1 ) ;
+    if ( data != NULL && fread( data , 1 , *size , fptr ) != (size_t)*size )
+    {
+	free( data );
+	data = NULL ;
+    }
+    fclose( fptr );
+    return data ;
+}
+
+/* Function definition for encoding through the stdio pipeline, a stage at a time */
+static Status bench_encode_stages( int argc , char **argv , EncodeInfo *encInfo , double *stage )
+{
+    Status status = e_failure ;
+
+    memset( encInfo , 0 , sizeof(*encInfo) );
+    if ( read_and_validate_encode_args( argc , argv , encInfo ) == e_success && open_files( encInfo ) == e_success &&
+	    ( !( encInfo->format_flags & FORMAT_FLAG_LZ ) || compress_secret_file( encInfo ) == e_success ) &&
+	    check_capacity( encInfo ) == e_success )
+    {
+	double lap = util_clock() ;
+	status = copy_bmp_header( encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo->bmp.data_offset ) ;
+	stage[STAGE_HEADER] += bench_lap( &lap );
+	if ( status == e_success )
+	{
+	    status = encode_magic_string( MAGIC_STRING , encInfo ) ;
+	    stage[STAGE_MAGIC] += bench_lap( &lap );
+	}
+	if ( status == e_success )
+	{
+	    /* Extension size goes in the format word */
+	    status = encode_secret_file_extn_size( strlen( encInfo->extn_secret_file ) , encInfo ) ;
+	    if ( status == e_success )
+	    {
+		status = encode_secret_file_extn( encInfo->extn_secret_file , encInfo ) ;
+	    }
+	    stage[STAGE_EXTN] += bench_lap( &lap );
+	}
+	if ( status == e_success )
+	{
+	    status = encode_secret_file_size( encInfo->size_secret_file , encInfo ) ;
+	    stage[STAGE_SIZE] += bench_lap( &lap );
+	}
+	if ( status == e_success )
+	{
+	    status = encode_secret_file_data( encInfo ) ;
+	    stage[STAGE_DATA] += bench_lap( &lap );
+	}
+	if ( status == e_success )
+	{
+	    /* Buffered writes reach the file when it is closed */
+	    status = copy_remaining_img_data( encInfo->fptr_src_image , encInfo->fptr_stego_image ) ;
+	    if ( fclose( encInfo->fptr_stego_image ) != 0 )
+	    {
+		status = e_failure ;
+	    }
+	    encInfo->fptr_stego_image = NULL ;
+	    stage[STAGE_REMAINING] += bench_lap( &lap );
+	}
+    }
+    util_close( encInfo->fptr_src_image );
+    util_close( encInfo->fptr_secret );
+    util_close( encInfo->fptr_stego_image );
+    return status ;
+}
+
+/* Function definition for encoding with do_encoding, mmap when it can */
+static Status bench_encode_whole( int argc , char **argv , EncodeInfo *encInfo , double *seconds )
+{
+    double lap = util_clock() ;
+    Status status = e_failure ;
+
+    memset( encInfo , 0 , sizeof(*encInfo) );
+    if ( read_and_validate_encode_args( argc , argv , encInfo ) == e_success && do_encoding( encInfo ) == e_success )
+    {
+	status = e_success ;
+    }
+    util_close( encInfo->fptr_src_image );
+    util_close( encInfo->fptr_secret );
+    if ( encInfo->fptr_stego_image != NULL && fclose( encInfo->fptr_stego_image ) != 0 )
+    {
+	status = e_failure ;
+    }
+    *seconds += bench_lap( &lap );
+    return status ;
+}
+
+/* Function definition for decoding through the stdio pipeline, a stage at a time */
+static Status bench_decode_stages( char **argv , DecodeInfo *decInfo , double *stage )
+{
+    char file[FILENAME_MAX] ;
+    Status status = e_failure ;
+
+    memset( decInfo , 0 , sizeof(*decInfo) );
+    if ( read_and_validate_decode_args( argv , decInfo ) == e_success && open_file( decInfo ) == e_success )
+    {
+	double lap = util_clock() ;
+	status = decode_magic_string( MAGIC_STRING , decInfo->magic , decInfo ) ;
+	stage[DSTAGE_MAGIC] += bench_lap( &lap );
+	if ( status == e_success )
+	{
+	    status = decode_secret_file_extn_size( decInfo , decInfo->fptr_stego_image ) ;
+	    if ( status == e_success )
+	    {
+		status = decode_secret_file_extn( decInfo->file_extn_size , decInfo ) ;
+	    }
+	    stage[DSTAGE_EXTN] += bench_lap( &lap );
+	}
+	if ( status == e_success )
+	{
+	    /* Key check of scattered data comes before the output file, like in do_decoding */
+	    status = decode_secret_file_size( decInfo ) ;
+	    if ( status == e_success )
+	    {
+		status = decode_scatter_check( decInfo ) ;
+	    }
+	    if ( status == e_success && ( snprintf( file , sizeof(file) , "%s%s" , decInfo->decode_fname , decInfo->file_extn ) >= (int)sizeof(file) ||
+			( decInfo->fptr_decode = fopen( file , "wb" ) ) == NULL ) )
+	    {
+		status = e_failure ;
+	    }
+	    stage[DSTAGE_SIZE] += bench_lap( &lap );
+	}
+	if ( status == e_success )
+	{
+	    status = decode_data_from_image( decInfo->file_size , decInfo ) ;
+	    if ( fclose( decInfo->fptr_decode ) != 0 )
+	    {
+		status = e_failure ;
+	    }
+	    decInfo->fptr_decode = NULL ;
+	    stage[DSTAGE_DATA] += bench_lap( &lap );
+	}
+    }
+    util_close( decInfo->fptr_stego_image );
+    util_close( decInfo->fptr_decode );
+    return status ;
+}
+
+/* Function definition for checking a round trip, returns what went wrong or NULL */
+static const char *bench_check( const BenchFiles *files , int bits )
+{
+    const char *error = NULL ;
+    long cover_size = 0 , stego_size = 0 , mmap_size = 0 , payload_size = 0 , decoded_size = 0 ;
+    char *cover = bench_read_file( files->cover , &cover_size ) ;
+    char *stego = bench_read_file( files->stego , &stego_size ) ;
+    char *stego_mmap = bench_read_file( files->stego_mmap , &mmap_size ) ;
+    char *payload = bench_read_file( files->payload , &payload_size ) ;
+    char *decoded = bench_read_file( files->decoded_file , &decoded_size ) ;
+    FILE *fptr = fopen( files->cover , "rb" ) ;
+    BmpInfo bmp ;
+
+    if ( cover == NULL || stego == NULL || stego_mmap == NULL || payload == NULL || decoded == NULL ||
+	    fptr == NULL || bmp_read_info( fptr , &bmp ) != e_success )
+    {
+	error = "missing output" ;
+    }
+    else if ( stego_size != mmap_size || memcmp( stego , stego_mmap , stego_size ) != 0 )
+    {
+	error = "stdio and do_encoding images differ" ;
+    }
+    else if ( stego_size != cover_size )
+    {
+	error = "stego image size changed" ;
+    }
+    else if ( decoded_size != payload_size || memcmp( decoded , payload , payload_size ) != 0 )
+    {
+	error = "decoded file differs from the payload" ;
+    }
+    else
+    {
+	/* Headers, padding and the tail stay as they were, pixel bytes only in their low bits */
+	long end = bmp.data_offset + bmp.stride * bmp.height ;
+	for ( long i = 0 ; i < cover_size && error == NULL ; i++ )
+	{
+	    int pixel = i >= bmp.data_offset && i < end && ( i - bmp.data_offset ) % bmp.stride < bmp.row_bytes ;
+	    if ( ( ( cover[i] ^ stego[i] ) & 0xFF ) >> ( pixel ? bits : 0 ) )
+	    {
+		error = pixel ? "pixel byte changed above its LSBs" : "byte outside the pixels changed" ;
+	    }
+	}
+    }
+    util_close( fptr );
+    free( cover );
+    free( stego );
+    free( stego_mmap );
+    free( payload );
+    free( decoded );
+    return error ;
+}
+
+/* Function definition for running one case rounds times */
+static const char *bench_run_case( const BenchFiles *files , const BenchCase *test , long size , int rounds ,
+	EncodeInfo *encInfo , DecodeInfo *decInfo , BenchTotals *totals )
+{
+    char bits[4] , key[] = BENCH_KEY ;
+    char *encode_argv[12] = { "a.out" , "-e" , (char *)files->cover , (char *)files->payload , (char *)files->stego , "-k" , bits } ;
+    char *decode_argv[8] = { "a.out" , "-d" , (char *)files->stego , (char *)files->decoded } ;
+    int encode_argc = 7 , decode_argc = 4 ;
+    double discard[ENCODE_STAGES] = { 0 } ;
+
+    snprintf( bits , sizeof(bits) , "%d" , test->bits );
+    if ( test->compress )
+    {
+	encode_argv[encode_argc++] = "-z" ;
+    }
+    if ( test->scatter )
+    {
+	encode_argv[encode_argc++] = "-p" ;
+	encode_argv[encode_argc++] = key ;
+	decode_argv[decode_argc++] = "-p" ;
+	decode_argv[decode_argc++] = key ;
+    }
+
+    if ( test->must_fail )
+    {
+	return bench_encode_stages( encode_argc , encode_argv , encInfo , discard ) == e_success ? "oversized payload accepted" : NULL ;
+    }
+    for ( int round = 0 ; round < rounds ; round++ )
+    {
+	BenchTotals run = { .rounds = 0 } ;
+	const char *error = NULL ;
+
+	if ( bench_encode_stages( encode_argc , encode_argv , encInfo , run.encode_stage ) != e_success )
+	{
+	    return "stdio encoding failed" ;
+	}
+	/* do_encoding writes the second image */
+	encode_argv[4] = (char *)files->stego_mmap ;
+	Status status = bench_encode_whole( encode_argc , encode_argv , encInfo , &run.encode_mmap ) ;
+	encode_argv[4] = (char *)files->stego ;
+	if ( status != e_success )
+	{
+	    return "do_encoding failed" ;
+	}
+	/* Truncating the last output would be timed with the decoder */
+	unlink( files->decoded_file );
+	if ( bench_decode_stages( decode_argv , decInfo , run.decode_stage ) != e_success )
+	{
+	    return "decoding failed" ;
+	}
+	if ( ( error = bench_check( files , test->bits ) ) != NULL )
+	{
+	    return error ;
+	}
+	/* Any other key is turned away before an output file is made */
+	if ( test->scatter )
+	{
+	    double discard_decode[DECODE_STAGES] = { 0 } ;
+	    unlink( files->decoded_file );
+	    decode_argv[decode_argc - 1] = "wrong" ;
+	    status = bench_decode_stages( decode_argv , decInfo , discard_decode ) ;
+	    decode_argv[decode_argc - 1] = key ;
+	    if ( status == e_success || access( files->decoded_file , F_OK ) == 0 )
+	    {
+		return "wrong key accepted" ;
+	    }
+	}
+
+	for ( int i = 0 ; i < ENCODE_STAGES ; i++ )
+	{
+	    totals->encode_stage[i] += run.encode_stage[i] ;
+	}
+	for ( int i = 0 ; i < DECODE_STAGES ; i++ )
+	{
+	    totals->decode_stage[i] += run.decode_stage[i] ;
+	}
+	totals->encode_mmap += run.encode_mmap ;
+	totals->payload_bytes += size ;
+	totals->image_bytes += encInfo->image_capacity ;
+	totals->rounds++ ;
+    }
+    return NULL ;
+}
+
+/* Function definition for the stage table */
+static void bench_report_stages( FILE *report , const char *title , const char **names , const double *stage , int count , const BenchTotals *totals )
+{
+    double total = 0 ;
+    for ( int i = 0 ; i < count ; i++ )
+    {
+	total += stage[i] ;
+    }
+    fprintf( report , "%s stages over %d round trips:\n" , title , totals->rounds );
+    for ( int i = 0 ; i < count ; i++ )
+    {
+	fprintf( report , "    %-16s %10.3f ms %6.1f%%\n" , names[i] , stage[i] * 1e3 , total > 0 ? 100 * stage[i] / total : 0 );
+    }
+    fprintf( report , "    %-16s %10.3f ms, %.2f MB/s payload, %.2f MB/s pixel bytes\n" , "total" , total * 1e3 ,
+	    total > 0 ? totals->payload_bytes / 1e6 / total : 0 , total > 0 ? totals->image_bytes / 1e6 / total : 0 );
+}
+
+/* Function definition for running the benchmark */
+Status do_bench( int rounds )
+{
+    const char *tmp = getenv( "TMPDIR" ) ;
+    BenchFiles files ;
+    BenchTotals totals = { .rounds = 0 } ;
+    uint64_t state = 0x9e3779b97f4a7c15ULL ;
+    int cases = 0 , failed = 0 ;
+
+    if ( rounds <= 0 )
+    {
+	rounds = BENCH_DEFAULT_ROUNDS ;
+    }
+    snprintf( files.dir , sizeof(files.dir) , "%s/stego_bench_XXXXXX" , tmp != NULL && *tmp ? tmp : "/tmp" );
+    if ( mkdtemp( files.dir ) == NULL )
+    {
+	perror( "mkdtemp" );
+	return e_failure ;
+    }
+    if ( snprintf( files.cover , sizeof(files.cover) , "%s/cover.bmp" , files.dir ) >= (int)sizeof(files.cover) ||
+	    snprintf( files.payload , sizeof(files.payload) , "%s/payload.bin" , files.dir ) >= (int)sizeof(files.payload) ||
+	    snprintf( files.stego , sizeof(files.stego) , "%s/stego.bmp" , files.dir ) >= (int)sizeof(files.stego) ||
+	    snprintf( files.stego_mmap , sizeof(files.stego_mmap) , "%s/stego_mmap.bmp" , files.dir ) >= (int)sizeof(files.stego_mmap) ||
+	    snprintf( files.decoded , sizeof(files.decoded) , "%s/decoded" , files.dir ) >= (int)sizeof(files.decoded) ||
+	    snprintf( files.decoded_file , sizeof(files.decoded_file) , "%s/decoded.bin" , files.dir ) >= (int)sizeof(files.decoded_file) )
+    {
+	printf( "ERROR: Scratch directory name %s is too long\n" , files.dir );
+	rmdir( files.dir );
+	return e_failure ;
+    }
+
+    /* The report keeps the real stdout, the messages of the stages go to /dev/null */
+    EncodeInfo *encInfo = malloc( sizeof(EncodeInfo) ) ;
+    DecodeInfo *decInfo = malloc( sizeof(DecodeInfo) ) ;
+    FILE *report = encInfo != NULL && decInfo != NULL ? util_quiet_stdout() : NULL ;
+    if ( report == NULL )
+    {
+	free( encInfo );
+	free( decInfo );
+	rmdir( files.dir );
+	return e_failure ;
+    }
+
+    for ( int c = 0 ; c < BENCH_COVERS ; c++ )
+    {
+	const BenchCover *cover = &bench_covers[c] ;
+	int height = cover->height < 0 ? -cover->height : cover->height ;
+	long pixel_bytes = (long)cover->width * height * ( cover->bits_per_pixel / 8 ) ;
+
+	if ( bench_write_cover( files.cover , cover , &state ) != e_success )
+	{
+	    fprintf( report , "Unable to write a %dx%d cover in %s\n" , cover->width , height , files.dir );
+	    failed++ ;
+	    break ;
+	}
+	for ( int t = 0 ; t < BENCH_CASES ; t++ )
+	{
+	    const BenchCase *test = &bench_cases[t] ;
+	    /* Room after the magic string and format word, less the extension and size fields */
+	    long capacity = ( pixel_bytes - 8 * ( strlen( MAGIC_STRING ) + 4 ) ) * test->bits / 8 - 16 ;
+	    long size = capacity * test->percent / 100 + test->extra ;
+	    const char *error = NULL ;
+
+	    if ( bench_write_payload( files.payload , size , test->compress , &state ) != e_success )
+	    {
+		error = "unable to write the payload" ;
+	    }
+	    else
+	    {
+		error = bench_run_case( &files , test , size , rounds , encInfo , decInfo , &totals ) ;
+	    }
+	    cases++ ;
+	    if ( error != NULL )
+	    {
+		failed++ ;
+	    }
+	    fprintf( report , "%5dx%-5d %2u bpp%s  k=%d %-5s %9ld bytes  %s\n" , cover->width , height , cover->bits_per_pixel ,
+		    cover->height < 0 ? " top-down" : "         " , test->bits ,
+		    test->compress && test->scatter ? "-z -p" : test->compress ? "-z" : test->scatter ? "-p" : "" ,
+		    size , error != NULL ? error : test->must_fail ? "rejected" : "ok" );
+	}
+    }
+
+    fprintf( report , "\n" );
+    bench_report_stages( report , "Encode" , encode_stage_names , totals.encode_stage , ENCODE_STAGES , &totals );
+    fprintf( report , "Encode with do_encoding, open and capacity check included: %.3f ms, %.2f MB/s payload\n" , totals.encode_mmap * 1e3 ,
+	    totals.encode_mmap > 0 ? totals.payload_bytes / 1e6 / totals.encode_mmap : 0 );
+    bench_report_stages( report , "Decode" , decode_stage_names , totals.decode_stage , DECODE_STAGES , &totals );
+    fprintf( report , "Bench of %d cases, %d round%s each, %d failed\n" , cases , rounds , rounds > 1 ? "s" : "" , failed );
+
+    unlink( files.cover );
+    unlink( files.payload );
+    unlink( files.stego );
+    unlink( files.stego_mmap );
+    unlink( files.decoded_file );
+    rmdir( files.dir );
+    free( encInfo );
+    free( decInfo );
+
+    /* Back to the real stdout */
+    util_restore_stdout( report );
+    return failed == 0 ? e_success : e_failure ;
+}
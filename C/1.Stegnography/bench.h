@@ -0,0 +1,22 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * Benchmark and round trip check of the whole program.
+ * Covers of several sizes and bit depths, padded and top-down
+ * rows among them, and random payloads are made in a scratch
+ * directory. Every case is encoded stage by stage through stdio,
+ * encoded again with do_encoding and decoded stage by stage; both
+ * stego images must be the same, only the LSBs of pixel bytes may
+ * change and the decoded file must match the payload byte for byte.
+ * A scattered image also has to turn away a wrong key
+ */
+
+#define BENCH_DEFAULT_ROUNDS 3
+
+/* Run every case rounds times, print the failures and the time of every stage */
+Status do_bench(int rounds);
+
+#endif
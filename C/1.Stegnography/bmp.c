@@ -0,0 +1,150 @@
+/* Header file */
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include "bmp.h"
+
+/* Function Definitions */
+/* BMP container
+ * Input: Image file ptr
+ * Output: Pixel data offset, size and row layout
+ * Description: The file header gives the pixel data offset (bfOffBits), the
+ * DIB header after it its own size, so BITMAPINFOHEADER and its V2 to V5
+ * extensions all keep width, height, bit count and compression at the same
+ * place. Rows are padded to 4 bytes, a negative height marks a top-down
+ * image. Only uncompressed 8, 24 and 32 bpp images can carry data in their
+ * pixel bytes
+ */
+
+#define BI_RGB 0
+#define BI_BITFIELDS 3
+#define BI_ALPHABITFIELDS 6
+
+/* Little endian fields of the headers */
+static uint read_u16( const unsigned char *p )
+{
+    return p[0] | p[1] << 8 ;
+}
+
+static uint read_u32( const unsigned char *p )
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint)p[3] << 24 ;
+}
+
+/* Function definition for reading BMP headers */
+Status bmp_read_info( FILE *fptr , BmpInfo *bmp )
+{
+    unsigned char header[BMP_FILE_HEADER_SIZE + 40] ;
+    long file_size ;
+
+    fseek ( fptr , 0 , SEEK_END );
+    file_size = ftell ( fptr );
+    fseek ( fptr , 0 , SEEK_SET );
+    if ( fread ( header , sizeof(header) , 1 , fptr ) != 1 || header[0] != 'B' || header[1] != 'M' )
+    {
+	printf ("Not a BMP image\n");
+	return e_failure ;
+    }
+
+    bmp->data_offset = read_u32( header + 10 );
+    bmp->dib_size = read_u32( header + 14 );
+    bmp->width = (int)read_u32( header + 18 );
+    bmp->height = (int)read_u32( header + 22 );
+    bmp->bits_per_pixel = read_u16( header + 28 );
+    uint compression = read_u32( header + 30 );
+
+    /* BITMAPINFOHEADER, its V2 and V3 forms, V4 and V5 */
+    if ( bmp->dib_size != 40 && bmp->dib_size != 52 && bmp->dib_size != 56 && bmp->dib_size != 108 && bmp->dib_size != 124 )
+    {
+	printf ("Unsupported BMP header of %u bytes\n", bmp->dib_size );
+	return e_failure ;
+    }
+    if ( compression != BI_RGB && compression != BI_BITFIELDS && compression != BI_ALPHABITFIELDS )
+    {
+	printf ("Compressed BMP images are not supported\n");
+	return e_failure ;
+    }
+    if ( bmp->bits_per_pixel != 8 && bmp->bits_per_pixel != 24 && bmp->bits_per_pixel != 32 )
+    {
+	printf ("Unsupported %u bits per pixel\n", bmp->bits_per_pixel );
+	return e_failure ;
+    }
+
+    /* The most negative height has no positive form */
+    if ( bmp->height == INT_MIN )
+    {
+	printf ("Corrupt BMP image\n");
+	return e_failure ;
+    }
+    bmp->top_down = bmp->height < 0 ;
+    if ( bmp->top_down )
+    {
+	bmp->height = -bmp->height ;
+    }
+    bmp->row_bytes = (long)bmp->width * ( bmp->bits_per_pixel / 8 ) ;
+    bmp->stride = ( (long)bmp->width * bmp->bits_per_pixel + 31 ) / 32 * 4 ;
+
+    /* Pixel data has to sit after the headers and inside the file, the rows are
+     * checked by division so a huge width or height can not wrap the product */
+    if ( bmp->width <= 0 || bmp->height <= 0 || bmp->data_offset < BMP_FILE_HEADER_SIZE + bmp->dib_size ||
+	    bmp->data_offset > file_size || bmp->stride > ( file_size - (long)bmp->data_offset ) / bmp->height )
+    {
+	printf ("Corrupt BMP image\n");
+	return e_failure ;
+    }
+    return e_success ;
+}
+
+/* Function definition for capacity of the image */
+long bmp_pixel_bytes( const BmpInfo *bmp )
+{
+    return bmp->row_bytes * bmp->height ;
+}
+
+/* Function definition for offset of a pixel byte */
+long bmp_pixel_offset( const BmpInfo *bmp , long index )
+{
+    return bmp->data_offset + index / bmp->row_bytes * bmp->stride + index % bmp->row_bytes ;
+}
+
+/* Function definition for the end of the pixel bytes before index */
+long bmp_pixel_end( const BmpInfo *bmp , long index )
+{
+    return index == 0 ? bmp->data_offset : bmp_pixel_offset( bmp , index - 1 ) + 1 ;
+}
+
+/* Function definition for gathering pixel bytes around row padding */
+void bmp_gather( const BmpInfo *bmp , long index , const char *raw , char *pixels , long count )
+{
+    long run = bmp->row_bytes - index % bmp->row_bytes ;
+    while ( count > 0 )
+    {
+	if ( run > count )
+	{
+	    run = count ;
+	}
+	memcpy ( pixels , raw , run );
+	pixels += run ;
+	count -= run ;
+	raw += run + bmp->stride - bmp->row_bytes ;
+	run = bmp->row_bytes ;
+    }
+}
+
+/* Function definition for scattering pixel bytes around row padding */
+void bmp_scatter( const BmpInfo *bmp , long index , char *raw , const char *pixels , long count )
+{
+    long run = bmp->row_bytes - index % bmp->row_bytes ;
+    while ( count > 0 )
+    {
+	if ( run > count )
+	{
+	    run = count ;
+	}
+	memcpy ( raw , pixels , run );
+	pixels += run ;
+	count -= run ;
+	raw += run + bmp->stride - bmp->row_bytes ;
+	run = bmp->row_bytes ;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef BMP_H
+#define BMP_H
+
+#include <stdio.h>
+#include "types.h" // Contains user defined types
+
+/*
+ * Layout of an uncompressed BMP image.
+ * Pixel bytes are numbered in file order, row by row,
+ * skipping the padding that ends every row
+ */
+
+#define BMP_FILE_HEADER_SIZE 14
+
+typedef struct _BmpInfo
+{
+    uint data_offset;		// bfOffBits, first pixel byte
+    uint dib_size;		// 40, 52, 56, 108 or 124
+    int width;
+    int height;			// Always positive
+    int top_down;		// Negative height in the file
+    uint bits_per_pixel;	// 8, 24 or 32
+    long row_bytes;		// Pixel bytes of a row
+    long stride;		// Row size with padding, multiple of 4
+} BmpInfo;
+
+/* Read and validate the headers of a BMP image */
+Status bmp_read_info(FILE *fptr, BmpInfo *bmp);
+
+/* Number of pixel bytes, the capacity of the image in LSBs */
+long bmp_pixel_bytes(const BmpInfo *bmp);
+
+/* File offset of pixel byte index */
+long bmp_pixel_offset(const BmpInfo *bmp, long index);
+
+/* File offset just past pixel byte index - 1, the data offset for index 0 */
+long bmp_pixel_end(const BmpInfo *bmp, long index);
+
+/* Copy count pixel bytes out of raw file bytes that start at pixel byte index */
+void bmp_gather(const BmpInfo *bmp, long index, const char *raw, char *pixels, long count);
+
+/* Copy count pixel bytes back into raw file bytes that start at pixel byte index */
+void bmp_scatter(const BmpInfo *bmp, long index, char *raw, const char *pixels, long count);
+
+#endif
@@ -4,4 +4,29 @@
 /* Magic string to identify whether stegged or not */
 #define MAGIC_STRING "#*"
 
+/*
+ * Word after the magic string, both at one bit per image byte:
+ * flags, LSBs per image byte - 1, extension size. The upper bytes
+ * are zero in the original one bit format
+ */
+#define FORMAT_BITS_SHIFT 16
+#define FORMAT_FLAGS_SHIFT 24
+#define FORMAT_EXTN_MASK 0xFFFF
+#define MAX_LSB_BITS 4
+
+/* Flags of the format word */
+#define FORMAT_FLAG_PART 0x01	// One part of a payload split across images
+#define FORMAT_FLAG_LZ 0x02	// Secret compressed with lz.c, size field is the compressed size
+#define FORMAT_FLAG_SCATTER 0x04	// Key check after the size field, then data scattered with the key, see scatter.h
+#define FORMAT_KNOWN_FLAGS (FORMAT_FLAG_PART | FORMAT_FLAG_LZ | FORMAT_FLAG_SCATTER)
+
+/*
+ * Part header after the size field of a split payload, most significant
+ * byte first: set id (4), part index (2), part count (2), offset (4),
+ * total size (4), CRC-32 of the part (4). The set id is the CRC-32 of
+ * the part CRCs in index order
+ */
+#define PART_HEADER_SIZE 20
+#define MAX_PARTS 0xFFFF
+
 #endif
@@ -3,23 +3,38 @@
 #include "decode.h"
 #include "types.h"
 #include "common.h"
+#include "lsb.h"
 #include <string.h>
 
 /* Function definition of read and validate function */
 Status read_and_validate_decode_args( char *argv[] , DecodeInfo *decInfo )
 {
-    if ( strcmp( strstr(argv[2] , "." ) , ".bmp" ) == 0 )
+    /* Last dot, paths like ../stego.bmp have others before it */
+    char *suffix = strrchr( argv[2] , '.' ) ;
+    if ( suffix != NULL && strcmp( suffix , ".bmp" ) == 0 )
     {
 	decInfo->stego_image_fname = argv[2] ;
+	decInfo->scatter_key = NULL ;
+	int i = 3 ;
 	
-	if ( argv[3] != NULL )
+	if ( argv[3] != NULL && strcmp( argv[3] , "-p" ) != 0 )
     	{
     	    decInfo->decode_fname = argv[3] ;
+	    i = 4 ;
     	}
     	else
     	{
 	decInfo->decode_fname = "output" ;
 	}
+	/* Key of a scattered image */
+	if ( argv[i] != NULL )
+	{
+	    if ( strcmp( argv[i] , "-p" ) != 0 || argv[i + 1] == NULL || argv[i + 2] != NULL )
+	    {
+		return e_failure ;
+	    }
+	    decInfo->scatter_key = argv[i + 1] ;
+	}
     }
     else
     {
@@ -45,30 +60,45 @@ Status do_decoding( DecodeInfo *decInfo )
 	    {
 		printf ("Decoded file extn size successfully\n");
 
+		/* Split payloads are only complete with all their images */
+		if ( decInfo->format_flags & FORMAT_FLAG_PART )
+		{
+		    printf ("Image holds one part of a split payload, decode all parts with -j\n");
+		    return e_failure ;
+		}
+
 		/* Decoding file extension */
 		if ( decode_secret_file_extn( decInfo -> file_extn_size , decInfo) == e_success )
 		{
 		    printf ("Decoded file extn successfully\n");
-		    char file[100];
-		    strcpy(file, decInfo -> decode_fname );
-		    strcat(file, decInfo -> file_extn);
+		    char file[FILENAME_MAX];
+		    if ( snprintf(file, sizeof(file), "%s%s", decInfo -> decode_fname, decInfo -> file_extn) >= (int)sizeof(file) )
+		    {
+			return e_failure;
+		    }
 		 //   printf("%s\n", file);
 		    decInfo -> decode_fname = file;
 		   // printf("%s\n", decInfo -> decode_fname);
 
-		    decInfo -> fptr_decode = fopen (decInfo -> decode_fname, "w");
-		    if(decInfo -> fptr_decode == NULL)
-		    {
-			perror("fopen");
-			fprintf(stderr, "Error: Unable to open file %s\n", decInfo -> decode_fname);
-		    return e_failure;
-		    }
-
 		    /* Decoding file size */
 		    if ( decode_secret_file_size ( decInfo ) == e_success )
 		    {
 			printf ("Decoded file size from stego image file successfully \n");
 
+			/* Scattered data needs the right key, checked before the output file exists */
+			if ( decode_scatter_check( decInfo ) != e_success )
+			{
+			    return e_failure ;
+			}
+
+			decInfo -> fptr_decode = fopen (decInfo -> decode_fname, "wb");
+			if(decInfo -> fptr_decode == NULL)
+			{
+			    perror("fopen");
+			    fprintf(stderr, "Error: Unable to open file %s\n", decInfo -> decode_fname);
+			    return e_failure;
+			}
+
 			/* Decoding data from image */
 			if ( decode_data_from_image ( decInfo-> file_size , decInfo ) == e_success )
 			{
@@ -116,7 +146,7 @@ Status do_decoding( DecodeInfo *decInfo )
 Status open_file(DecodeInfo *decInfo)
 {
     /* Stego Image file */
-    decInfo->fptr_stego_image = fopen(decInfo->stego_image_fname, "r");
+    decInfo->fptr_stego_image = fopen(decInfo->stego_image_fname, "rb");
     /* Error handling */
     if (decInfo->fptr_stego_image == NULL)
     {
@@ -131,17 +161,21 @@ Status open_file(DecodeInfo *decInfo)
 /* Decoding magic string */
 Status decode_magic_string( const char *magic_string , char *magic , DecodeInfo *decInfo )
 {
-    char data[8] ;
-    /* Setting stego file pointer at 54 byte position */
-    fseek (decInfo->fptr_stego_image , 54 , SEEK_SET );
+    int len = strlen( magic_string ) ;
+    /* Parsing bmp headers, data starts at the first pixel byte */
+    if ( bmp_read_info( decInfo->fptr_stego_image , &decInfo->bmp ) != e_success )
+    {
+	return e_failure ;
+    }
+    decInfo->pixel_pos = 0 ;
+    /* Magic string and format word are always one bit per image byte */
+    decInfo->lsb_bits = 1 ;
     /* Decoding magic string from lsb, storing it to an string and comparing both and returning ouput */
-
-    for ( int i  = 0 ; i < strlen(magic_string ) ; i++ )
+    if ( decode_bytes_from_image( magic , len , decInfo ) != e_success )
     {
-	/* Reading 8 bytes once from stego_image_pointer to data */
-	fread( data , 8 , 1 , decInfo->fptr_stego_image );
-	magic[i] = decode_byte_from_lsb(data);
+	return e_failure ;
     }
+    magic[len] = '\0' ;
     if ( strcmp(magic_string , magic) == 0 )
     {
 	return e_success ;
@@ -155,9 +189,25 @@ Status decode_magic_string( const char *magic_string , char *magic , DecodeInfo
 /* Function definition for file extension size */
 Status decode_secret_file_extn_size( DecodeInfo *decInfo , FILE *fptr_stego_image )
 {
-    char arr[32];
-    fread( arr, 32 , 1, fptr_stego_image);
-    decInfo->file_extn_size = decode_size_to_lsb(arr);
+    /* Bytes come through decode_bytes_from_image, which tracks the pixel position */
+    (void)fptr_stego_image;
+    unsigned char bytes[4];
+    if ( decode_bytes_from_image( (char *)bytes , 4 , decInfo ) != e_success )
+    {
+	return e_failure;
+    }
+    /* Most significant byte first, flags and LSBs per image byte above the extension size */
+    uint word = (uint)bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3];
+    int bits = ( word >> FORMAT_BITS_SHIFT & 0xFF ) + 1;
+    if ( ( word >> FORMAT_FLAGS_SHIFT & ~FORMAT_KNOWN_FLAGS ) != 0 || bits > MAX_LSB_BITS )
+    {
+	printf ("Unsupported stego format\n");
+	return e_failure;
+    }
+    decInfo->file_extn_size = word & FORMAT_EXTN_MASK;
+    decInfo->format_flags = word >> FORMAT_FLAGS_SHIFT;
+    /* Everything after the format word uses the stored number of bits */
+    decInfo->lsb_bits = bits;
 //    printf("%d\n", decInfo -> file_extn_size);
     return e_success;
 }
@@ -165,16 +215,12 @@ Status decode_secret_file_extn_size( DecodeInfo *decInfo , FILE *fptr_stego_imag
 /* Function definition for file extension */
 Status decode_secret_file_extn(uint file_extn_size, DecodeInfo *decInfo)
 {
-    char arr[8];
-    int i;
-    char data;
-    for(i = 0 ; i < file_extn_size ; i++)
+    /* Extension has to fit the buffer, a damaged size would overrun it */
+    if ( file_extn_size > MAX_FILE_SUFFIX || decode_bytes_from_image( decInfo -> file_extn , file_extn_size , decInfo ) != e_success )
     {
-	fread( arr ,8, 1, decInfo -> fptr_stego_image);
-	data = decode_byte_from_lsb(arr);
-	decInfo -> file_extn[i] = data;
-    } 
-    decInfo -> file_extn[i] = '\0';
+	return e_failure;
+    }
+    decInfo -> file_extn[file_extn_size] = '\0';
   //  printf("%s\n", decInfo -> file_extn);
     return e_success;
 }
@@ -182,44 +228,175 @@ Status decode_secret_file_extn(uint file_extn_size, DecodeInfo *decInfo)
 /* Function definition to decode secret file size from stego file*/
 Status decode_secret_file_size( DecodeInfo *decInfo )
 {     
-    char arr[32]; 
-    fread(arr, 32, 1, decInfo -> fptr_stego_image);
-    decInfo -> file_size = decode_size_to_lsb(arr);
+    unsigned char bytes[4];
+    if ( decode_bytes_from_image( (char *)bytes , 4 , decInfo ) != e_success )
+    {
+	return e_failure;
+    }
+    /* Most significant byte first */
+    decInfo -> file_size = (uint)bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3];
     return e_success;
 }
 
-/* Function definition to decode data from image */
-Status decode_data_from_image(int size, DecodeInfo *decInfo)
+/* Function definition to check the key of scattered data against its check word */
+Status decode_scatter_check( DecodeInfo *decInfo )
 {
-    char arr[8];
-    for( int i = 0 ; i < size ; i++)
+    unsigned char bytes[SCATTER_CHECK_SIZE];
+    if ( !( decInfo -> format_flags & FORMAT_FLAG_SCATTER ) )
+    {
+	return e_success;
+    }
+    if ( decInfo -> scatter_key == NULL )
+    {
+	printf ("Data is scattered, pass its key with -p\n");
+	return e_failure;
+    }
+    if ( decode_bytes_from_image( (char *)bytes , SCATTER_CHECK_SIZE , decInfo ) != e_success )
     {
-	fread(arr, 8, 1, decInfo -> fptr_stego_image);
-	decInfo -> decode_data[0] = decode_byte_from_lsb(arr);
-	fwrite(decInfo -> decode_data , 1 , 1 , decInfo->fptr_decode);
+	return e_failure;
+    }
+    /* Most significant byte first */
+    if ( ( (uint)bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3] ) != scatter_key_check( decInfo -> scatter_key ) )
+    {
+	printf ("Wrong key for the scattered data\n");
+	return e_failure;
     }
     return e_success;
 }
 
-/* Function definition to decode each byte of lsb */
-char decode_byte_from_lsb(char *data_buffer)
+/* Function definition to decode data from image */
+Status decode_data_from_image(uint size, DecodeInfo *decInfo)
 {
-    char data = 0;
-    for(int i = 0 ; i < 8 ; i++)
+    /* Blocks of whole groups of lsb_bits bytes continue the bit stream of the encoder */
+    int step = MAX_DECODE_BUF_SIZE / decInfo -> lsb_bits * decInfo -> lsb_bits;
+    /* A compressed secret is decompressed on its way to the file */
+    int compressed = decInfo -> format_flags & FORMAT_FLAG_LZ;
+    lz_stream_init( &decInfo -> lz_stream , decInfo -> fptr_decode );
+    if ( decInfo -> format_flags & FORMAT_FLAG_SCATTER )
     {
-	data_buffer[i] = data_buffer[i] & 1;
-	data = (data << 1) | data_buffer[i];
+	return decode_scattered_data( size , decInfo );
     }
-    return data;
+    /* One read, one extraction and one write per block of secret bytes, memory stays constant */
+    for( long i = 0 ; i < size ; i += step )
+    {
+	int chunk = size - i < step ? size - i : step;
+	if ( decode_bytes_from_image( decInfo -> secret_data , chunk , decInfo ) != e_success )
+	{
+	    return e_failure;
+	}
+	if ( compressed )
+	{
+	    if ( lz_stream_write( &decInfo -> lz_stream , decInfo -> secret_data , chunk ) != e_success )
+	    {
+		printf ("Compressed secret is damaged\n");
+		return e_failure;
+	    }
+	}
+	else if ( fwrite(decInfo -> secret_data , 1 , chunk , decInfo->fptr_decode) != (size_t)chunk )
+	{
+	    return e_failure;
+	}
+    }
+    return compressed ? lz_stream_end( &decInfo -> lz_stream ) : e_success;
+}
+
+/* Function definition to decode data scattered over the regions after the header */
+Status decode_scattered_data( uint size , DecodeInfo *decInfo )
+{
+    BmpInfo *bmp = &decInfo -> bmp;
+    Scatter *scatter = &decInfo -> scatter;
+    int compressed = decInfo -> format_flags & FORMAT_FLAG_LZ;
+    if ( scatter_plan( scatter , decInfo -> scatter_key , decInfo -> pixel_pos , bmp_pixel_bytes( bmp ) - decInfo -> pixel_pos , size , decInfo -> lsb_bits ) != e_success )
+    {
+	return e_failure;
+    }
+    long region_size = scatter -> region_size , offset , count;
+    /* Shares in data order, each from the region the key put it in */
+    for ( long index = 0 ; index < scatter -> regions ; index++ )
+    {
+	long region = scatter_region( scatter , index );
+	scatter_data_range( scatter , region , &offset , &count );
+	if ( count == 0 )
+	{
+	    break;
+	}
+	long first = scatter -> base + region * region_size , start = bmp_pixel_offset( bmp , first );
+	long span = bmp_pixel_offset( bmp , first + region_size - 1 ) + 1 - start;
+	char *raw = span == region_size ? decInfo -> decode_data : decInfo -> decode_raw;
+	if ( span > MAX_DATA_BUF_SIZE || fseek( decInfo -> fptr_stego_image , start , SEEK_SET ) != 0 || fread( raw , 1 , span , decInfo -> fptr_stego_image ) != (size_t)span )
+	{
+	    return e_failure;
+	}
+	if ( raw != decInfo -> decode_data )
+	{
+	    bmp_gather( bmp , first , raw , decInfo -> decode_data , region_size );
+	}
+	scatter_extract( scatter , region , decInfo -> decode_data , decInfo -> secret_data );
+	if ( compressed )
+	{
+	    if ( lz_stream_write( &decInfo -> lz_stream , decInfo -> secret_data , count ) != e_success )
+	    {
+		printf ("Compressed secret is damaged\n");
+		return e_failure;
+	    }
+	}
+	else if ( fwrite( decInfo -> secret_data , 1 , count , decInfo -> fptr_decode ) != (size_t)count )
+	{
+	    return e_failure;
+	}
+    }
+    return compressed ? lz_stream_end( &decInfo -> lz_stream ) : e_success;
 }
 
-uint decode_size_to_lsb( char *buffer )
+/* Function definition to decode bytes from the next pixel bytes of the image */
+Status decode_bytes_from_image( char *data , long size , DecodeInfo *decInfo )
 {
-    unsigned int  data =  0;
-    for ( int i = 0 ; i < 32 ; i++ )
+    BmpInfo *bmp = &decInfo -> bmp;
+    int bits = decInfo -> lsb_bits;
+    int step = MAX_DECODE_BUF_SIZE / bits * bits;
+    /* Sizes come from the image, they must not reach past its pixel bytes */
+    if ( decInfo -> pixel_pos + lsb_image_bytes( size , bits ) > bmp_pixel_bytes( bmp ) )
     {
-	buffer[i] = buffer[i] & 1 ;
-	data =  ( data << 1 ) | buffer[i] ;
+	return e_failure;
     }
-    return data ;
+    for ( long i = 0 , chunk ; i < size ; i += chunk )
+    {
+	chunk = size - i < step ? size - i : step;
+	/* Window from the first pixel byte, row padding makes it longer than its pixel bytes */
+	long first = decInfo -> pixel_pos , start = bmp_pixel_offset( bmp , first );
+	while ( bmp_pixel_offset( bmp , first + lsb_image_bytes( chunk , bits ) - 1 ) + 1 - start > MAX_DATA_BUF_SIZE )
+	{
+	    chunk = chunk / 2 / bits * bits;
+	}
+	long pixels = lsb_image_bytes( chunk , bits );
+	long span = bmp_pixel_offset( bmp , first + pixels - 1 ) + 1 - start;
+	char *raw = span == pixels ? decInfo -> decode_data : decInfo -> decode_raw;
+	if ( fseek( decInfo -> fptr_stego_image , start , SEEK_SET ) != 0 || fread( raw , 1 , span , decInfo -> fptr_stego_image ) != (size_t)span )
+	{
+	    return e_failure;
+	}
+	if ( raw != decInfo -> decode_data )
+	{
+	    bmp_gather( bmp , first , raw , decInfo -> decode_data , pixels );
+	}
+	lsb_extract_bits( data + i , decInfo -> decode_data , chunk , bits );
+	decInfo -> pixel_pos += pixels;
+    }
+    return e_success;
+}
+
+/* Function definition to decode each byte of lsb */
+char decode_byte_from_lsb(const char *data_buffer)
+{
+    char data;
+    lsb_extract( &data , data_buffer , 1 );
+    return data;
+}
+
+uint decode_size_to_lsb( const char *buffer )
+{
+    unsigned char bytes[4];
+    /* Most significant byte first */
+    lsb_extract( (char *)bytes , buffer , 4 );
+    return (uint)bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3] ;
 }
@@ -5,6 +5,9 @@
 
 #include<stdio.h>
 #include"common.h"
+#include"bmp.h"
+#include"lz.h"
+#include"scatter.h"
 #ifndef TYPES
 #define TYPES
 #include "types.h" // Contains user defined types
@@ -18,7 +21,7 @@
 
  */
 
-#define MAX_DECODE_BUF_SIZE 1
+#define MAX_DECODE_BUF_SIZE 8192
 #define MAX_DATA_BUF_SIZE (MAX_DECODE_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 4
 
@@ -30,8 +33,17 @@ typedef struct _DecodeInfo
     FILE *fptr_stego_image;
     uint file_size ;
     uint file_extn_size ;
+    uint format_flags ;
+    BmpInfo bmp;
+    long pixel_pos;
+    int lsb_bits;
     char decode_data[MAX_DATA_BUF_SIZE];
-    char file_extn[MAX_FILE_SUFFIX];
+    char decode_raw[MAX_DATA_BUF_SIZE];
+    char secret_data[MAX_DECODE_BUF_SIZE];
+    char file_extn[MAX_FILE_SUFFIX + 1];
+    LzStream lz_stream;
+    char *scatter_key;
+    Scatter scatter;
     char magic[3];
     char secret_file_extn[5];
     /* Decode File Info */
@@ -64,13 +76,22 @@ Status decode_secret_file_extn( uint file_extn_size , DecodeInfo *decInfo);
 /* Decode secret file size */
 Status decode_secret_file_size( DecodeInfo *decInfo);
 
+/* Check the key of scattered data, nothing to do for other data */
+Status decode_scatter_check( DecodeInfo *decInfo );
+
 /* Decode function, which does the real decoding */
-Status decode_data_from_image( int size,  DecodeInfo *decInfo);
+Status decode_data_from_image( uint size,  DecodeInfo *decInfo);
+
+/* Decode data scattered over the regions after the header */
+Status decode_scattered_data( uint size , DecodeInfo *decInfo );
+
+/* Decode bytes from the next pixel bytes of the image */
+Status decode_bytes_from_image( char *data , long size , DecodeInfo *decInfo );
 
 /* Decode a byte into LSB of image data array */
-char decode_byte_from_lsb( char *data_buffer);
+char decode_byte_from_lsb( const char *data_buffer);
 
 /* Decode size from lsb */
-uint decode_size_to_lsb(  char *buffer );
+uint decode_size_to_lsb( const char *buffer );
 
 #endif
@@ -1,8 +1,11 @@
 /* Header file */
 #include <stdio.h>
+#include <stdlib.h>
 #include "encode.h"
 #include "types.h"
 #include "common.h"
+#include "lsb.h"
+#include "lz.h"
 #include <string.h>
 
 /* Function Definitions */
@@ -17,6 +20,49 @@
 
 Status read_and_validate_encode_args(int argc,  char *argv[] , EncodeInfo *encInfo )
 {
+    /* LSBs per image byte, 0 lets check_capacity pick the fewest that fit */
+    encInfo->lsb_bits = 0 ;
+    /* Whole secret file in one image */
+    encInfo->secret_offset = 0 ;
+    encInfo->format_flags = 0 ;
+    encInfo->data_header_size = 0 ;
+    encInfo->scatter_key = NULL ;
+    /* Options after the stego image name */
+    for ( int i = 5 ; i < argc ; i++ )
+    {
+	if ( strcmp( argv[i] , "-k" ) == 0 && i + 1 < argc )
+	{
+	    encInfo->lsb_bits = atoi( argv[++i] ) ;
+	    if ( encInfo->lsb_bits < 1 || encInfo->lsb_bits > MAX_LSB_BITS )
+	    {
+		printf("Error: -k takes 1 to %d bits per image byte\n", MAX_LSB_BITS);
+		return e_failure;
+	    }
+	}
+	else if ( strcmp( argv[i] , "-z" ) == 0 )
+	{
+	    /* Compress before embedding */
+	    encInfo->format_flags |= FORMAT_FLAG_LZ ;
+	}
+	else if ( strcmp( argv[i] , "-p" ) == 0 && i + 1 < argc )
+	{
+	    /* Scatter the data with a key, its check word goes before the data, most significant byte first */
+	    encInfo->scatter_key = argv[++i] ;
+	    encInfo->format_flags |= FORMAT_FLAG_SCATTER ;
+	    uint check = scatter_key_check( encInfo->scatter_key ) ;
+	    for ( int j = 0 ; j < SCATTER_CHECK_SIZE ; j++ )
+	    {
+		encInfo->data_header[j] = check >> ( 24 - 8 * j ) ;
+	    }
+	    encInfo->data_header_size = SCATTER_CHECK_SIZE ;
+	}
+	else
+	{
+	    printf("Usage: ./a.out -e beautifull.bmp secert.txt stego.bmp [-k bits] [-z] [-p key]\n");
+	    return e_failure;
+	}
+    }
+
     if(strstr(argv[2], ".bmp") == NULL)
     {
 	printf("Error: argv[2] is not passed properly.\n");
@@ -37,7 +83,9 @@ Status read_and_validate_encode_args(int argc,  char *argv[] , EncodeInfo *encIn
 	    if(argv[4] != NULL)
     	    {
 		printf("Yes! argv[4] passed\n");
-		if(strcmp(strstr(argv[4], "."), ".bmp") == 0)
+		/* Last dot, paths like ../out/stego.bmp have others before it */
+		char *suffix = strrchr(argv[4], '.');
+		if(suffix != NULL && strcmp(suffix, ".bmp") == 0)
 		{
 		    /* Storing passed output file */
 		    printf("image name ");
@@ -65,6 +113,7 @@ Status read_and_validate_encode_args(int argc,  char *argv[] , EncodeInfo *encIn
     else
     {
 	printf("Error! argv[2] is not a .bmp file\n");
+	return e_failure;
     }
 }
 
@@ -78,14 +127,28 @@ Status do_encoding ( EncodeInfo *encInfo )
 
 	printf ("Open files is a success\n");
 
+	/* Compressed copy of the secret file stands in for it from here on */
+	if ( ( encInfo->format_flags & FORMAT_FLAG_LZ ) && compress_secret_file( encInfo ) != e_success )
+	{
+	    printf ("Failed to compress secret file\n");
+	    return e_failure ;
+	}
+
 	/* Function call to check capacity function and checking whether condition is success or not */
 	if ( check_capacity(encInfo) == e_success )
 	{
 
 	    printf ( "Check capacity is a success \n");
 
+	    /* Single pass through mmap, the stdio pipeline below is the fallback */
+	    if ( encode_image_mmap( encInfo ) == e_success )
+	    {
+		printf ("Encoded stego image in place through mmap\n");
+		return e_success ;
+	    }
+
 	    /* Function call for copying bmp header function and checking condition whether success or not */
-	    if ( copy_bmp_header( encInfo->fptr_src_image, encInfo->fptr_stego_image ) == e_success )
+	    if ( copy_bmp_header( encInfo->fptr_src_image, encInfo->fptr_stego_image , encInfo->bmp.data_offset ) == e_success )
 	    {
 
 		printf ("Copied bmp header successfully \n");
@@ -96,11 +159,8 @@ Status do_encoding ( EncodeInfo *encInfo )
 
 		    printf ( "Encoded magic string \n");
 
-		    /* Copying secret file extention */
-		    strcpy ( encInfo->extn_secret_file , strstr(encInfo->secret_fname , "." ) );
-
 		    /* Function call for encode secret file extention size  and checking condition whether success or not */
-		    if ( encode_secret_file_extn_size ( strlen (encInfo->extn_secret_file), encInfo->fptr_src_image , encInfo->fptr_stego_image)  == e_success )
+		    if ( encode_secret_file_extn_size ( strlen (encInfo->extn_secret_file), encInfo )  == e_success )
 		    {
 			printf ("Encoded secret file extn size \n");
 
@@ -183,25 +243,24 @@ Status do_encoding ( EncodeInfo *encInfo )
     return e_success ;
 }
 
-uint get_image_size_for_bmp(FILE *fptr_image)
+long get_image_size_for_bmp(FILE *fptr_image, BmpInfo *bmp)
 {
-    uint width, height;
-    /* Seek to 18th byte */
-    fseek(fptr_image, 18, SEEK_SET);
-    /* Read the width (an int) */
-    fread(&width, sizeof(int), 1, fptr_image);
-    printf("width = %u\n", width);
-    /*Read the height (an int) next 4 bytes from width */
-    fread(&height, sizeof(int), 1, fptr_image);
-    printf("height = %u\n", height);
-    /* Return image capacity */
-    return width * height * 3;
+    /* Parse file and DIB headers, pixel data offset and row layout */
+    if ( bmp_read_info( fptr_image , bmp ) != e_success )
+    {
+	return 0;
+    }
+    printf("width = %d\n", bmp->width);
+    printf("height = %d%s\n", bmp->height, bmp->top_down ? " (top-down)" : "");
+    printf("bits per pixel = %u, pixel data at %u\n", bmp->bits_per_pixel, bmp->data_offset);
+    /* Return image capacity, pixel bytes without row padding */
+    return bmp_pixel_bytes( bmp );
 }
 
 Status open_files(EncodeInfo *encInfo)
 {
     /* Src Image file */
-    encInfo->fptr_src_image = fopen(encInfo->src_image_fname, "r"); 
+    encInfo->fptr_src_image = fopen(encInfo->src_image_fname, "rb"); 
     /* Do Error handling */
     if (encInfo->fptr_src_image == NULL)
     {
@@ -209,7 +268,7 @@ Status open_files(EncodeInfo *encInfo)
 	return e_failure;
     }
     /* Secret file */
-    encInfo->fptr_secret = fopen(encInfo->secret_fname, "r");
+    encInfo->fptr_secret = fopen(encInfo->secret_fname, "rb");
     /* Do Error handling */
     if (encInfo->fptr_secret == NULL)
     {
@@ -218,7 +277,7 @@ Status open_files(EncodeInfo *encInfo)
 	return e_failure;
     }
     /* Stego Image file */
-    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "w");
+    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "w+b");
     /* Do Error handling */
     if (encInfo->fptr_stego_image == NULL)
     {
@@ -234,127 +293,314 @@ Status open_files(EncodeInfo *encInfo)
 Status check_capacity(EncodeInfo *encInfo)
 {
     /* Function call for get image size for bmp and storing return value */
-    encInfo->image_capacity =  get_image_size_for_bmp( encInfo->fptr_src_image );
+    encInfo->image_capacity =  get_image_size_for_bmp( encInfo->fptr_src_image , &encInfo->bmp );
+    encInfo->bits_per_pixel = encInfo->bmp.bits_per_pixel ;
+    encInfo->pixel_pos = 0 ;
 
-    /* Calling function get file size and stroing return value */
-    encInfo->size_secret_file = get_file_size( encInfo->fptr_secret );
+    /* Calling function get file size and stroing return value, a part of a split payload comes with its own size */
+    if ( !( encInfo->format_flags & FORMAT_FLAG_PART ) )
+    {
+	encInfo->size_secret_file = get_file_size( encInfo->fptr_secret );
+    }
 
-    /* Checking whether beautiful.bmp image file size is greater than secret file or not */
-    if ( encInfo->image_capacity > ( (2 + 4 + 4 + 4 + encInfo->size_secret_file ) * 8 ) )
+    /* Copying secret file extention */
+    if ( get_secret_file_extn( encInfo->secret_fname , encInfo->extn_secret_file ) != e_success )
     {
-	return e_success;
+	return e_failure ;
     }
-    else
+    char *extn = encInfo->extn_secret_file ;
+
+    /* The size field holds 32 bits */
+    if ( encInfo->size_secret_file > 0xFFFFFFFFL )
+    {
+	return e_failure ;
+    }
+
+    /* Planning the fewest LSBs per image byte that fit, magic string and extn size word take one bit each */
+    int low = encInfo->lsb_bits ? encInfo->lsb_bits : 1 , high = encInfo->lsb_bits ? encInfo->lsb_bits : MAX_LSB_BITS ;
+    for ( int bits = low ; bits <= high ; bits++ )
     {
-	e_failure ;
+	long header = ( 2 + 4 ) * 8 + lsb_image_bytes( strlen( extn ) , bits ) + lsb_image_bytes( 4 , bits ) + lsb_image_bytes( encInfo->data_header_size , bits ) ;
+	long need = header + lsb_image_bytes( encInfo->size_secret_file , bits ) ;
+	/* Scattered data has to fit an equal share into every region after the header */
+	if ( encInfo->format_flags & FORMAT_FLAG_SCATTER )
+	{
+	    if ( header <= encInfo->image_capacity &&
+		    scatter_plan( &encInfo->scatter , encInfo->scatter_key , header , encInfo->image_capacity - header , encInfo->size_secret_file , bits ) == e_success )
+	    {
+		encInfo->lsb_bits = bits ;
+		printf ("Embedding %d bit%s per image byte, scattered over %ld regions of %ld image bytes\n", bits , bits > 1 ? "s" : "" , encInfo->scatter.regions , encInfo->scatter.region_size );
+		return e_success;
+	    }
+	}
+	else if ( encInfo->image_capacity >= need )
+	{
+	    encInfo->lsb_bits = bits ;
+	    printf ("Embedding %d bit%s per image byte, %ld of %ld image bytes\n", bits , bits > 1 ? "s" : "" , need , encInfo->image_capacity );
+	    return e_success;
+	}
     }
+    return e_failure ;
 }
 
 /* Function definition for get file size */
-uint get_file_size( FILE *fptr )
+long get_file_size( FILE *fptr )
 {
     /* Seek file pointer to 0 */
     fseek(fptr , 0 , SEEK_END ); 
     return ftell(fptr);
 }
 
+/* Function definition for compressing the secret file into a temporary file */
+Status compress_secret_file( EncodeInfo *encInfo )
+{
+    long size , original = get_file_size( encInfo->fptr_secret ) ;
+    FILE *fptr = tmpfile() ;
+    if ( fptr == NULL || lz_compress_file( encInfo->fptr_secret , fptr , &size ) != e_success || fflush( fptr ) != 0 )
+    {
+	if ( fptr != NULL )
+	{
+	    fclose( fptr );
+	}
+	return e_failure ;
+    }
+    /* Nothing gained, the secret goes in as it is and without the flag */
+    if ( size >= original )
+    {
+	printf ("Secret file does not compress, embedding it as it is\n");
+	fclose( fptr );
+	encInfo->format_flags &= ~FORMAT_FLAG_LZ ;
+	return e_success ;
+    }
+    printf ("Compressed secret file from %ld to %ld bytes\n", original , size );
+    fclose( encInfo->fptr_secret );
+    encInfo->fptr_secret = fptr ;
+    return e_success ;
+}
+
+/* Function definition for get secret file extension, empty when the name has none */
+Status get_secret_file_extn( const char *fname , char *extn )
+{
+    /* Dots in directories do not count */
+    const char *name = strrchr( fname , '/' );
+    const char *dot = strchr( name != NULL ? name : fname , '.' );
+    if ( dot == NULL )
+    {
+	dot = "" ;
+    }
+    if ( strlen( dot ) > MAX_FILE_SUFFIX )
+    {
+	printf ("Secret file extn is longer than %d characters\n", MAX_FILE_SUFFIX );
+	return e_failure ;
+    }
+    strcpy ( extn , dot );
+    return e_success ;
+}
+
 /* Function definition for copying bmp file header to stego_image.bmp file */
-Status copy_bmp_header( FILE *fptr_src_image , FILE *fptr_dest_image )
+Status copy_bmp_header( FILE *fptr_src_image , FILE *fptr_dest_image , uint header_size )
 {
-    char ptr[54] ;
+    char ptr[1024] ;
     /* Seek file pointer to 0 */
     fseek(fptr_src_image, 0 ,SEEK_SET);
-    /* Readin 54 bytes of src image to an array */
-    fread(ptr , 54 , 1 , fptr_src_image);
-    /* writing  54 bytes from array to destination i.e , stego file */
-    fwrite(ptr , 54 , 1 , fptr_dest_image);
+    /* Copy everything before the pixel data, headers, color masks and palette */
+    while ( header_size > 0 )
+    {
+	uint count = header_size < sizeof(ptr) ? header_size : sizeof(ptr) ;
+	if ( fread(ptr , 1 , count , fptr_src_image) != count || fwrite(ptr , 1 , count , fptr_dest_image) != count )
+	{
+	    return e_failure ;
+	}
+	header_size -= count ;
+    }
     return e_success;
 }
 
 /* Function definition for encoding magic string to output image file */
 Status encode_magic_string( const char  *magic_string, EncodeInfo *encInfo )
 {
-    encode_data_to_image(magic_string , 2 , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo );
-    return e_success ;
+    /* Magic string is always one bit per image byte, so the decoder finds it before it knows anything else */
+    int bits = encInfo->lsb_bits ;
+    encInfo->lsb_bits = 1 ;
+    Status status = encode_data_to_image(magic_string , strlen( magic_string ) , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo );
+    encInfo->lsb_bits = bits ;
+    return status ;
 }
 
 /* Function definition for encoding data to output image file */
 Status encode_data_to_image( const char *data , int size , FILE *fptr_src_image , FILE *fptr_stego_image , EncodeInfo *encInfo )
 {
-    for ( int i = 0 ; i < size ; i++ )
+    BmpInfo *bmp = &encInfo->bmp ;
+    int bits = encInfo->lsb_bits ;
+    /* Chunks are whole groups of bits bytes, those fill whole image bytes, so the bit stream runs on across chunks */
+    int step = MAX_SECRET_BUF_SIZE / bits * bits ;
+    /* Whole chunks of image data go through the bulk kernel instead of 8 bytes per secret byte */
+    for ( int i = 0 , chunk ; i < size ; i += chunk )
     {
-	fread(encInfo->image_data , 8 , 1 , fptr_src_image );
-	encode_byte_to_lsb(data[i] , encInfo->image_data );
-	fwrite (encInfo->image_data , 8 , 1 , fptr_stego_image );
+	chunk = size - i < step ? size - i : step ;
+	/* File window from the end of the last pixel byte used, row padding makes it longer than its pixel bytes */
+	long first = encInfo->pixel_pos , start = bmp_pixel_end( bmp , first ) ;
+	while ( bmp_pixel_offset( bmp , first + lsb_image_bytes( chunk , bits ) - 1 ) + 1 - start > MAX_IMAGE_BUF_SIZE )
+	{
+	    chunk = chunk / 2 / bits * bits ;
+	}
+	long pixels = lsb_image_bytes( chunk , bits ) ;
+	long span = bmp_pixel_offset( bmp , first + pixels - 1 ) + 1 - start ;
+	/* Without padding the window is the pixel bytes themselves */
+	char *raw = span == pixels ? encInfo->image_data : encInfo->image_raw ;
+	if ( fread(raw , 1 , span , fptr_src_image ) != (size_t)span )
+	{
+	    return e_failure ;
+	}
+	if ( raw != encInfo->image_data )
+	{
+	    bmp_gather( bmp , first , raw + bmp_pixel_offset( bmp , first ) - start , encInfo->image_data , pixels );
+	}
+	lsb_embed_bits( encInfo->image_data , data + i , chunk , bits );
+	if ( raw != encInfo->image_data )
+	{
+	    bmp_scatter( bmp , first , raw + bmp_pixel_offset( bmp , first ) - start , encInfo->image_data , pixels );
+	}
+	if ( fwrite (raw , 1 , span , fptr_stego_image ) != (size_t)span )
+	{
+	    return e_failure ;
+	}
+	encInfo->pixel_pos += pixels ;
     }
+    return e_success ;
 }
 
 /* Function definition for encoding each byte of magic string to lsb */
 Status encode_byte_to_lsb( char data , char *image_buffer )
 {
-    unsigned int mask = 0x80 , i ;
-    for ( i = 0 ; i < 8 ; i++ )
-    {
-	image_buffer[i]  = (image_buffer[i] & 0xFE ) | ( ( data & mask ) >> ( 7 - i ) );
-	mask = mask >> 1 ;
-    }
+    lsb_embed( image_buffer , &data , 1 );
+    return e_success ;
 }
 
 /* Function definition for encoding secret file extension size output image file */
-Status encode_secret_file_extn_size( int size , FILE *fptr_src_image , FILE *fptr_stego_image )
+Status encode_secret_file_extn_size( int size , EncodeInfo *encInfo )
 {
-    char str[32] ;
-    fread(str , 32 , 1 , fptr_src_image );
-    encode_size_to_lsb ( size , str );
-    fwrite(str , 32 ,1 , fptr_stego_image );
-    return e_success;
+    /* Format word at one bit per image byte, it tells the decoder how many bits the rest uses */
+    int bits = encInfo->lsb_bits ;
+    uint word = size | ( bits - 1 ) << FORMAT_BITS_SHIFT | encInfo->format_flags << FORMAT_FLAGS_SHIFT ;
+    /* Most significant byte first */
+    char bytes[4] = { word >> 24 , word >> 16 , word >> 8 , word } ;
+    encInfo->lsb_bits = 1 ;
+    Status status = encode_data_to_image( bytes , 4 , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo );
+    encInfo->lsb_bits = bits ;
+    return status ;
 }
 
 /* Function definition for encoding size to output image file */
 Status encode_size_to_lsb( int size , char *image_buffer )
 {
-    unsigned int mask = 1 << 31 , i ;
-    for ( i = 0 ; i < 32 ; i++ )
-    {
-	image_buffer[i]  = (image_buffer[i] & 0xFE ) | ( ( size & mask ) >> ( 31 - i ) );
-	mask = mask >> 1 ;
-    }
+    /* Most significant byte first, same bit order as the 32 single bits */
+    char bytes[4] = { size >> 24 , size >> 16 , size >> 8 , size } ;
+    lsb_embed( image_buffer , bytes , 4 );
+    return e_success ;
 }
 
 /* Function definition for encoding secret  file extention to output image file */
 Status encode_secret_file_extn( char *file_extn , EncodeInfo *encInfo )
 {
-    encode_data_to_image (file_extn , strlen(file_extn) , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo);
-    return e_success ;
+    return encode_data_to_image (file_extn , strlen(file_extn) , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo);
 }
 
 /* Function definition for encoding secret file size */
-Status encode_secret_file_size( int size , EncodeInfo *encInfo )
+Status encode_secret_file_size( uint size , EncodeInfo *encInfo )
 {
-    char str[32] ;
-    fread(str , 32 , 1 , encInfo->fptr_src_image );
-    encode_size_to_lsb( size , str );
-    fwrite(str , 32 ,1 , encInfo->fptr_stego_image );
-    return e_success;
+    /* Most significant byte first */
+    char bytes[4] = { size >> 24 , size >> 16 , size >> 8 , size } ;
+    return encode_data_to_image( bytes , 4 , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo );
 }
 
 /* Function definition for encoding secret file data to output image file */
 Status encode_secret_file_data( EncodeInfo *encInfo )
 {
-    fseek ( encInfo->fptr_secret , 0 , SEEK_SET );
-    char str[encInfo->size_secret_file ];
-    fread ( str , encInfo->size_secret_file , 1 , encInfo->fptr_secret );
-    encode_data_to_image(str , strlen(str) , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo );
+    long remaining = encInfo->size_secret_file ;
+    /* Whole groups of lsb_bits bytes, so the chunks continue one bit stream */
+    int step = MAX_SECRET_BUF_SIZE / encInfo->lsb_bits * encInfo->lsb_bits ;
+    /* A part of a split payload has its header right before its data */
+    if ( encode_data_to_image( encInfo->data_header , encInfo->data_header_size , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo ) != e_success )
+    {
+	return e_failure ;
+    }
+    if ( encInfo->format_flags & FORMAT_FLAG_SCATTER )
+    {
+	return encode_scattered_data( encInfo );
+    }
+    fseek ( encInfo->fptr_secret , encInfo->secret_offset , SEEK_SET );
+    /* Secret goes in chunks of secret_data into the matching window of image data, any size and any bytes */
+    while ( remaining > 0 )
+    {
+	int chunk = remaining < step ? remaining : step ;
+	if ( fread ( encInfo->secret_data , 1 , chunk , encInfo->fptr_secret ) != (size_t)chunk )
+	{
+	    return e_failure ;
+	}
+	if ( encode_data_to_image( encInfo->secret_data , chunk , encInfo->fptr_src_image , encInfo->fptr_stego_image , encInfo ) != e_success )
+	{
+	    return e_failure ;
+	}
+	remaining -= chunk ;
+    }
+    return e_success ;
+}
+
+/* Function definition for encoding secret file data scattered over the regions */
+Status encode_scattered_data( EncodeInfo *encInfo )
+{
+    BmpInfo *bmp = &encInfo->bmp ;
+    Scatter *scatter = &encInfo->scatter ;
+    long size = scatter->region_size ;
+    /* Regions in file order, each reads the share of the secret it holds */
+    for ( long region = 0 ; region < scatter->regions ; region++ )
+    {
+	long first = scatter->base + region * size , start = bmp_pixel_end( bmp , first ) , offset , count ;
+	long span = bmp_pixel_offset( bmp , first + size - 1 ) + 1 - start ;
+	char *raw = span == size ? encInfo->image_data : encInfo->image_raw ;
+	if ( span > MAX_IMAGE_BUF_SIZE || fread( raw , 1 , span , encInfo->fptr_src_image ) != (size_t)span )
+	{
+	    return e_failure ;
+	}
+	scatter_data_range( scatter , region , &offset , &count );
+	if ( count > 0 )
+	{
+	    if ( fseek ( encInfo->fptr_secret , encInfo->secret_offset + offset , SEEK_SET ) != 0 ||
+		    fread ( encInfo->secret_data , 1 , count , encInfo->fptr_secret ) != (size_t)count )
+	    {
+		return e_failure ;
+	    }
+	    if ( raw != encInfo->image_data )
+	    {
+		bmp_gather( bmp , first , raw + bmp_pixel_offset( bmp , first ) - start , encInfo->image_data , size );
+	    }
+	    scatter_embed( scatter , region , encInfo->image_data , encInfo->secret_data );
+	    if ( raw != encInfo->image_data )
+	    {
+		bmp_scatter( bmp , first , raw + bmp_pixel_offset( bmp , first ) - start , encInfo->image_data , size );
+	    }
+	}
+	if ( fwrite ( raw , 1 , span , encInfo->fptr_stego_image ) != (size_t)span )
+	{
+	    return e_failure ;
+	}
+    }
+    encInfo->pixel_pos = scatter->base + scatter->regions * size ;
     return e_success ;
 }
 
 /* Function definition for copying remaining data of beautiful.bmp file to output image file */
 Status copy_remaining_img_data( FILE *fptr_src , FILE *fptr_dest )
 {
-    char ch ;
-    while ( ( fread ( &ch , 1 , 1 , fptr_src)) > 0 )
+    char buffer[MAX_IMAGE_BUF_SIZE] ;
+    size_t count ;
+    while ( ( count = fread ( buffer , 1 , sizeof(buffer) , fptr_src ) ) > 0 )
     {
-	fwrite ( &ch , 1 , 1 , fptr_dest );
+	if ( fwrite ( buffer , 1 , count , fptr_dest ) != count )
+	{
+	    return e_failure ;
+	}
     }
     return e_success ;
 } 
@@ -2,6 +2,9 @@
 #define ENCODE_H
 
 #include "types.h" // Contains user defined types
+#include "common.h"
+#include "bmp.h"
+#include "scatter.h"
 
 /* 
  * Structure to store information required for
@@ -10,7 +13,7 @@
  * also stored
  */
 
-#define MAX_SECRET_BUF_SIZE 1
+#define MAX_SECRET_BUF_SIZE 8192
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 4
 
@@ -19,16 +22,31 @@ typedef struct _EncodeInfo
     /* Source Image info */
     char *src_image_fname;
     FILE *fptr_src_image;
-    uint image_capacity;
+    long image_capacity;
     uint bits_per_pixel;
+    int lsb_bits;
+    BmpInfo bmp;
+    long pixel_pos;
     char image_data[MAX_IMAGE_BUF_SIZE];
+    char image_raw[MAX_IMAGE_BUF_SIZE];
 
     /* Secret File Info */
     char *secret_fname;
     FILE *fptr_secret;
-    char extn_secret_file[MAX_FILE_SUFFIX];
+    char extn_secret_file[MAX_FILE_SUFFIX + 1];
     char secret_data[MAX_SECRET_BUF_SIZE];
     long size_secret_file;
+    long secret_offset;		// First secret byte in this image
+
+    /* Format flags, zero for a whole payload in sequence */
+    uint format_flags;
+    /* Between size field and data: part header of a split, key check of scattered data */
+    char data_header[PART_HEADER_SIZE];
+    int data_header_size;
+
+    /* Keyed scattering of the data */
+    char *scatter_key;
+    Scatter scatter;
 
     /* Stego Image Info */
     char *stego_image_fname;
@@ -54,29 +72,38 @@ Status open_files(EncodeInfo *encInfo);
 Status check_capacity(EncodeInfo *encInfo);
 
 /* Get image size */
-uint get_image_size_for_bmp(FILE *fptr_image);
+long get_image_size_for_bmp(FILE *fptr_image, BmpInfo *bmp);
 
 /* Get file size */
-uint get_file_size(FILE *fptr);
+long get_file_size(FILE *fptr);
+
+/* Compress the secret file, the compressed copy replaces fptr_secret */
+Status compress_secret_file(EncodeInfo *encInfo);
+
+/* Get secret file extension */
+Status get_secret_file_extn(const char *fname, char *extn);
 
 /* Copy bmp image header */
-Status copy_bmp_header(FILE *fptr_src_image, FILE *fptr_dest_image);
+Status copy_bmp_header(FILE *fptr_src_image, FILE *fptr_dest_image, uint header_size);
 
 /* Store Magic String */
 Status encode_magic_string(const char *magic_string, EncodeInfo *encInfo);
 
 /* Encode secret file extenstion size */
-Status encode_secret_file_extn_size( int size , FILE *fptr_src_image , FILE *fptr_stego_image );
+Status encode_secret_file_extn_size( int size , EncodeInfo *encInfo );
 
 /* Encode secret file extenstion */
 Status encode_secret_file_extn( char *file_extn, EncodeInfo *encInfo);
 
 /* Encode secret file size */
-Status encode_secret_file_size(int file_size, EncodeInfo *encInfo);
+Status encode_secret_file_size(uint file_size, EncodeInfo *encInfo);
 
 /* Encode secret file data*/
 Status encode_secret_file_data(EncodeInfo *encInfo);
 
+/* Encode secret file data scattered over the regions after the header */
+Status encode_scattered_data(EncodeInfo *encInfo);
+
 /* Encode function, which does the real encoding */
 Status encode_data_to_image( const char *data, int size, FILE *fptr_src_image, FILE *fptr_stego_image, EncodeInfo *encInfo);
 
@@ -89,4 +116,7 @@ Status encode_size_to_lsb( int size , char *image_buffer );
 /* Copy remaining image bytes from src to stego image after encoding */
 Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest);
 
+/* Encode the whole stego image in place through mmap */
+Status encode_image_mmap(EncodeInfo *encInfo);
+
 #endif
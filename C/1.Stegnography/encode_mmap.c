@@ -0,0 +1,218 @@
+/* Header file */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+#include "encode.h"
+#include "common.h"
+#include "lsb.h"
+
+/* Function Definitions */
+/* Memory mapped encoding
+ * Input: Opened files, capacity already checked
+ * Output: Stego image written in a single pass
+ * Description: The stego image is the source image with only the LSBs of
+ * the payload region changed. So the whole file is first cloned into the
+ * output (a reflink shares the blocks, copy_file_range copies in the kernel,
+ * else it is written straight from the mapped source), then just the pages
+ * of the payload region are mapped and embedded in place. Time and memory
+ * follow the payload, not the image
+ */
+
+#define COPY_CHUNK (1 << 20)
+
+/* Function definition for cloning src into dest */
+static Status clone_image( int src , int dest , off_t size )
+{
+#ifdef FICLONE
+    /* Shares the data blocks on btrfs, xfs and friends */
+    if ( ioctl( dest , FICLONE , src ) == 0 )
+    {
+	printf ("Cloned source image with a reflink\n");
+	return e_success ;
+    }
+#endif
+    off_t done = 0 ;
+#ifdef __linux__
+    /* Copy inside the kernel, no user space buffer */
+    off64_t in = 0 , out = 0 ;
+    ssize_t count ;
+    while ( done < size && ( count = copy_file_range( src , &in , dest , &out , size - done , 0 ) ) > 0 )
+    {
+	done += count ;
+    }
+    if ( done == size )
+    {
+	printf ("Copied source image with copy_file_range\n");
+	return e_success ;
+    }
+#endif
+    /* Write the rest from the mapped source */
+    char *map = mmap( NULL , size , PROT_READ , MAP_PRIVATE , src , 0 );
+    if ( map == MAP_FAILED )
+    {
+	return e_failure ;
+    }
+    madvise( map , size , MADV_SEQUENTIAL );
+    while ( done < size )
+    {
+	ssize_t count = pwrite( dest , map + done , size - done < COPY_CHUNK ? size - done : COPY_CHUNK , done );
+	if ( count <= 0 )
+	{
+	    munmap( map , size );
+	    return e_failure ;
+	}
+	done += count ;
+    }
+    munmap( map , size );
+    printf ("Copied source image from its mapping\n");
+    return e_success ;
+}
+
+/* Function definition for dropping a half written stego image, the stdio encoder starts over on the same file */
+static void discard_image( int dest )
+{
+    if ( ftruncate( dest , 0 ) != 0 )
+    {
+	perror( "ftruncate" );
+    }
+}
+
+/* Function definition for embedding a field at pixel byte *pos of the mapped image, bits LSBs per byte */
+static void embed_mapped( EncodeInfo *encInfo , char *image , const char *data , long size , int bits , long *pos )
+{
+    BmpInfo *bmp = &encInfo->bmp ;
+    if ( bmp->stride == bmp->row_bytes )
+    {
+	lsb_embed_bits( image + bmp_pixel_offset( bmp , *pos ) , data , size , bits );
+	*pos += lsb_image_bytes( size , bits ) ;
+	return ;
+    }
+    /* Padded rows go through the image buffer a chunk of whole groups at a time */
+    long step = MAX_SECRET_BUF_SIZE / bits * bits ;
+    for ( long i = 0 , chunk ; i < size ; i += chunk )
+    {
+	chunk = size - i < step ? size - i : step ;
+	long pixels = lsb_image_bytes( chunk , bits ) ;
+	char *raw = image + bmp_pixel_offset( bmp , *pos ) ;
+	bmp_gather( bmp , *pos , raw , encInfo->image_data , pixels );
+	lsb_embed_bits( encInfo->image_data , data + i , chunk , bits );
+	bmp_scatter( bmp , *pos , raw , encInfo->image_data , pixels );
+	*pos += pixels ;
+    }
+}
+
+/* Function definition for embedding data scattered over the regions of the mapped image */
+static void scatter_mapped( EncodeInfo *encInfo , char *image , const char *data )
+{
+    BmpInfo *bmp = &encInfo->bmp ;
+    Scatter *scatter = &encInfo->scatter ;
+    long size = scatter->region_size , offset , count ;
+    for ( long region = 0 ; region < scatter->regions ; region++ )
+    {
+	long first = scatter->base + region * size ;
+	char *raw = image + bmp_pixel_offset( bmp , first ) ;
+	scatter_data_range( scatter , region , &offset , &count );
+	if ( count == 0 )
+	{
+	    continue ;
+	}
+	/* Without padding a region is its own pixel bytes */
+	if ( bmp->stride == bmp->row_bytes )
+	{
+	    scatter_embed( scatter , region , raw , data + offset );
+	    continue ;
+	}
+	bmp_gather( bmp , first , raw , encInfo->image_data , size );
+	scatter_embed( scatter , region , encInfo->image_data , data + offset );
+	bmp_scatter( bmp , first , raw , encInfo->image_data , size );
+    }
+}
+
+/* Function definition for encoding the whole stego image through mmap */
+Status encode_image_mmap( EncodeInfo *encInfo )
+{
+    int src = fileno( encInfo->fptr_src_image ) ;
+    int dest = fileno( encInfo->fptr_stego_image ) ;
+    int secret = fileno( encInfo->fptr_secret ) ;
+    struct stat st ;
+    char *extn = encInfo->extn_secret_file ;
+    int extn_size = strlen( extn ) ;
+    long secret_size = encInfo->size_secret_file , pos = 0 ;
+    int bits = encInfo->lsb_bits ;
+
+    if ( fstat( src , &st ) != 0 || !S_ISREG( st.st_mode ) )
+    {
+	return e_failure ;
+    }
+
+    /* Magic string and format word at one bit, then extension and file size at bits, the same fields as the stdio encoder */
+    char head[2 + 4] , size[4] ;
+    uint word = extn_size | ( bits - 1 ) << FORMAT_BITS_SHIFT | encInfo->format_flags << FORMAT_FLAGS_SHIFT ;
+    memcpy ( head , MAGIC_STRING , 2 );
+    for ( int i = 0 ; i < 4 ; i++ )
+    {
+	head[2 + i] = word >> ( 24 - 8 * i ) ;
+	size[i] = secret_size >> ( 24 - 8 * i ) ;
+    }
+
+    /* Capacity was checked against the pixel bytes, so the last one used is inside the file */
+    long pixels = sizeof(head) * 8 + lsb_image_bytes( extn_size , bits ) + lsb_image_bytes( 4 , bits ) +
+	lsb_image_bytes( encInfo->data_header_size , bits ) + lsb_image_bytes( secret_size , bits ) ;
+    /* Scattered data reaches to the end of the last region */
+    if ( encInfo->format_flags & FORMAT_FLAG_SCATTER )
+    {
+	pixels = encInfo->scatter.base + encInfo->scatter.regions * encInfo->scatter.region_size ;
+    }
+    off_t end = bmp_pixel_offset( &encInfo->bmp , pixels - 1 ) + 1 ;
+
+    if ( clone_image( src , dest , st.st_size ) != e_success )
+    {
+	discard_image( dest );
+	return e_failure ;
+    }
+
+    /* Only the pages up to the end of the payload are mapped */
+    char *image = mmap( NULL , end , PROT_READ | PROT_WRITE , MAP_SHARED , dest , 0 );
+    if ( image == MAP_FAILED )
+    {
+	discard_image( dest );
+	return e_failure ;
+    }
+    embed_mapped( encInfo , image , head , sizeof(head) , 1 , &pos );
+    embed_mapped( encInfo , image , extn , extn_size , bits , &pos );
+    embed_mapped( encInfo , image , size , 4 , bits , &pos );
+    embed_mapped( encInfo , image , encInfo->data_header , encInfo->data_header_size , bits , &pos );
+
+    if ( secret_size > 0 )
+    {
+	/* Mappings start on a page, a part of a split payload may not */
+	off_t base = encInfo->secret_offset / sysconf( _SC_PAGESIZE ) * sysconf( _SC_PAGESIZE ) ;
+	long skip = encInfo->secret_offset - base ;
+	char *data = mmap( NULL , secret_size + skip , PROT_READ , MAP_PRIVATE , secret , base );
+	if ( data == MAP_FAILED )
+	{
+	    munmap( image , end );
+	    discard_image( dest );
+	    return e_failure ;
+	}
+	madvise( data , secret_size + skip , MADV_SEQUENTIAL );
+	if ( encInfo->format_flags & FORMAT_FLAG_SCATTER )
+	{
+	    scatter_mapped( encInfo , image , data + skip );
+	}
+	else
+	{
+	    embed_mapped( encInfo , image , data + skip , secret_size , bits , &pos );
+	}
+	munmap( data , secret_size + skip );
+    }
+    munmap( image , end );
+    return e_success ;
+}
@@ -0,0 +1,386 @@
+/* Header file */
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "lsb.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define LSB_X86
+#endif
+
+/* Function Definitions */
+/* Bulk LSB embedding
+ * Input: Image buffer of size * 8 bytes, data of size bytes
+ * Output: LSB of image byte 8 * i + j holds bit (7 - j) of data[i]
+ * Description: Instead of a shift and mask per bit, every data byte is spread
+ * over a whole word of image bytes at once. AVX2 does 8 data bytes per step,
+ * SSE2 does 2 and the portable version 1 per 64 bit word. The AVX2 path is
+ * picked at run time, once for all threads, so a plain build still uses it
+ * where available
+ */
+
+/* Bulk LSB extraction
+ * Input: Image buffer of size * 8 bytes
+ * Output: size bytes of data, the reverse of lsb_embed
+ * Description: The LSBs of a block are moved to the sign bit of each byte and
+ * collected by movemask, 32 image bytes per step with AVX2 and 16 with SSE2.
+ * The portable version packs a word of LSBs with one multiply
+ */
+
+/* Multi bit embedding and extraction
+ * Input: Image buffer of lsb_image_bytes( size , bits ) bytes, bits of 1 to 4
+ * Output: Data as one bit stream over the low bits of the image bytes, first
+ * bit highest. When the stream ends inside an image byte its lower bits stay
+ * Description: bits data bytes fill exactly 8 image bytes. The portable
+ * version splits such a group down a 64 bit word in three halving steps. The
+ * AVX2 version builds a 16 bit window around every group with one shuffle,
+ * shifts all of them at once by a multiply and packs 16 image bytes per step.
+ * Extraction runs the halving steps backwards, as multiply-adds with AVX2
+ */
+
+/* Image byte j of a word keeps bit (7 - j) of the data byte */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LSB_BIT_SELECT 0x8040201008040201ULL
+#else
+#define LSB_BIT_SELECT 0x0102040810204080ULL
+#endif
+#define LSB_ONES 0x0101010101010101ULL
+
+/* Moves the LSB of image byte j to bit (63 - j), the top byte is then the data byte */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define LSB_GATHER 0x0102040810204080ULL
+#else
+#define LSB_GATHER 0x8040201008040201ULL
+#endif
+
+/* Function definition for spreading one data byte over the LSBs of a word */
+static inline uint64_t lsb_spread( unsigned char data )
+{
+    /* Copy byte to every lane, keep one bit per lane, turn non zero lanes into 1 */
+    uint64_t bits = ( data * LSB_ONES ) & LSB_BIT_SELECT ;
+    return ( ( bits + 0x7F * LSB_ONES ) >> 7 ) & LSB_ONES ;
+}
+
+/* Function definition for portable embedding, one data byte per word */
+static void lsb_embed_word( char *image_buffer , const char *data , long size )
+{
+    uint64_t word ;
+    for ( long i = 0 ; i < size ; i++ )
+    {
+	memcpy ( &word , image_buffer + 8 * i , 8 );
+	word = ( word & ~LSB_ONES ) | lsb_spread( data[i] );
+	memcpy ( image_buffer + 8 * i , &word , 8 );
+    }
+}
+
+/* Function definition for portable extraction, one data byte per word */
+static void lsb_extract_word( char *data , const char *image_buffer , long size )
+{
+    uint64_t word ;
+    for ( long i = 0 ; i < size ; i++ )
+    {
+	memcpy ( &word , image_buffer + 8 * i , 8 );
+	data[i] = ( ( word & LSB_ONES ) * LSB_GATHER ) >> 56 ;
+    }
+}
+
+#ifdef LSB_X86
+/* Function definition for SSE2 embedding, 2 data bytes per 16 image bytes */
+static void lsb_embed_sse2( char *image_buffer , const char *data , long size )
+{
+    const __m128i select = _mm_set1_epi64x( 0x0102040810204080LL );
+    const __m128i one = _mm_set1_epi8( 1 );
+    long i = 0 ;
+    for ( ; i + 2 <= size ; i += 2 )
+    {
+	uint16_t pair ;
+	memcpy ( &pair , data + i , 2 );
+	/* b0 b1 -> b0 x 8, b1 x 8 */
+	__m128i spread = _mm_cvtsi32_si128( pair );
+	spread = _mm_unpacklo_epi8( spread , spread );
+	spread = _mm_unpacklo_epi16( spread , spread );
+	spread = _mm_unpacklo_epi32( spread , spread );
+	__m128i bits = _mm_and_si128( _mm_cmpeq_epi8( _mm_and_si128( spread , select ) , select ) , one );
+	__m128i image = _mm_loadu_si128( (const __m128i *)( image_buffer + 8 * i ) );
+	image = _mm_or_si128( _mm_andnot_si128( one , image ) , bits );
+	_mm_storeu_si128( (__m128i *)( image_buffer + 8 * i ) , image );
+    }
+    lsb_embed_word( image_buffer + 8 * i , data + i , size - i );
+}
+
+/* Function definition for AVX2 embedding, 8 data bytes per 64 image bytes */
+__attribute__((target("avx2")))
+static void lsb_embed_avx2( char *image_buffer , const char *data , long size )
+{
+    const __m256i select = _mm256_set1_epi64x( 0x0102040810204080LL );
+    const __m256i one = _mm256_set1_epi8( 1 );
+    /* Every 128 bit lane holds all 8 data bytes, each picks two of them */
+    const __m256i index_low = _mm256_setr_epi8( 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+	    2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 );
+    const __m256i index_high = _mm256_setr_epi8( 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 5, 5, 5,
+	    6, 6, 6, 6, 6, 6, 6, 6, 7, 7, 7, 7, 7, 7, 7, 7 );
+    long i = 0 ;
+    for ( ; i + 8 <= size ; i += 8 )
+    {
+	uint64_t octet ;
+	memcpy ( &octet , data + i , 8 );
+	__m256i broadcast = _mm256_set1_epi64x( octet );
+	__m256i spread_low = _mm256_shuffle_epi8( broadcast , index_low );
+	__m256i spread_high = _mm256_shuffle_epi8( broadcast , index_high );
+	__m256i bits_low = _mm256_and_si256( _mm256_cmpeq_epi8( _mm256_and_si256( spread_low , select ) , select ) , one );
+	__m256i bits_high = _mm256_and_si256( _mm256_cmpeq_epi8( _mm256_and_si256( spread_high , select ) , select ) , one );
+	__m256i image_low = _mm256_loadu_si256( (const __m256i *)( image_buffer + 8 * i ) );
+	__m256i image_high = _mm256_loadu_si256( (const __m256i *)( image_buffer + 8 * i + 32 ) );
+	image_low = _mm256_or_si256( _mm256_andnot_si256( one , image_low ) , bits_low );
+	image_high = _mm256_or_si256( _mm256_andnot_si256( one , image_high ) , bits_high );
+	_mm256_storeu_si256( (__m256i *)( image_buffer + 8 * i ) , image_low );
+	_mm256_storeu_si256( (__m256i *)( image_buffer + 8 * i + 32 ) , image_high );
+    }
+    lsb_embed_sse2( image_buffer + 8 * i , data + i , size - i );
+}
+
+/* Function definition for SSE2 extraction, 16 image bytes per 2 data bytes */
+static void lsb_extract_sse2( char *data , const char *image_buffer , long size )
+{
+    long i = 0 ;
+    for ( ; i + 2 <= size ; i += 2 )
+    {
+	__m128i image = _mm_loadu_si128( (const __m128i *)( image_buffer + 8 * i ) );
+	/* Reverse the bytes of each 8 byte group so the first image byte lands in bit 7 */
+	image = _mm_or_si128( _mm_slli_epi16( image , 8 ) , _mm_srli_epi16( image , 8 ) );
+	image = _mm_shufflehi_epi16( _mm_shufflelo_epi16( image , 0x1B ) , 0x1B );
+	uint16_t pair = _mm_movemask_epi8( _mm_slli_epi64( image , 7 ) );
+	memcpy ( data + i , &pair , 2 );
+    }
+    lsb_extract_word( data + i , image_buffer + 8 * i , size - i );
+}
+
+/* Function definition for AVX2 extraction, 32 image bytes per 4 data bytes */
+__attribute__((target("avx2")))
+static void lsb_extract_avx2( char *data , const char *image_buffer , long size )
+{
+    const __m256i reverse = _mm256_setr_epi8( 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+	    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 );
+    long i = 0 ;
+    for ( ; i + 4 <= size ; i += 4 )
+    {
+	__m256i image = _mm256_loadu_si256( (const __m256i *)( image_buffer + 8 * i ) );
+	image = _mm256_shuffle_epi8( image , reverse );
+	uint32_t quad = _mm256_movemask_epi8( _mm256_slli_epi64( image , 7 ) );
+	memcpy ( data + i , &quad , 4 );
+    }
+    lsb_extract_sse2( data + i , image_buffer + 8 * i , size - i );
+}
+#endif
+
+/* Function definition for little endian words of image bytes */
+static inline uint64_t load_le64( const char *p )
+{
+    uint64_t word ;
+    memcpy ( &word , p , 8 );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64( word );
+#endif
+    return word ;
+}
+
+static inline void store_le64( char *p , uint64_t word )
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64( word );
+#endif
+    memcpy ( p , &word , 8 );
+}
+
+/* Function definition for a stream shorter than one group, bit by bit */
+static void lsb_embed_tail( char *image_buffer , const char *data , long size , int bits )
+{
+    for ( long b = 0 ; b < 8 * size ; b++ )
+    {
+	int bit = data[b >> 3] >> ( 7 - ( b & 7 ) ) & 1 , pos = bits - 1 - b % bits ;
+	image_buffer[b / bits] = ( image_buffer[b / bits] & ~( 1 << pos ) ) | bit << pos ;
+    }
+}
+
+static void lsb_extract_tail( char *data , const char *image_buffer , long size , int bits )
+{
+    memset ( data , 0 , size );
+    for ( long b = 0 ; b < 8 * size ; b++ )
+    {
+	int bit = image_buffer[b / bits] >> ( bits - 1 - b % bits ) & 1 ;
+	data[b >> 3] |= bit << ( 7 - ( b & 7 ) ) ;
+    }
+}
+
+/* Function definition for portable multi bit embedding, bits data bytes per word */
+static void lsb_embed_bits_word( char *image_buffer , const char *data , long size , int bits )
+{
+    uint64_t low = ( 1u << bits ) - 1 ;
+    uint64_t m1 = low * 0x0001000100010001ULL , m2 = ( ( 1u << 2 * bits ) - 1 ) * 0x0000000100000001ULL ;
+    long i = 0 ;
+    for ( ; i + bits <= size ; i += bits , image_buffer += 8 )
+    {
+	uint64_t value = 0 ;
+	for ( int j = 0 ; j < bits ; j++ )
+	    value = value << 8 | (unsigned char)data[i + j] ;
+	/* 8 groups -> 2 x 4 groups -> 4 x 2 groups -> one group per byte, first group in byte 0 */
+	uint64_t x = value >> 4 * bits | ( value & ( ( 1ULL << 4 * bits ) - 1 ) ) << 32 ;
+	x = ( x >> 2 * bits & m2 ) | ( x & m2 ) << 16 ;
+	x = ( x >> bits & m1 ) | ( x & m1 ) << 8 ;
+	store_le64( image_buffer , ( load_le64( image_buffer ) & ~( low * LSB_ONES ) ) | x );
+    }
+    lsb_embed_tail( image_buffer , data + i , size - i , bits );
+}
+
+/* Function definition for portable multi bit extraction, bits data bytes per word */
+static void lsb_extract_bits_word( char *data , const char *image_buffer , long size , int bits )
+{
+    uint64_t low = ( 1u << bits ) - 1 ;
+    uint64_t m1 = low * 0x0001000100010001ULL , m2 = ( ( 1u << 2 * bits ) - 1 ) * 0x0000000100000001ULL ;
+    long i = 0 ;
+    for ( ; i + bits <= size ; i += bits , image_buffer += 8 )
+    {
+	uint64_t x = load_le64( image_buffer ) & low * LSB_ONES ;
+	x = ( x & m1 ) << bits | ( x >> 8 & m1 ) ;
+	x = ( x & m2 ) << 2 * bits | ( x >> 16 & m2 ) ;
+	x = ( x & 0xFFFFFFFFULL ) << 4 * bits | x >> 32 ;
+	for ( int j = bits - 1 ; j >= 0 ; j-- , x >>= 8 )
+	    data[i + j] = x ;
+    }
+    lsb_extract_tail( data + i , image_buffer , size - i , bits );
+}
+
+#ifdef LSB_X86
+/* Function definition for AVX2 multi bit embedding, 2 * bits data bytes per 16 image bytes */
+__attribute__((target("avx2")))
+static void lsb_embed_bits_avx2( char *image_buffer , const char *data , long size , int bits )
+{
+    char index[32] ;
+    uint16_t scale[16] ;
+    /* Group j sits in data bytes offset / 8 and offset / 8 + 1, shifted down by 16 - offset % 8 - bits */
+    for ( int j = 0 ; j < 16 ; j++ )
+    {
+	int offset = j * bits , lane = ( j & 7 ) * 2 + ( j & 8 ) * 2 ;
+	index[lane] = offset / 8 + 1 ;
+	index[lane + 1] = offset / 8 ;
+	scale[j] = 1 << ( offset % 8 + bits ) ;
+    }
+    const __m256i shuffle = _mm256_loadu_si256( (const __m256i *)index );
+    const __m256i multiply = _mm256_loadu_si256( (const __m256i *)scale );
+    const __m256i low = _mm256_set1_epi16( ( 1 << bits ) - 1 );
+    const __m128i keep = _mm_set1_epi8( ~( ( 1 << bits ) - 1 ) );
+    long i = 0 ;
+    /* A step reads 16 data bytes and uses 2 * bits of them */
+    for ( ; i + 16 <= size ; i += 2 * bits , image_buffer += 16 )
+    {
+	__m256i window = _mm256_shuffle_epi8( _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)( data + i ) ) ) , shuffle );
+	__m256i groups = _mm256_and_si256( _mm256_mulhi_epu16( window , multiply ) , low );
+	groups = _mm256_permute4x64_epi64( _mm256_packus_epi16( groups , groups ) , 0x08 );
+	__m128i image = _mm_loadu_si128( (const __m128i *)image_buffer );
+	image = _mm_or_si128( _mm_and_si128( image , keep ) , _mm256_castsi256_si128( groups ) );
+	_mm_storeu_si128( (__m128i *)image_buffer , image );
+    }
+    lsb_embed_bits_word( image_buffer , data + i , size - i , bits );
+}
+
+/* Function definition for AVX2 multi bit extraction, 32 image bytes per 4 * bits data bytes */
+__attribute__((target("avx2")))
+static void lsb_extract_bits_avx2( char *data , const char *image_buffer , long size , int bits )
+{
+    char index[32] ;
+    /* Each 64 bit lane holds 8 * bits bits, its bytes go out most significant first */
+    for ( int j = 0 ; j < 32 ; j++ )
+    {
+	int k = j & 15 ;
+	index[j] = k < bits ? bits - 1 - k : k < 2 * bits ? 8 + 2 * bits - 1 - k : (char)0x80 ;
+    }
+    const __m256i shuffle = _mm256_loadu_si256( (const __m256i *)index );
+    const __m256i low = _mm256_set1_epi8( ( 1 << bits ) - 1 );
+    const __m256i pairs = _mm256_set1_epi16( 1 << 8 | 1 << bits );
+    const __m256i quads = _mm256_set1_epi32( 1 << 16 | 1 << 2 * bits );
+    const __m256i half = _mm256_set1_epi64x( 0xFFFFFFFFLL );
+    const __m128i shift = _mm_cvtsi32_si128( 4 * bits );
+    long i = 0 ;
+    /* Each half is stored as 8 bytes, the next step overwrites what lies past its 2 * bits */
+    for ( ; i + 4 * bits + 8 <= size ; i += 4 * bits , image_buffer += 32 )
+    {
+	__m256i x = _mm256_and_si256( _mm256_loadu_si256( (const __m256i *)image_buffer ) , low );
+	x = _mm256_madd_epi16( _mm256_maddubs_epi16( x , pairs ) , quads );
+	x = _mm256_or_si256( _mm256_sll_epi64( _mm256_and_si256( x , half ) , shift ) , _mm256_srli_epi64( x , 32 ) );
+	x = _mm256_shuffle_epi8( x , shuffle );
+	_mm_storel_epi64( (__m128i *)( data + i ) , _mm256_castsi256_si128( x ) );
+	_mm_storel_epi64( (__m128i *)( data + i + 2 * bits ) , _mm256_extracti128_si256( x , 1 ) );
+    }
+    lsb_extract_bits_word( data + i , image_buffer , size - i , bits );
+}
+#endif
+
+/* Kernels picked for this cpu, set once for every thread */
+static void (*embed_kernel)( char * , const char * , long ) ;
+static void (*extract_kernel)( char * , const char * , long ) ;
+static void (*embed_bits_kernel)( char * , const char * , long , int ) ;
+static void (*extract_bits_kernel)( char * , const char * , long , int ) ;
+static pthread_once_t lsb_once = PTHREAD_ONCE_INIT ;
+
+/* Function definition for picking the kernels, run through pthread_once so workers can race to it */
+static void lsb_dispatch( void )
+{
+#ifdef LSB_X86
+    __builtin_cpu_init();
+    int avx2 = __builtin_cpu_supports( "avx2" ) ;
+    embed_kernel = avx2 ? lsb_embed_avx2 : lsb_embed_sse2 ;
+    extract_kernel = avx2 ? lsb_extract_avx2 : lsb_extract_sse2 ;
+    embed_bits_kernel = avx2 ? lsb_embed_bits_avx2 : lsb_embed_bits_word ;
+    extract_bits_kernel = avx2 ? lsb_extract_bits_avx2 : lsb_extract_bits_word ;
+#else
+    embed_kernel = lsb_embed_word ;
+    extract_kernel = lsb_extract_word ;
+    embed_bits_kernel = lsb_embed_bits_word ;
+    extract_bits_kernel = lsb_extract_bits_word ;
+#endif
+}
+
+/* Function definition for bulk embedding */
+void lsb_embed( char *image_buffer , const char *data , long size )
+{
+    pthread_once( &lsb_once , lsb_dispatch );
+    embed_kernel( image_buffer , data , size );
+}
+
+/* Function definition for bulk extraction */
+void lsb_extract( char *data , const char *image_buffer , long size )
+{
+    pthread_once( &lsb_once , lsb_dispatch );
+    extract_kernel( data , image_buffer , size );
+}
+
+/* Function definition for image bytes of a stream */
+long lsb_image_bytes( long size , int bits )
+{
+    return ( 8 * size + bits - 1 ) / bits ;
+}
+
+/* Function definition for multi bit embedding, one bit goes to lsb_embed */
+void lsb_embed_bits( char *image_buffer , const char *data , long size , int bits )
+{
+    if ( bits == 1 )
+    {
+	lsb_embed( image_buffer , data , size );
+	return ;
+    }
+    pthread_once( &lsb_once , lsb_dispatch );
+    embed_bits_kernel( image_buffer , data , size , bits );
+}
+
+/* Function definition for multi bit extraction, one bit goes to lsb_extract */
+void lsb_extract_bits( char *data , const char *image_buffer , long size , int bits )
+{
+    if ( bits == 1 )
+    {
+	lsb_extract( data , image_buffer , size );
+	return ;
+    }
+    pthread_once( &lsb_once , lsb_dispatch );
+    extract_bits_kernel( data , image_buffer , size , bits );
+}
@@ -0,0 +1,25 @@
+#ifndef LSB_H
+#define LSB_H
+
+/*
+ * Bulk LSB kernels shared by encoder and decoder.
+ * Each data byte occupies 8 image bytes, most
+ * significant bit in the first image byte
+ */
+
+/* Embed size bytes of data into the LSBs of size * 8 image bytes */
+void lsb_embed( char *image_buffer , const char *data , long size );
+
+/* Gather the LSBs of size * 8 image bytes into size bytes of data */
+void lsb_extract( char *data , const char *image_buffer , long size );
+
+/* Image bytes that carry size bytes of data at bits LSBs per image byte */
+long lsb_image_bytes( long size , int bits );
+
+/* Embed size bytes of data into the low bits (1 to 4) of image bytes */
+void lsb_embed_bits( char *image_buffer , const char *data , long size , int bits );
+
+/* Gather size bytes of data from the low bits (1 to 4) of image bytes */
+void lsb_extract_bits( char *data , const char *image_buffer , long size , int bits );
+
+#endif
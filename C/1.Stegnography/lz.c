@@ -0,0 +1,344 @@
+/* Header file */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "lz.h"
+
+/* Function Definitions */
+/* LZ compression
+ * Input: Secret file, or compressed bytes while decoding
+ * Output: Compressed file, or the decompressed secret
+ * Description: Greedy LZ77 in the LZ4 block format. A hash of the next 4
+ * bytes indexes the last position that had the same hash, a match of at
+ * least 4 bytes is extended both ways and emitted with the literals before
+ * it. Misses make the search step grow, so data that does not compress
+ * goes through quickly and ends up stored. Blocks are independent, which
+ * keeps memory fixed and lets the decoder stream a block at a time. The
+ * decoder checks every length and offset, the data comes from an image
+ */
+
+#define LZ_HASH_LOG 12
+#define LZ_MIN_MATCH 4
+#define LZ_MFLIMIT 12			// Last match starts this far before the end
+#define LZ_LAST_LITERALS 5		// Block ends with this many literals
+#define LZ_MAX_OFFSET 65535
+#define LZ_SKIP_TRIGGER 6		// Misses before the search step grows
+
+static inline uint32_t read32( const unsigned char *p )
+{
+    uint32_t value ;
+    memcpy ( &value , p , 4 );
+    return value ;
+}
+
+static inline uint lz_hash( uint32_t sequence )
+{
+    return sequence * 2654435761u >> ( 32 - LZ_HASH_LOG ) ;
+}
+
+/* Function definition for the length of the match at p, up to limit */
+static long lz_match_length( const unsigned char *p , const unsigned char *ref , const unsigned char *limit )
+{
+    const unsigned char *start = p ;
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* 8 bytes at a time, the first differing byte is the lowest set bit */
+    while ( p + 8 <= limit )
+    {
+	uint64_t a , b ;
+	memcpy ( &a , p , 8 );
+	memcpy ( &b , ref , 8 );
+	if ( a != b )
+	{
+	    return p - start + ( __builtin_ctzll( a ^ b ) >> 3 ) ;
+	}
+	p += 8 ;
+	ref += 8 ;
+    }
+#endif
+    while ( p < limit && *p == *ref )
+    {
+	p++ ;
+	ref++ ;
+    }
+    return p - start ;
+}
+
+/* Function definition for the extra bytes of a length of 15 or more */
+static unsigned char *lz_put_length( unsigned char *op , long length )
+{
+    while ( length >= 255 )
+    {
+	*op++ = 255 ;
+	length -= 255 ;
+    }
+    *op++ = length ;
+    return op ;
+}
+
+/* Function definition for emitting literals, and a match when offset is not 0 */
+static unsigned char *lz_put_sequence( unsigned char *op , const unsigned char *literals , long literal_length , uint offset , long match_length )
+{
+    unsigned char *token = op++ ;
+    if ( literal_length >= 15 )
+    {
+	*token = 15 << 4 ;
+	op = lz_put_length( op , literal_length - 15 ) ;
+    }
+    else
+    {
+	*token = literal_length << 4 ;
+    }
+    memcpy ( op , literals , literal_length );
+    op += literal_length ;
+    if ( offset == 0 )
+    {
+	return op ;
+    }
+    *op++ = offset ;
+    *op++ = offset >> 8 ;
+    match_length -= LZ_MIN_MATCH ;
+    if ( match_length >= 15 )
+    {
+	*token |= 15 ;
+	op = lz_put_length( op , match_length - 15 ) ;
+    }
+    else
+    {
+	*token |= match_length ;
+    }
+    return op ;
+}
+
+/* Function definition for compressing a block */
+long lz_compress_block( const char *source , long size , char *dest )
+{
+    const unsigned char *src = (const unsigned char *)source , *end = src + size ;
+    const unsigned char *ip = src , *anchor = src ;
+    unsigned char *op = (unsigned char *)dest ;
+    /* Positions inside the block, blocks are at most 64K */
+    uint16_t table[1 << LZ_HASH_LOG] ;
+
+    if ( size > LZ_MFLIMIT )
+    {
+	const unsigned char *mflimit = end - LZ_MFLIMIT , *matchlimit = end - LZ_LAST_LITERALS ;
+	uint steps = 1 << LZ_SKIP_TRIGGER ;
+
+	memset ( table , 0 , sizeof(table) );
+	ip++ ;
+	while ( ip < mflimit )
+	{
+	    uint32_t sequence = read32( ip ) ;
+	    uint hash = lz_hash( sequence ) ;
+	    const unsigned char *ref = src + table[hash] ;
+	    table[hash] = ip - src ;
+	    if ( ref >= ip || ip - ref > LZ_MAX_OFFSET || read32( ref ) != sequence )
+	    {
+		ip += steps++ >> LZ_SKIP_TRIGGER ;
+		continue ;
+	    }
+	    steps = 1 << LZ_SKIP_TRIGGER ;
+
+	    /* Bytes before the match that also match */
+	    while ( ip > anchor && ref > src && ip[-1] == ref[-1] )
+	    {
+		ip-- ;
+		ref-- ;
+	    }
+	    long length = LZ_MIN_MATCH + lz_match_length( ip + LZ_MIN_MATCH , ref + LZ_MIN_MATCH , matchlimit ) ;
+	    op = lz_put_sequence( op , anchor , ip - anchor , ip - ref , length ) ;
+	    ip += length ;
+	    anchor = ip ;
+	    /* Position inside the match, the next search starts well primed */
+	    if ( ip < mflimit )
+	    {
+		table[lz_hash( read32( ip - 2 ) )] = ip - 2 - src ;
+	    }
+	}
+    }
+    /* Last literals */
+    op = lz_put_sequence( op , anchor , end - anchor , 0 , 0 ) ;
+    return op - (unsigned char *)dest ;
+}
+
+/* Function definition for decompressing a block */
+long lz_decompress_block( const char *source , long size , char *dest , long capacity )
+{
+    const unsigned char *ip = (const unsigned char *)source , *iend = ip + size ;
+    unsigned char *op = (unsigned char *)dest , *oend = op + capacity ;
+
+    while ( ip < iend )
+    {
+	uint token = *ip++ ;
+	long length = token >> 4 ;
+	if ( length == 15 )
+	{
+	    uint more ;
+	    do
+	    {
+		if ( ip >= iend )
+		{
+		    return -1 ;
+		}
+		more = *ip++ ;
+		length += more ;
+	    } while ( more == 255 );
+	}
+	if ( length > iend - ip || length > oend - op )
+	{
+	    return -1 ;
+	}
+	memcpy ( op , ip , length );
+	op += length ;
+	ip += length ;
+	/* Last sequence has no match */
+	if ( ip == iend )
+	{
+	    return op - (unsigned char *)dest ;
+	}
+
+	if ( iend - ip < 2 )
+	{
+	    return -1 ;
+	}
+	uint offset = ip[0] | ip[1] << 8 ;
+	ip += 2 ;
+	length = token & 15 ;
+	if ( length == 15 )
+	{
+	    uint more ;
+	    do
+	    {
+		if ( ip >= iend )
+		{
+		    return -1 ;
+		}
+		more = *ip++ ;
+		length += more ;
+	    } while ( more == 255 );
+	}
+	length += LZ_MIN_MATCH ;
+	if ( offset == 0 || offset > op - (unsigned char *)dest || length > oend - op )
+	{
+	    return -1 ;
+	}
+	const unsigned char *ref = op - offset ;
+	if ( offset >= length )
+	{
+	    memcpy ( op , ref , length );
+	    op += length ;
+	}
+	else
+	{
+	    /* Overlapping copy repeats the last offset bytes */
+	    while ( length-- > 0 )
+	    {
+		*op++ = *ref++ ;
+	    }
+	}
+    }
+    return -1 ;
+}
+
+/* Function definition for compressing a file block by block */
+Status lz_compress_file( FILE *fptr_src , FILE *fptr_dest , long *size )
+{
+    char *in = malloc( LZ_BLOCK_SIZE ) ;
+    char *out = malloc( LZ_BOUND( LZ_BLOCK_SIZE ) ) ;
+    Status status = in != NULL && out != NULL ? e_success : e_failure ;
+    long count ;
+
+    *size = 0 ;
+    fseek ( fptr_src , 0 , SEEK_SET );
+    while ( status == e_success && ( count = fread( in , 1 , LZ_BLOCK_SIZE , fptr_src ) ) > 0 )
+    {
+	long length = lz_compress_block( in , count , out ) ;
+	uint word = length ;
+	const char *block = out ;
+	/* Blocks that do not shrink are kept as they are */
+	if ( length >= count )
+	{
+	    word = count | LZ_BLOCK_STORED ;
+	    length = count ;
+	    block = in ;
+	}
+	char header[4] = { word >> 24 , word >> 16 , word >> 8 , word } ;
+	if ( fwrite( header , 1 , 4 , fptr_dest ) != 4 || fwrite( block , 1 , length , fptr_dest ) != (size_t)length )
+	{
+	    status = e_failure ;
+	}
+	*size += 4 + length ;
+    }
+    if ( ferror( fptr_src ) )
+    {
+	status = e_failure ;
+    }
+    free( in );
+    free( out );
+    return status ;
+}
+
+/* Function definition for starting a decompression stream */
+void lz_stream_init( LzStream *stream , FILE *fptr )
+{
+    stream->fptr = fptr ;
+    stream->header_size = 0 ;
+    stream->have = 0 ;
+    stream->total = 0 ;
+}
+
+/* Function definition for feeding compressed bytes, every whole block is written out */
+Status lz_stream_write( LzStream *stream , const char *data , long size )
+{
+    while ( size > 0 )
+    {
+	/* Block header first, it may come split over two calls */
+	if ( stream->header_size < 4 )
+	{
+	    stream->header[stream->header_size++] = *data++ ;
+	    size-- ;
+	    if ( stream->header_size == 4 )
+	    {
+		uint word = (uint)stream->header[0] << 24 | stream->header[1] << 16 | stream->header[2] << 8 | stream->header[3] ;
+		stream->block_size = word & ~LZ_BLOCK_STORED ;
+		stream->have = 0 ;
+		if ( stream->block_size == 0 || stream->block_size > LZ_BLOCK_SIZE )
+		{
+		    return e_failure ;
+		}
+	    }
+	    continue ;
+	}
+	long count = stream->block_size - stream->have < size ? stream->block_size - stream->have : size ;
+	memcpy ( stream->in + stream->have , data , count );
+	stream->have += count ;
+	data += count ;
+	size -= count ;
+	if ( stream->have < stream->block_size )
+	{
+	    continue ;
+	}
+
+	/* Whole block */
+	const char *block = stream->in ;
+	long length = stream->block_size ;
+	if ( !( stream->header[0] & 0x80 ) )
+	{
+	    length = lz_decompress_block( stream->in , stream->block_size , stream->out , LZ_BLOCK_SIZE ) ;
+	    block = stream->out ;
+	}
+	if ( length < 0 || fwrite( block , 1 , length , stream->fptr ) != (size_t)length )
+	{
+	    return e_failure ;
+	}
+	stream->total += length ;
+	stream->header_size = 0 ;
+    }
+    return e_success ;
+}
+
+/* Function definition for the end of the compressed bytes */
+Status lz_stream_end( LzStream *stream )
+{
+    return stream->header_size == 0 ? e_success : e_failure ;
+}
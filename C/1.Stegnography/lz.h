@@ -0,0 +1,53 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdio.h>
+#include "types.h" // Contains user defined types
+
+/*
+ * LZ4 style compression of the secret file.
+ * The file is cut into independent blocks of LZ_BLOCK_SIZE bytes, each
+ * stored as a 4 byte header, most significant byte first, then the block.
+ * The header holds the block length, LZ_BLOCK_STORED marks a block kept
+ * as it was because it did not get smaller. Blocks are sequences of a
+ * token (literal length << 4 | match length - 4, 15 meaning more length
+ * bytes follow), literals, and a 2 byte little endian match offset; the
+ * last sequence of a block has literals only
+ */
+
+#define LZ_BLOCK_SIZE 65536
+#define LZ_BLOCK_STORED 0x80000000u
+#define LZ_BOUND(size) ((size) + (size) / 255 + 16)
+
+/* Streaming decompression, compressed bytes in, file data out */
+typedef struct _LzStream
+{
+    FILE *fptr;				// Decompressed output
+    unsigned char header[4];
+    int header_size;			// Header bytes seen of the current block
+    uint block_size;			// Length of the current block
+    uint have;				// Block bytes seen
+    long total;				// Decompressed bytes written
+    char in[LZ_BLOCK_SIZE];
+    char out[LZ_BLOCK_SIZE];
+} LzStream;
+
+/* Compress size bytes of source into dest of LZ_BOUND(size) bytes, returns the compressed size */
+long lz_compress_block(const char *source, long size, char *dest);
+
+/* Decompress size bytes of source into at most capacity bytes of dest, returns the size or -1 */
+long lz_decompress_block(const char *source, long size, char *dest, long capacity);
+
+/* Compress fptr_src from its start into fptr_dest, compressed size in *size */
+Status lz_compress_file(FILE *fptr_src, FILE *fptr_dest, long *size);
+
+/* Start decompressing into fptr */
+void lz_stream_init(LzStream *stream, FILE *fptr);
+
+/* Feed size compressed bytes */
+Status lz_stream_write(LzStream *stream, const char *data, long size);
+
+/* Check that the compressed data ended with a whole block */
+Status lz_stream_end(LzStream *stream);
+
+#endif
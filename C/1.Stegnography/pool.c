@@ -0,0 +1,59 @@
+/* Header file */
+#include <stdlib.h>
+#include <unistd.h>
+#include "pool.h"
+
+/* Function Definitions */
+/* Thread pool
+ * Input: Number of jobs, number of threads, worker function
+ * Output: Every job claimed by exactly one worker
+ * Description: Jobs are handed out in order under a mutex, one index per
+ * claim, so the cost of the lock is nothing next to a job that reads an
+ * image. If no thread can be started the caller runs the worker itself
+ */
+
+/* Function definition for claiming the next job */
+int pool_claim( Pool *pool )
+{
+    pthread_mutex_lock( &pool->lock );
+    int i = pool->next < pool->count ? pool->next++ : -1 ;
+    pthread_mutex_unlock( &pool->lock );
+    return i ;
+}
+
+/* Function definition for running the workers until the jobs run out */
+int pool_run( Pool *pool , int count , int threads , void *(*worker)(void *) , void *arg )
+{
+    if ( threads <= 0 )
+    {
+	threads = sysconf( _SC_NPROCESSORS_ONLN ) ;
+    }
+    if ( threads > count )
+    {
+	threads = count ;
+    }
+    pool->count = count ;
+    pool->next = 0 ;
+    pool->threads = threads > 0 ? threads : 1 ;
+    pthread_mutex_init( &pool->lock , NULL );
+
+    pthread_t *workers = malloc( pool->threads * sizeof(pthread_t) ) ;
+    int started = 0 ;
+    while ( workers != NULL && started < threads && pthread_create( &workers[started] , NULL , worker , arg ) == 0 )
+    {
+	started++ ;
+    }
+    /* Without any thread the caller does the work itself */
+    if ( started == 0 )
+    {
+	pool->threads = 1 ;
+	worker( arg );
+    }
+    for ( int i = 0 ; i < started ; i++ )
+    {
+	pthread_join( workers[i] , NULL );
+    }
+    free( workers );
+    pthread_mutex_destroy( &pool->lock );
+    return started ;
+}
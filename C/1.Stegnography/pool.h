@@ -0,0 +1,26 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+
+/*
+ * Pool of worker threads for a list of jobs.
+ * Workers claim job indexes in order with pool_claim until
+ * they run out, so a slow job never holds up the others
+ */
+
+typedef struct _Pool
+{
+    int count;				// Jobs
+    int next;				// Next job to claim
+    int threads;			// Workers sharing the jobs
+    pthread_mutex_t lock;
+} Pool;
+
+/* Index of the next job, -1 when every job is claimed */
+int pool_claim(Pool *pool);
+
+/* Run worker(arg) on threads threads, 0 for one per cpu and never more than count, returns the threads started */
+int pool_run(Pool *pool, int count, int threads, void *(*worker)(void *), void *arg);
+
+#endif
@@ -0,0 +1,198 @@
+/* Header file */
+#include <stdio.h>
+#include <string.h>
+#include "scatter.h"
+#include "lsb.h"
+
+/* Function Definitions */
+/* Keyed scattering
+ * Input: Key, data area of the image, data size and bits per image byte
+ * Output: Pixel byte of every data bit
+ * Description: A Feistel network over the bits of the index space, with
+ * cycle walking to stay below the domain size, is a keyed permutation
+ * that costs a few multiplies per index and needs no table. Scattering
+ * every bit over the whole image would make every access a cache miss,
+ * so the data area is cut into regions of at most SCATTER_REGION pixel
+ * bytes instead. Each region gets an equal share of the data, spread over
+ * it by a permutation keyed with the region number, and a permutation of
+ * the region numbers decides which share goes where. A region stays in
+ * cache while positions are computed, gathered, run through the LSB
+ * kernel and scattered back a block at a time
+ */
+
+/* Function definition for FNV-1a of the key from a given basis */
+static uint64_t scatter_hash( const char *key , uint64_t state )
+{
+    for ( const unsigned char *p = (const unsigned char *)key ; *p ; p++ )
+    {
+	state = ( state ^ *p ) * 0x100000001b3ULL ;
+    }
+    return state ;
+}
+
+/* Function definition for the next splitmix64 output */
+static uint64_t splitmix( uint64_t *state )
+{
+    uint64_t z = ( *state += 0x9e3779b97f4a7c15ULL ) ;
+    z = ( z ^ z >> 30 ) * 0xbf58476d1ce4e5b9ULL ;
+    z = ( z ^ z >> 27 ) * 0x94d049bb133111ebULL ;
+    return z ^ z >> 31 ;
+}
+
+/* Function definition for the key schedule, FNV-1a of the key then splitmix64 */
+static void scatter_keys( uint64_t *keys , const char *key )
+{
+    uint64_t state = scatter_hash( key , 0xcbf29ce484222325ULL ) ;
+    for ( int i = 0 ; i < 2 * SCATTER_ROUNDS ; i++ )
+    {
+	keys[i] = splitmix( &state ) ;
+    }
+}
+
+/* Function definition for the key check word, its own FNV-1a basis keeps it apart from the key schedule */
+uint scatter_key_check( const char *key )
+{
+    uint64_t state = scatter_hash( key , 0x6c62272e07bb0142ULL ) ;
+    return splitmix( &state ) >> 32 ;
+}
+
+/* Bits needed for values below n */
+static inline int bit_width( uint64_t n )
+{
+#ifdef __GNUC__
+    return n > 1 ? 64 - __builtin_clzll( n - 1 ) : 0 ;
+#else
+    int width = 0 ;
+    while ( width < 64 && ( 1ULL << width ) < n )
+    {
+	width++ ;
+    }
+    return width ;
+#endif
+}
+
+/* Round function, top width bits of a keyed multiply */
+static inline uint64_t feistel_round( uint64_t half , uint64_t key , int width )
+{
+    return width ? ( ( half ^ key ) * 0x9e3779b97f4a7c15ULL ) >> ( 64 - width ) : 0 ;
+}
+
+/* Function definition for a keyed permutation of [0, n) */
+static inline uint64_t feistel( uint64_t x , uint64_t n , const uint64_t *keys , uint64_t tweak , int inverse )
+{
+    /* Halves of the smallest power of 2 domain that holds n, so cycle walking takes under 2 steps on average */
+    int width = bit_width( n ) ;
+    int low = width / 2 , high = width - low ;
+    uint64_t low_mask = ( 1ULL << low ) - 1 ;
+
+    if ( n <= 1 )
+    {
+	return x ;
+    }
+    do
+    {
+	uint64_t left = x >> low , right = x & low_mask ;
+	/* Even rounds change the high half from the low one, odd rounds the other way */
+	for ( int i = 0 ; i < SCATTER_ROUNDS ; i++ )
+	{
+	    int round = inverse ? SCATTER_ROUNDS - 1 - i : i ;
+	    if ( round % 2 == 0 )
+	    {
+		left ^= feistel_round( right , keys[round] + tweak , high ) ;
+	    }
+	    else
+	    {
+		right ^= feistel_round( left , keys[round] + tweak , low ) ;
+	    }
+	}
+	x = left << low | right ;
+    } while ( x >= n );
+    return x ;
+}
+
+/* Function definition for planning the regions */
+Status scatter_plan( Scatter *scatter , const char *key , long base , long area , long size , int bits )
+{
+    scatter_keys( scatter->keys , key );
+    scatter->base = base ;
+    scatter->bits = bits ;
+    scatter->size = size ;
+    scatter->regions = scatter->region_size = scatter->share = 0 ;
+    if ( area <= 0 )
+    {
+	return size == 0 ? e_success : e_failure ;
+    }
+    scatter->regions = ( area + SCATTER_REGION - 1 ) / SCATTER_REGION ;
+    scatter->region_size = area / scatter->regions ;
+    /* Shares are whole groups of bits data bytes, those fill 8 pixel bytes */
+    long groups = ( size + bits - 1 ) / bits ;
+    scatter->share = ( groups + scatter->regions - 1 ) / scatter->regions * bits ;
+    return lsb_image_bytes( scatter->share , bits ) <= scatter->region_size ? e_success : e_failure ;
+}
+
+/* Function definition for the region of a share */
+long scatter_region( const Scatter *scatter , long index )
+{
+    return feistel( index , scatter->regions , scatter->keys , 0 , 0 ) ;
+}
+
+/* Function definition for the data bytes of a region */
+void scatter_data_range( const Scatter *scatter , long region , long *offset , long *count )
+{
+    long index = feistel( region , scatter->regions , scatter->keys , 0 , 1 ) ;
+    *offset = index * scatter->share ;
+    *count = *offset < scatter->size ? scatter->size - *offset : 0 ;
+    if ( *count > scatter->share )
+    {
+	*count = scatter->share ;
+    }
+}
+
+/* Function definition for embedding or extracting the share of a region, a block of positions at a time */
+static void scatter_region_data( const Scatter *scatter , long region , char *pixels , char *data , int embed )
+{
+    const uint64_t *keys = scatter->keys + SCATTER_ROUNDS ;
+    uint64_t tweak = ( region + 1 ) * 0xd6e8feb86659fd93ULL ;
+    uint32_t positions[SCATTER_BLOCK] ;
+    char buffer[SCATTER_BLOCK] ;
+    long offset , count ;
+    int bits = scatter->bits ;
+
+    scatter_data_range( scatter , region , &offset , &count );
+    /* SCATTER_BLOCK pixel bytes carry this many data bytes */
+    long step = SCATTER_BLOCK / 8 * bits ;
+    for ( long i = 0 , t = 0 ; i < count ; i += step )
+    {
+	long chunk = count - i < step ? count - i : step ;
+	long pixel_count = lsb_image_bytes( chunk , bits ) ;
+	for ( long j = 0 ; j < pixel_count ; j++ , t++ )
+	{
+	    positions[j] = feistel( t , scatter->region_size , keys , tweak , 0 ) ;
+	    buffer[j] = pixels[positions[j]] ;
+	}
+	if ( embed )
+	{
+	    lsb_embed_bits( buffer , data + i , chunk , bits );
+	    for ( long j = 0 ; j < pixel_count ; j++ )
+	    {
+		pixels[positions[j]] = buffer[j] ;
+	    }
+	}
+	else
+	{
+	    lsb_extract_bits( data + i , buffer , chunk , bits );
+	}
+    }
+}
+
+/* Function definition for embedding the share of a region */
+void scatter_embed( const Scatter *scatter , long region , char *pixels , const char *data )
+{
+    scatter_region_data( scatter , region , pixels , (char *)data , 1 );
+}
+
+/* Function definition for extracting the share of a region */
+void scatter_extract( const Scatter *scatter , long region , const char *pixels , char *data )
+{
+    scatter_region_data( scatter , region , (char *)pixels , data , 0 );
+}
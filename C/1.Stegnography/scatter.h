@@ -0,0 +1,51 @@
+#ifndef SCATTER_H
+#define SCATTER_H
+
+#include <stdint.h>
+#include "types.h" // Contains user defined types
+
+/*
+ * Keyed scattering of the secret data over the pixel bytes.
+ * The data area is cut into regions of at most SCATTER_REGION
+ * pixel bytes, each region holds an equal share of the data at
+ * positions picked by a keyed Feistel permutation of the region,
+ * and a second one orders the regions. A check word made from
+ * the key sits before the data, so a wrong key is caught before
+ * anything is extracted
+ */
+
+#define SCATTER_REGION 16384
+#define SCATTER_BLOCK 4096
+#define SCATTER_ROUNDS 4
+#define SCATTER_CHECK_SIZE 4		// Key check word, most significant byte first
+
+typedef struct _Scatter
+{
+    uint64_t keys[2 * SCATTER_ROUNDS];	// Region order, then positions in a region
+    long base;				// First pixel byte of the data area
+    long regions;
+    long region_size;			// Pixel bytes per region
+    long share;				// Data bytes per region, whole groups of bits bytes
+    long size;				// Data bytes
+    int bits;
+} Scatter;
+
+/* Check word of a key, hashed apart from the permutation keys */
+uint scatter_key_check(const char *key);
+
+/* Plan size data bytes at bits LSBs per image byte over area pixel bytes from base */
+Status scatter_plan(Scatter *scatter, const char *key, long base, long area, long size, int bits);
+
+/* Physical region that holds the index-th share of the data */
+long scatter_region(const Scatter *scatter, long index);
+
+/* Offset and count of the data bytes held by a physical region */
+void scatter_data_range(const Scatter *scatter, long region, long *offset, long *count);
+
+/* Embed the data bytes of a region into its region_size pixel bytes */
+void scatter_embed(const Scatter *scatter, long region, char *pixels, const char *data);
+
+/* Extract the data bytes of a region from its region_size pixel bytes */
+void scatter_extract(const Scatter *scatter, long region, const char *pixels, char *data);
+
+#endif
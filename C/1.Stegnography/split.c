@@ -0,0 +1,546 @@
+/* Header file */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "split.h"
+#include "encode.h"
+#include "decode.h"
+#include "common.h"
+#include "lsb.h"
+#include "pool.h"
+
+/* Function Definitions */
+/* Split payloads
+ * Input: Secret file and cover images, or the stego images of a split
+ * Output: One stego image per cover, or the joined secret file
+ * Description: Every cover gets a part of the secret in proportion to its
+ * capacity, all at the same LSBs per image byte. A part is a normal stego
+ * image with the part flag in the format word and a part header between
+ * size field and data (see common.h). Parts are embedded concurrently, one
+ * thread per part up to the number of cpus. Joining reads the part headers,
+ * checks that they form one complete set, then decodes the parts
+ * concurrently straight to their offsets in the output, checking the CRC of
+ * each part
+ */
+
+#define SPLIT_BUF_SIZE (1 << 16)
+
+typedef struct _SplitPart
+{
+    char *fname;			// Cover image, or stego image when joining
+    char stego_fname[FILENAME_MAX];	// Stego image written for the part
+    long capacity;			// Secret bytes that fit
+    char extn[MAX_FILE_SUFFIX + 1];
+    uint set;
+    uint index;
+    uint count;
+    uint offset;
+    uint total;
+    uint size;
+    uint crc;
+    Status status;
+} SplitPart;
+
+typedef struct _SplitJob
+{
+    SplitPart *parts;
+    int count;
+    Pool pool;
+    void (*run)(struct _SplitJob *job, SplitPart *part);
+    const char *secret_fname;
+    int fd;				// Secret when splitting, output when joining
+    int lsb_bits;
+} SplitJob;
+
+static uint crc_table[8][256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+/* Function definition for the slice by 8 tables of CRC-32 */
+static void crc_init( void )
+{
+    for ( uint i = 0 ; i < 256 ; i++ )
+    {
+	uint crc = i ;
+	for ( int j = 0 ; j < 8 ; j++ )
+	{
+	    crc = crc >> 1 ^ ( crc & 1 ? 0xEDB88320 : 0 ) ;
+	}
+	crc_table[0][i] = crc ;
+    }
+    for ( uint i = 0 ; i < 256 ; i++ )
+    {
+	for ( int j = 1 ; j < 8 ; j++ )
+	{
+	    crc_table[j][i] = crc_table[j - 1][i] >> 8 ^ crc_table[0][crc_table[j - 1][i] & 0xFF] ;
+	}
+    }
+}
+
+/* Function definition for CRC-32, 8 bytes per step */
+uint split_crc32( uint crc , const char *data , long size )
+{
+    const unsigned char *p = (const unsigned char *)data ;
+
+    pthread_once( &crc_once , crc_init );
+    crc = ~crc ;
+    for ( ; size >= 8 ; size -= 8 , p += 8 )
+    {
+	uint low = crc ^ ( p[0] | p[1] << 8 | p[2] << 16 | (uint)p[3] << 24 ) ;
+	crc = crc_table[7][low & 0xFF] ^ crc_table[6][low >> 8 & 0xFF] ^ crc_table[5][low >> 16 & 0xFF] ^ crc_table[4][low >> 24] ^
+	    crc_table[3][p[4]] ^ crc_table[2][p[5]] ^ crc_table[1][p[6]] ^ crc_table[0][p[7]] ;
+    }
+    while ( size-- > 0 )
+    {
+	crc = crc >> 8 ^ crc_table[0][( crc ^ *p++ ) & 0xFF] ;
+    }
+    return ~crc ;
+}
+
+/* Most significant byte first, like the other fields */
+static void put_u32( unsigned char *p , uint value )
+{
+    p[0] = value >> 24 ;
+    p[1] = value >> 16 ;
+    p[2] = value >> 8 ;
+    p[3] = value ;
+}
+
+static uint get_u32( const unsigned char *p )
+{
+    return (uint)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3] ;
+}
+
+/* Function definition for the set id, CRC-32 of the part CRCs in index order */
+static uint split_set_id( const SplitPart *parts , int count )
+{
+    uint set = 0 ;
+    for ( int i = 0 ; i < count ; i++ )
+    {
+	unsigned char crc[4] ;
+	put_u32( crc , parts[i].crc );
+	set = split_crc32( set , (const char *)crc , 4 ) ;
+    }
+    return set ;
+}
+
+/* Function definition for a worker, claims parts until none are left */
+static void *split_worker( void *arg )
+{
+    SplitJob *job = arg ;
+    for ( int i ; ( i = pool_claim( &job->pool ) ) >= 0 ; )
+    {
+	job->run( job , &job->parts[i] );
+    }
+    return NULL ;
+}
+
+/* Function definition for running job->run on every part concurrently */
+static void split_run( SplitJob *job , void (*run)(SplitJob *job, SplitPart *part) )
+{
+    job->run = run ;
+    pool_run( &job->pool , job->count , 0 , split_worker , job );
+}
+
+/* Function definition for the CRC of the secret bytes of a part */
+static void split_checksum( SplitJob *job , SplitPart *part )
+{
+    char *buffer = malloc( SPLIT_BUF_SIZE ) ;
+    part->status = buffer != NULL ? e_success : e_failure ;
+    part->crc = 0 ;
+    for ( uint done = 0 ; part->status == e_success && done < part->size ; )
+    {
+	uint count = part->size - done < SPLIT_BUF_SIZE ? part->size - done : SPLIT_BUF_SIZE ;
+	if ( pread( job->fd , buffer , count , part->offset + done ) != count )
+	{
+	    part->status = e_failure ;
+	    break ;
+	}
+	part->crc = split_crc32( part->crc , buffer , count ) ;
+	done += count ;
+    }
+    free( buffer );
+}
+
+/* Function definition for encoding one part into its cover */
+static void split_embed( SplitJob *job , SplitPart *part )
+{
+    EncodeInfo *encInfo = calloc( 1 , sizeof(EncodeInfo) ) ;
+    if ( encInfo == NULL )
+    {
+	part->status = e_failure ;
+	return ;
+    }
+    encInfo->src_image_fname = part->fname ;
+    encInfo->secret_fname = (char *)job->secret_fname ;
+    encInfo->stego_image_fname = part->stego_fname ;
+    encInfo->lsb_bits = job->lsb_bits ;
+    encInfo->format_flags = FORMAT_FLAG_PART ;
+    encInfo->secret_offset = part->offset ;
+    encInfo->size_secret_file = part->size ;
+
+    unsigned char *header = (unsigned char *)encInfo->data_header ;
+    put_u32( header , part->set );
+    header[4] = part->index >> 8 ;
+    header[5] = part->index ;
+    header[6] = part->count >> 8 ;
+    header[7] = part->count ;
+    put_u32( header + 8 , part->offset );
+    put_u32( header + 12 , part->total );
+    put_u32( header + 16 , part->crc );
+    encInfo->data_header_size = PART_HEADER_SIZE ;
+
+    part->status = do_encoding( encInfo ) ;
+    if ( encInfo->fptr_src_image != NULL )
+    {
+	fclose( encInfo->fptr_src_image );
+    }
+    if ( encInfo->fptr_secret != NULL )
+    {
+	fclose( encInfo->fptr_secret );
+    }
+    if ( encInfo->fptr_stego_image != NULL && fclose( encInfo->fptr_stego_image ) != 0 )
+    {
+	part->status = e_failure ;
+    }
+    free( encInfo );
+}
+
+/* Function definition for the secret bytes a cover holds at bits LSBs per image byte */
+static long split_capacity( long pixel_bytes , int extn_size , int bits )
+{
+    long room = pixel_bytes - ( 2 + 4 ) * 8 - lsb_image_bytes( extn_size , bits ) - lsb_image_bytes( 4 , bits ) - lsb_image_bytes( PART_HEADER_SIZE , bits ) ;
+    return room > 0 ? room * bits / 8 : 0 ;
+}
+
+/* Function definition for splitting a secret file over covers */
+Status do_split( const char *secret_fname , const char *stego_fname , char **covers , int count , int lsb_bits )
+{
+    char extn[MAX_FILE_SUFFIX + 1] ;
+    const char *suffix = strrchr( stego_fname , '.' ) ;
+    if ( suffix == NULL || strcmp( suffix , ".bmp" ) != 0 || count < 1 || count > MAX_PARTS )
+    {
+	printf ("Error: pass a stego_image.bmp and 1 to %d cover images\n", MAX_PARTS );
+	return e_failure ;
+    }
+    if ( get_secret_file_extn( secret_fname , extn ) != e_success )
+    {
+	return e_failure ;
+    }
+    FILE *fptr_secret = fopen( secret_fname , "rb" ) ;
+    if ( fptr_secret == NULL )
+    {
+	perror("fopen");
+	fprintf(stderr, "ERROR: Unable to open file %s\n", secret_fname);
+	return e_failure ;
+    }
+    long total = get_file_size( fptr_secret ) ;
+    SplitPart *parts = calloc( count , sizeof(SplitPart) ) ;
+    long *pixel_bytes = calloc( count , sizeof(long) ) ;
+    Status status = parts != NULL && pixel_bytes != NULL && total <= 0xFFFFFFFFL ? e_success : e_failure ;
+
+    /* Pixel bytes of every cover */
+    for ( int i = 0 ; status == e_success && i < count ; i++ )
+    {
+	BmpInfo bmp ;
+	FILE *fptr = fopen( covers[i] , "rb" ) ;
+	if ( fptr == NULL || bmp_read_info( fptr , &bmp ) != e_success )
+	{
+	    printf ("Cover image %s is not usable\n", covers[i] );
+	    status = e_failure ;
+	}
+	else
+	{
+	    pixel_bytes[i] = bmp_pixel_bytes( &bmp ) ;
+	}
+	if ( fptr != NULL )
+	{
+	    fclose( fptr );
+	}
+    }
+
+    /* Fewest LSBs per image byte at which all covers together hold the secret */
+    int low = lsb_bits ? lsb_bits : 1 , high = lsb_bits ? lsb_bits : MAX_LSB_BITS , bits = 0 ;
+    long capacity = 0 ;
+    for ( int k = low ; status == e_success && bits == 0 && k <= high ; k++ )
+    {
+	capacity = 0 ;
+	for ( int i = 0 ; i < count ; i++ )
+	{
+	    parts[i].capacity = split_capacity( pixel_bytes[i] , strlen( extn ) , k ) ;
+	    capacity += parts[i].capacity ;
+	}
+	if ( capacity >= total )
+	{
+	    bits = k ;
+	}
+    }
+    if ( status == e_success && bits == 0 )
+    {
+	printf ("Secret of %ld bytes does not fit the %d covers\n", total , count );
+	status = e_failure ;
+    }
+
+    if ( status == e_success )
+    {
+	/* Parts in proportion to capacity, the rounding left over goes where there is room */
+	long given = 0 ;
+	for ( int i = 0 ; i < count ; i++ )
+	{
+	    parts[i].size = capacity ? (long)( (double)total * parts[i].capacity / capacity ) : 0 ;
+	    if ( parts[i].size > parts[i].capacity )
+	    {
+		parts[i].size = parts[i].capacity ;
+	    }
+	    given += parts[i].size ;
+	}
+	for ( int i = 0 ; given < total ; i++ )
+	{
+	    long more = parts[i].capacity - parts[i].size < total - given ? parts[i].capacity - parts[i].size : total - given ;
+	    parts[i].size += more ;
+	    given += more ;
+	}
+	int stem = suffix - stego_fname ;
+	for ( long i = 0 , offset = 0 ; i < count ; offset += parts[i++].size )
+	{
+	    parts[i].fname = covers[i] ;
+	    parts[i].index = i ;
+	    parts[i].count = count ;
+	    parts[i].offset = offset ;
+	    parts[i].total = total ;
+	    snprintf( parts[i].stego_fname , FILENAME_MAX , "%.*s_%ld.bmp" , stem , stego_fname , i + 1 );
+	}
+	printf ("Splitting %ld bytes over %d covers at %d bit%s per image byte\n", total , count , bits , bits > 1 ? "s" : "" );
+
+	SplitJob job = { .parts = parts , .count = count , .secret_fname = secret_fname , .fd = fileno( fptr_secret ) , .lsb_bits = bits } ;
+	/* Part CRCs first, every part header carries the set id made from all of them */
+	split_run( &job , split_checksum );
+	for ( int i = 0 ; i < count ; i++ )
+	{
+	    if ( parts[i].status != e_success )
+	    {
+		status = e_failure ;
+	    }
+	}
+	uint set = split_set_id( parts , count ) ;
+	for ( int i = 0 ; i < count ; i++ )
+	{
+	    parts[i].set = set ;
+	}
+	if ( status == e_success )
+	{
+	    split_run( &job , split_embed );
+	}
+	for ( int i = 0 ; status == e_success && i < count ; i++ )
+	{
+	    if ( parts[i].status == e_success )
+	    {
+		printf ("Part %d of %d, %u bytes from offset %u, in %s\n", i + 1 , count , parts[i].size , parts[i].offset , parts[i].stego_fname );
+	    }
+	    else
+	    {
+		printf ("Failed to encode part %d into %s\n", i + 1 , parts[i].stego_fname );
+		status = e_failure ;
+	    }
+	}
+    }
+    fclose( fptr_secret );
+    free( pixel_bytes );
+    free( parts );
+    return status ;
+}
+
+/* Function definition for reading the headers of a part, the image stays open at its data */
+static Status split_read_header( DecodeInfo *decInfo , SplitPart *part )
+{
+    unsigned char header[PART_HEADER_SIZE] ;
+
+    decInfo->stego_image_fname = part->fname ;
+    decInfo->fptr_stego_image = NULL ;
+    if ( open_file( decInfo ) != e_success ||
+	    decode_magic_string( MAGIC_STRING , decInfo->magic , decInfo ) != e_success ||
+	    decode_secret_file_extn_size( decInfo , decInfo->fptr_stego_image ) != e_success ||
+	    decInfo->format_flags != FORMAT_FLAG_PART ||
+	    decode_secret_file_extn( decInfo->file_extn_size , decInfo ) != e_success ||
+	    decode_secret_file_size( decInfo ) != e_success ||
+	    decode_bytes_from_image( (char *)header , PART_HEADER_SIZE , decInfo ) != e_success )
+    {
+	return e_failure ;
+    }
+    strcpy( part->extn , decInfo->file_extn );
+    part->size = decInfo->file_size ;
+    part->set = get_u32( header ) ;
+    part->index = header[4] << 8 | header[5] ;
+    part->count = header[6] << 8 | header[7] ;
+    part->offset = get_u32( header + 8 ) ;
+    part->total = get_u32( header + 12 ) ;
+    part->crc = get_u32( header + 16 ) ;
+    return e_success ;
+}
+
+/* Function definition for reading the part header of a stego image */
+static void split_header( SplitJob *job , SplitPart *part )
+{
+    (void)job ;
+    DecodeInfo *decInfo = malloc( sizeof(DecodeInfo) ) ;
+    part->status = decInfo != NULL ? split_read_header( decInfo , part ) : e_failure ;
+    if ( decInfo != NULL && decInfo->fptr_stego_image != NULL )
+    {
+	fclose( decInfo->fptr_stego_image );
+    }
+    free( decInfo );
+}
+
+/* Function definition for decoding a part to its offset in the output */
+static void split_extract( SplitJob *job , SplitPart *part )
+{
+    DecodeInfo *decInfo = malloc( sizeof(DecodeInfo) ) ;
+
+    part->status = decInfo != NULL ? split_read_header( decInfo , part ) : e_failure ;
+    if ( part->status == e_success )
+    {
+	uint crc = part->crc ;
+	/* Whole groups of lsb_bits bytes, so the chunks continue one bit stream */
+	uint step = MAX_DECODE_BUF_SIZE / decInfo->lsb_bits * decInfo->lsb_bits ;
+	part->crc = 0 ;
+	for ( uint done = 0 , chunk ; done < part->size ; done += chunk )
+	{
+	    chunk = part->size - done < step ? part->size - done : step ;
+	    if ( decode_bytes_from_image( decInfo->secret_data , chunk , decInfo ) != e_success ||
+		    pwrite( job->fd , decInfo->secret_data , chunk , part->offset + done ) != chunk )
+	    {
+		part->status = e_failure ;
+		break ;
+	    }
+	    part->crc = split_crc32( part->crc , decInfo->secret_data , chunk ) ;
+	}
+	if ( part->crc != crc )
+	{
+	    part->status = e_failure ;
+	}
+    }
+    if ( decInfo != NULL && decInfo->fptr_stego_image != NULL )
+    {
+	fclose( decInfo->fptr_stego_image );
+    }
+    free( decInfo );
+}
+
+/* Function definition for ordering parts by index */
+static int split_compare( const void *a , const void *b )
+{
+    const SplitPart *x = a , *y = b ;
+    return ( x->index > y->index ) - ( x->index < y->index ) ;
+}
+
+/* Function definition for joining the parts of a split payload */
+Status do_join( const char *decode_fname , char **stegos , int count )
+{
+    if ( count < 1 || count > MAX_PARTS )
+    {
+	printf ("Error: pass 1 to %d stego images\n", MAX_PARTS );
+	return e_failure ;
+    }
+    SplitPart *parts = calloc( count , sizeof(SplitPart) ) ;
+    if ( parts == NULL )
+    {
+	return e_failure ;
+    }
+    for ( int i = 0 ; i < count ; i++ )
+    {
+	parts[i].fname = stegos[i] ;
+    }
+
+    SplitJob job = { .parts = parts , .count = count , .fd = -1 } ;
+    Status status = e_success ;
+    split_run( &job , split_header );
+    for ( int i = 0 ; i < count ; i++ )
+    {
+	if ( parts[i].status != e_success )
+	{
+	    printf ("%s does not hold a part of a split payload\n", parts[i].fname );
+	    status = e_failure ;
+	}
+    }
+
+    /* The parts have to be one complete set, each part once, back to back */
+    if ( status == e_success )
+    {
+	qsort( parts , count , sizeof(SplitPart) , split_compare );
+	uint offset = 0 ;
+	for ( int i = 0 ; i < count ; i++ )
+	{
+	    if ( parts[i].count != (uint)count || parts[i].index != (uint)i || parts[i].set != parts[0].set ||
+		    parts[i].total != parts[0].total || strcmp( parts[i].extn , parts[0].extn ) != 0 || parts[i].offset != offset )
+	    {
+		if ( parts[i].count != (uint)count )
+		{
+		    printf ("Payload was split over %u images, %d given\n", parts[i].count , count );
+		}
+		else
+		{
+		    printf ("Part %d is missing, repeated or from another payload\n", i + 1 );
+		}
+		status = e_failure ;
+		break ;
+	    }
+	    offset += parts[i].size ;
+	}
+	if ( status == e_success && ( offset != parts[0].total || split_set_id( parts , count ) != parts[0].set ) )
+	{
+	    printf ("Parts do not form one payload\n");
+	    status = e_failure ;
+	}
+    }
+
+    char file[FILENAME_MAX] ;
+    if ( status == e_success && snprintf( file , sizeof(file) , "%s%s" , decode_fname , parts[0].extn ) < (int)sizeof(file) )
+    {
+	FILE *fptr_decode = fopen( file , "wb" ) ;
+	if ( fptr_decode == NULL )
+	{
+	    perror("fopen");
+	    fprintf(stderr, "Error: Unable to open file %s\n", file);
+	    status = e_failure ;
+	}
+	else
+	{
+	    /* Every part lands at its own offset, in any order */
+	    job.fd = fileno( fptr_decode ) ;
+	    if ( ftruncate( job.fd , parts[0].total ) != 0 )
+	    {
+		status = e_failure ;
+	    }
+	    else
+	    {
+		split_run( &job , split_extract );
+	    }
+	    for ( int i = 0 ; status == e_success && i < count ; i++ )
+	    {
+		if ( parts[i].status != e_success )
+		{
+		    printf ("Part %d in %s is damaged\n", i + 1 , parts[i].fname );
+		    status = e_failure ;
+		}
+	    }
+	    if ( fclose( fptr_decode ) != 0 || status != e_success )
+	    {
+		/* No half joined output */
+		remove( file );
+		status = e_failure ;
+	    }
+	    else
+	    {
+		printf ("Joined %d parts, %u bytes into %s\n", count , parts[0].total , file );
+	    }
+	}
+    }
+    else
+    {
+	status = e_failure ;
+    }
+    free( parts );
+    return status ;
+}
@@ -0,0 +1,23 @@
+#ifndef SPLIT_H
+#define SPLIT_H
+
+#include "types.h" // Contains user defined types
+
+/*
+ * Split mode spreads one payload over several cover images:
+ *     -s secret.txt stego.bmp cover1.bmp cover2.bmp ... [-k bits]
+ * writes stego_1.bmp, stego_2.bmp, ... one part per cover, and
+ *     -j decoded stego_2.bmp stego_1.bmp ...
+ * joins the parts back, given in any order
+ */
+
+/* Split secret_fname over count covers, stego images named after stego_fname */
+Status do_split(const char *secret_fname, const char *stego_fname, char **covers, int count, int lsb_bits);
+
+/* Join the parts of count stego images into decode_fname with the stored extension */
+Status do_join(const char *decode_fname, char **stegos, int count);
+
+/* CRC-32 (IEEE 802.3) of size bytes, continuing from crc, 0 to start */
+uint split_crc32(uint crc, const char *data, long size);
+
+#endif
@@ -4,8 +4,12 @@
  * Name        : SHANKAR S
  * Date        : 28/12/2022
  * Description :
- * Input       : 1.For Encoding: ./a.out -e beautiful.bmp secret.txt stego.bmp
- *               2.For Decoding: ./a.out -d stege.bmp decode_msg.txt
+ * Input       : 1.For Encoding: ./a.out -e beautiful.bmp secret.txt stego.bmp [-k bits] [-z] [-p key]
+ *               2.For Decoding: ./a.out -d stege.bmp decode_msg.txt [-p key]
+ *               3.For a batch:  ./a.out -b manifest.txt [threads]
+ *               4.For a split:  ./a.out -s secret.txt stego.bmp cover1.bmp cover2.bmp ... [-k bits]
+ *                 and to join:  ./a.out -j decode_msg stego_1.bmp stego_2.bmp ...
+ *               5.For a bench:  ./a.out -t [rounds]
  * Output      : 1
  *               ----------Choosen Encoding part----------
  *
@@ -43,8 +47,12 @@
 
 /* Including headers */
 #include <stdio.h>
+#include <stdlib.h>
 #include "encode.h"
 #include "decode.h"
+#include "batch.h"
+#include "split.h"
+#include "bench.h"
 #include "types.h"
 #include <string.h>
 #include "common.h"
@@ -52,15 +60,15 @@
 
 /* Main function with arguments entered by the user through command line */
 
-int main( char argc , char **argv )
+int main( int argc , char **argv )
 
 {
     /* Checking whether required filenames are passed or not */
 
-    if ( argc < 3 || argc > 5)
+    if ( argc < 2 || ( argc < 3 && check_operation_type( argv ) != e_bench ) || ( argc > 10 && check_operation_type( argv ) != e_split && check_operation_type( argv ) != e_join ) )
     {
-	printf("Encodeong is not possible please pass arguments in between 3 and 5\n");
-	printf("Usage: .Please pass for Encoding: ./a.out -e beautiful.bmp secret.txt stego_image.bmp\n");
+	printf("Encodeong is not possible please pass arguments in between 3 and 10\n");
+	printf("Usage: .Please pass for Encoding: ./a.out -e beautiful.bmp secret.txt stego_image.bmp [-k bits] [-z] [-p key]\n");
 	return e_failure;
     }
     else if ( check_operation_type( argv ) == e_encode)
@@ -94,10 +102,10 @@ int main( char argc , char **argv )
 	/* Validation if OperationType is decoding */
     else if ( check_operation_type(argv) == e_decode )
     {
-	if( argc < 3 || argc > 4 )
+	if( argc < 3 || argc > 6 )
     	{
-	printf("Encodeong is not possible please pass arguments in between 3 and 4\n");
-	printf("Usage: .Please pass for Decoding: ./a.out -d stego.bmp\n");
+	printf("Encodeong is not possible please pass arguments in between 3 and 6\n");
+	printf("Usage: .Please pass for Decoding: ./a.out -d stego.bmp [decode_msg] [-p key]\n");
 	return e_failure;
 	}
 	else
@@ -127,10 +135,85 @@ int main( char argc , char **argv )
 	    }
 	}
     }
+    /* Validation if OperationType is a batch of images */
+    else if ( check_operation_type(argv) == e_batch )
+    {
+	if ( argc > 4 )
+	{
+	    printf("Usage: ./a.out -b manifest.txt [threads]\n");
+	    return e_failure;
+	}
+	/* One thread per cpu unless given */
+	if ( do_batch( argv[2] , argc == 4 ? atoi( argv[3] ) : 0 ) != e_success )
+	{
+	    return e_failure;
+	}
+    }
+    /* Validation if OperationType is splitting over several covers */
+    else if ( check_operation_type(argv) == e_split )
+    {
+	/* Optional -k bits after the covers */
+	int bits = 0 ;
+	if ( argc > 5 && strcmp( argv[argc - 2] , "-k" ) == 0 )
+	{
+	    bits = atoi( argv[argc - 1] ) ;
+	    argc -= 2 ;
+	    if ( bits < 1 || bits > MAX_LSB_BITS )
+	    {
+		printf("Error: -k takes 1 to %d bits per image byte\n", MAX_LSB_BITS);
+		return e_failure;
+	    }
+	}
+	if ( argc < 5 )
+	{
+	    printf("Usage: ./a.out -s secret.txt stego.bmp cover1.bmp cover2.bmp ... [-k bits]\n");
+	    return e_failure;
+	}
+	if ( do_split( argv[2] , argv[3] , argv + 4 , argc - 4 , bits ) == e_success )
+	{
+	    printf ("\n*****************Split Successfully*********************\n");
+	}
+	else
+	{
+	    printf ("Failed to split\n");
+	    return e_failure;
+	}
+    }
+    /* Validation if OperationType is joining the parts of a split */
+    else if ( check_operation_type(argv) == e_join )
+    {
+	if ( argc < 4 )
+	{
+	    printf("Usage: ./a.out -j decode_msg stego_1.bmp stego_2.bmp ...\n");
+	    return e_failure;
+	}
+	if ( do_join( argv[2] , argv + 3 , argc - 3 ) == e_success )
+	{
+	    printf ("\n*****************Joined Successfully********************\n");
+	}
+	else
+	{
+	    printf ("Failed to join\n");
+	    return e_failure;
+	}
+    }
+    /* Validation if OperationType is the benchmark and round trip check */
+    else if ( check_operation_type(argv) == e_bench )
+    {
+	if ( argc > 3 )
+	{
+	    printf("Usage: ./a.out -t [rounds]\n");
+	    return e_failure;
+	}
+	if ( do_bench( argc == 3 ? atoi( argv[2] ) : 0 ) != e_success )
+	{
+	    return e_failure;
+	}
+    }
     else if( check_operation_type(argv) == e_unsupported)
     {
 	printf("Error: please pass valid type of operation\n");
-	printf("Usage: ./a.out -e beautifull.bmp secret.txt\nUsage: ./a.out. -d stego.bmp\n");
+	printf("Usage: ./a.out -e beautifull.bmp secret.txt\nUsage: ./a.out. -d stego.bmp\nUsage: ./a.out -b manifest.txt [threads]\nUsage: ./a.out -s secret.txt stego.bmp cover1.bmp cover2.bmp ... [-k bits]\nUsage: ./a.out -j decode_msg stego_1.bmp stego_2.bmp ...\nUsage: ./a.out -t [rounds]\n");
     }
     return 0;
 } 
@@ -146,6 +229,22 @@ OperationType check_operation_type( char *argv[] )
     {
 	return e_decode;
     }
+    if ( strcmp( argv[1] , "-b" ) == 0 )
+    {
+	return e_batch;
+    }
+    if ( strcmp( argv[1] , "-s" ) == 0 )
+    {
+	return e_split;
+    }
+    if ( strcmp( argv[1] , "-j" ) == 0 )
+    {
+	return e_join;
+    }
+    if ( strcmp( argv[1] , "-t" ) == 0 )
+    {
+	return e_bench;
+    }
     else
     {
 	return e_unsupported;
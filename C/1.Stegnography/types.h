@@ -14,6 +14,10 @@ typedef enum
 {
     e_encode,
     e_decode,
+    e_batch,
+    e_split,
+    e_join,
+    e_bench,
     e_unsupported
 } OperationType;
 
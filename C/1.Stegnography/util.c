@@ -0,0 +1,63 @@
+/* Header file */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include "util.h"
+
+/* Function Definitions */
+/* Shared helpers
+ * Input: Files and streams of a batch or bench run
+ * Output: Times, closed files, stdout sent away and back
+ * Description: The report is written to a copy of the real stdout while
+ * stdout itself points at /dev/null, so the progress messages printed by
+ * the encoder and decoder are dropped without touching their code
+ */
+
+/* Function definition for seconds since an arbitrary point */
+double util_clock( void )
+{
+    struct timespec now ;
+    clock_gettime( CLOCK_MONOTONIC , &now );
+    return now.tv_sec + now.tv_nsec * 1e-9 ;
+}
+
+/* Function definition for closing a file, if it was opened */
+void util_close( FILE *fptr )
+{
+    if ( fptr != NULL )
+    {
+	fclose( fptr );
+    }
+}
+
+/* Function definition for sending stdout to /dev/null */
+FILE *util_quiet_stdout( void )
+{
+    fflush( stdout );
+    int saved = dup( STDOUT_FILENO ) ;
+    FILE *report = saved >= 0 ? fdopen( saved , "w" ) : NULL ;
+    if ( report == NULL )
+    {
+	if ( saved >= 0 )
+	{
+	    close( saved );
+	}
+	return NULL ;
+    }
+    if ( freopen( "/dev/null" , "w" , stdout ) == NULL )
+    {
+	fclose( report );
+	return NULL ;
+    }
+    return report ;
+}
+
+/* Function definition for putting the real stdout back */
+void util_restore_stdout( FILE *report )
+{
+    fflush( stdout );
+    fflush( report );
+    dup2( fileno( report ) , STDOUT_FILENO );
+    fclose( report );
+}
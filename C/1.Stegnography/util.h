@@ -0,0 +1,24 @@
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stdio.h>
+
+/*
+ * Helpers shared by the batch and bench modes.
+ * Both time their runs, close the files a run left open
+ * and print a report while the messages of the runs are dropped
+ */
+
+/* Seconds since an arbitrary point */
+double util_clock(void);
+
+/* Close fptr, if it was opened */
+void util_close(FILE *fptr);
+
+/* Send stdout to /dev/null, returns a stream on the real stdout for the report or NULL */
+FILE *util_quiet_stdout(void);
+
+/* Put the real stdout back and close the report */
+void util_restore_stdout(FILE *report);
+
+#endif
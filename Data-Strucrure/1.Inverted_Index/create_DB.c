@@ -16,34 +16,37 @@ void read_datafile(main_node_t **head, char *f_name)
 {
 	FILE *fptr = fopen(f_name, "r");
 	char word[BUFF_SIZE];
-	short index, flag = 0;
+	short index;
+	double start = stats_now(), now;
 	while (fscanf(fptr, "%s", word) != EOF)
 	{
+		now = stats_now();
+		db_stats.t_tokenize += now - start;
+		db_stats.tokens++;
+		start = now;
 
 		index = tolower(word[0]) % 97;	
 		if (index > 25 || index < 0)
 			index = 26;
 
-		if (head[index] == NULL)
-			insert_at_last_main(&head[index], word, f_name);
+		/* Lookup is the walk of the bucket, an empty one included, so it ends before any insert */
+		main_node_t *temp = head[index];
+		while (temp && strcmp(temp->word, word) != 0)
+			temp = temp->link;
+		now = stats_now();
+		db_stats.t_lookup += now - start;
+		start = now;
+
+		if (temp)
+			update_word_count(&temp, f_name);
 		else
-		{
-			main_node_t *temp = head[index];
-			while(temp)
-			{
-				if (strcmp(temp->word, word)==0)
-				{
-					update_word_count(&temp, f_name);
-					flag = 1;
-					break;
-				}
-				else
-					temp =temp ->link;
-			}
-			if(flag == 0)
-				insert_at_last_main(&head[index], word, f_name);
-		}
+			insert_at_last_main(&head[index], word, f_name);
+		now = stats_now();
+		db_stats.t_insert += now - start;
+		start = now;
 	}
+	fclose(fptr);
+	db_stats.files_indexed++;
 	printf(CYAN"Successfull: Creation of database for file %s\n", f_name);
 }
 
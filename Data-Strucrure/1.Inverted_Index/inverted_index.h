@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 #include "colors.h"
 
 #define SUCCESS 0
@@ -18,6 +19,7 @@
 #define SIZE 26
 #define BUFF_SIZE 255
 #define NAMELENGTH 50
+#define HIST_BUCKETS 8
 
 //inverted table
 
@@ -42,6 +44,19 @@ typedef struct file_node
     struct file_node *link;
 }file_node_t;
 
+//instrumentation counters, filled while the database is built and saved
+typedef struct index_stats
+{
+	double t_tokenize;
+	double t_lookup;
+	double t_insert;
+	double t_save;
+	long tokens;
+	long files_indexed;
+}index_stats_t;
+
+extern index_stats_t db_stats;
+
 /* File validation */
 int validate_n_store_filenames(file_node_t **head, char *filenames[]);
 int validation_store_filenames(file_node_t **file_head, char *filenames);
@@ -68,4 +83,8 @@ int save_DB(main_node_t **head, char *fname);
 /*Update */
 int update_DB(main_node_t **main_head, file_node_t *file_head, char *f_name);
 
+/*Stats */
+double stats_now(void);
+int stats_DB(main_node_t **head, file_node_t *file_head, char *json_fname);
+
 #endif
@@ -4,7 +4,7 @@ int main(int argc, char *argv[])                      //Function to read file na
 {
     int choice,flag = 0, index;
     char option;
-    char word[BUFF_SIZE], file[BUFF_SIZE],backup[BUFF_SIZE];
+    char word[BUFF_SIZE], file[BUFF_SIZE],backup[BUFF_SIZE], json[BUFF_SIZE];
     file_node_t *head = NULL;
     if(argc == 1)
     {
@@ -24,7 +24,7 @@ int main(int argc, char *argv[])                      //Function to read file na
 
 	while(1)
 	{
-	    printf(ORANGE"1. Create Database\n2. Dispaly Database\n3. Search Database\n4. Updata Database\n5. Save Database\n");
+	    printf(ORANGE"1. Create Database\n2. Dispaly Database\n3. Search Database\n4. Updata Database\n5. Save Database\n6. Stats Database\n");
 	    printf(RED"Please Enter your choice : ");
 	    printf(WHITE);
 	    scanf("%d", &choice);
@@ -66,6 +66,12 @@ int main(int argc, char *argv[])                      //Function to read file na
 		    scanf("%s", backup);
 		    save_DB(head, backup);
 		    break;
+		case 6: // case to print the statistics of data base, optionally as JSON
+		    printf(GREEN"Enter the JSON filename (- to skip) : ");
+		    printf(YELLOW);
+		    scanf("%s", json);
+		    stats_DB(head, file_head, strcmp(json, "-") ? json : NULL);
+		    break;
 		default:
 		    printf(YELLOW"Invalid input\n");
 		    break;
@@ -2,8 +2,15 @@
 
 int save_DB(main_node_t **head, char *fname)
 {
+	double start = stats_now();
+
 	//Open the file as write mode.
 	FILE *fptr = fopen(fname, "w");
+	if (fptr == NULL)
+	{
+		printf(RED"Error : Unable to open %s\n", fname);
+		return FAILURE;
+	}
 
 	//Running loop for storing the data in the file. 
 	for (int i = 0; i < SIZE; i++)
@@ -47,6 +54,7 @@ int save_DB(main_node_t **head, char *fname)
 
 	//close the file pointer 
 	fclose(fptr);
+	db_stats.t_save += stats_now() - start;
 	return SUCCESS;
 }
 
@@ -0,0 +1,115 @@
+#include "inverted_index.h"
+
+//Global counters updated by create_DB, update_DB and save_DB
+index_stats_t db_stats;
+
+//Funtion to read a monotonic clock in seconds
+double stats_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Funtion to find the histogram bucket of a postings length (1, 2, 3-4, 5-8, ... , 65+)
+static int hist_bucket(int len)
+{
+	int bucket = 0;
+	while (len > 1 && bucket < HIST_BUCKETS - 1)
+	{
+		len = (len + 1) / 2;
+		bucket++;
+	}
+	return bucket;
+}
+
+/*
+ * Function defination
+ * To print the instrumentation report of the Database
+ * and write it as JSON when json_fname is not NULL
+ */
+int stats_DB(main_node_t **head, file_node_t *file_head, char *json_fname)
+{
+	long terms = 0, postings = 0, occurrences = 0, documents = 0;
+	long hist[HIST_BUCKETS] = {0};
+	int chain[SIZE], used = 0, longest = 0;
+
+	//walking every bucket and every posting list
+	for (int i = 0; i < SIZE; i++)
+	{
+		chain[i] = 0;
+		for (main_node_t *temp1 = head[i]; temp1; temp1 = temp1 -> link)
+		{
+			int len = 0;
+			for (sub_node_t *temp = temp1 -> sub_link; temp; temp = temp -> link)
+			{
+				len++;
+				occurrences += temp -> w_count;
+			}
+			postings += len;
+			hist[hist_bucket(len)]++;
+			chain[i]++;
+		}
+		terms += chain[i];
+		if (chain[i])
+			used++;
+		if (chain[i] > longest)
+			longest = chain[i];
+	}
+	for (file_node_t *temp = file_head; temp; temp = temp -> link)
+		documents++;
+
+	long main_bytes = terms * sizeof(main_node_t);
+	long sub_bytes = postings * sizeof(sub_node_t);
+	long file_bytes = documents * sizeof(file_node_t);
+	long table_bytes = SIZE * sizeof(main_node_t *);
+
+	printf(ORANGE"---------------- Database statistics ----------------\n");
+	printf(GREEN"Timings (s)   : "WHITE"tokenize %.6f  lookup %.6f  insert %.6f  save %.6f\n",
+			db_stats.t_tokenize, db_stats.t_lookup, db_stats.t_insert, db_stats.t_save);
+	printf(GREEN"Counts        : "WHITE"%ld document(s), %ld indexed, %ld token(s)\n", documents, db_stats.files_indexed, db_stats.tokens);
+	printf(GREEN"                "WHITE"%ld term(s), %ld posting(s), %ld occurrence(s)\n", terms, postings, occurrences);
+	printf(GREEN"Postings hist : "WHITE);
+	for (int b = 0; b < HIST_BUCKETS; b++)
+	{
+		int lo = b ? (1 << (b - 1)) + 1 : 1, hi = 1 << b;
+		if (b == HIST_BUCKETS - 1)
+			printf("[%d+]=%ld\n", lo, hist[b]);
+		else if (lo == hi)
+			printf("[%d]=%ld  ", lo, hist[b]);
+		else
+			printf("[%d-%d]=%ld  ", lo, hi, hist[b]);
+	}
+	printf(GREEN"Buckets       : "WHITE"%d/%d used, longest chain %d, load %.2f\n", used, SIZE, longest, (double)terms / SIZE);
+	for (int i = 0; i < SIZE; i++)
+		if (chain[i])
+			printf(YELLOW"[%d]"WHITE"%d ", i, chain[i]);
+	printf("\n");
+	printf(GREEN"Memory (bytes): "WHITE"table %ld  main nodes %ld  sub nodes %ld  file nodes %ld  total %ld\n",
+			table_bytes, main_bytes, sub_bytes, file_bytes, table_bytes + main_bytes + sub_bytes + file_bytes);
+
+	if (json_fname == NULL)
+		return SUCCESS;
+
+	FILE *fptr = fopen(json_fname, "w");
+	if (fptr == NULL)
+	{
+		printf(RED"Error : Unable to open %s\n", json_fname);
+		return FAILURE;
+	}
+	fprintf(fptr, "{\n  \"timings\": {\"tokenize\": %.9f, \"lookup\": %.9f, \"insert\": %.9f, \"save\": %.9f},\n",
+			db_stats.t_tokenize, db_stats.t_lookup, db_stats.t_insert, db_stats.t_save);
+	fprintf(fptr, "  \"counts\": {\"documents\": %ld, \"indexed\": %ld, \"tokens\": %ld, \"terms\": %ld, \"postings\": %ld, \"occurrences\": %ld},\n",
+			documents, db_stats.files_indexed, db_stats.tokens, terms, postings, occurrences);
+	fprintf(fptr, "  \"postings_histogram\": [");
+	for (int b = 0; b < HIST_BUCKETS; b++)
+		fprintf(fptr, "%s%ld", b ? ", " : "", hist[b]);
+	fprintf(fptr, "],\n  \"buckets\": {\"size\": %d, \"used\": %d, \"longest\": %d, \"chains\": [", SIZE, used, longest);
+	for (int i = 0; i < SIZE; i++)
+		fprintf(fptr, "%s%d", i ? ", " : "", chain[i]);
+	fprintf(fptr, "]},\n  \"bytes\": {\"table\": %ld, \"main_nodes\": %ld, \"sub_nodes\": %ld, \"file_nodes\": %ld}\n}\n",
+			table_bytes, main_bytes, sub_bytes, file_bytes);
+	fclose(fptr);
+	printf(CYAN"Successfull : Statistics saved in %s file\n", json_fname);
+	return SUCCESS;
+}
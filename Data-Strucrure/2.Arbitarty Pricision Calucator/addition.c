@@ -1,6 +1,7 @@
 /*******************************************************************************************************************************************************************
 *Title			: Addition
 *Description		: This function performs addition of two given large numbers and store the result in the resultant list.
+			: The lists are packed into base 10^9 limb vectors (bigint_t) and the limb kernel does the work.
 *Prototype		: int addition(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
 *Input Parameters	: head1: Pointer to the first node of the first double linked list.
 			: tail1: Pointer to the last node of the first double linked list.
@@ -11,7 +12,101 @@
 *******************************************************************************************************************************************************************/
 #include "apc.h"
 
+/*
+ * Limb kernel: r[0..n) = a[0..n) + b[0..n), returns the carry out.
+ * Two limbs below 10^9 plus a carry fit in 32 bits, so the carry is a compare
+ * and the correction a mask, both branch free.
+ */
+limb_t apc_add_n(limb_t *r, const limb_t *a, const limb_t *b, int n)
+{
+	limb_t carry = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		limb_t sum = a[i] + b[i] + carry;
+		carry = sum >= APC_BASE;
+		r[i] = sum - (-carry & APC_BASE);
+	}
+	return carry;
+}
+
+/* Limb kernel: r[0..n) = a[0..n) + carry, returns the carry out */
+limb_t apc_add_1(limb_t *r, const limb_t *a, int n, limb_t carry)
+{
+	int i = 0;
+
+	for (; i < n && carry; i++)
+	{
+		limb_t sum = a[i] + carry;
+		carry = sum >= APC_BASE;
+		r[i] = sum - (-carry & APC_BASE);
+	}
+	if (r != a)
+		for (; i < n; i++)
+			r[i] = a[i];
+	return carry;
+}
+
+/* r = |a| + |b|, the sign of r is left to the caller */
+int bigint_add_abs(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	if (a->size < b->size)
+	{
+		const bigint_t *temp = a;
+		a = b;
+		b = temp;
+	}
+	int n = a->size, m = b->size;
+
+	/* reserve first: r may alias a or b and move their limbs */
+	if (bigint_reserve(r, n + 1) == FAILURE)
+		return FAILURE;
+	limb_t carry = apc_add_n(r->limb, a->limb, b->limb, m);
+	carry = apc_add_1(r->limb + m, a->limb + m, n - m, carry);
+	r->limb[n] = carry;
+	r->size = n + carry;
+	return SUCCESS;
+}
+
+/* r = a + b_sign * |b|, shared by addition and subtraction */
+int bigint_add_sign(bigint_t *r, const bigint_t *a, const bigint_t *b, int b_sign)
+{
+	int a_sign = a->sign;
+
+	if (a_sign == b_sign)
+	{
+		if (bigint_add_abs(r, a, b) == FAILURE)
+			return FAILURE;
+		r->sign = a_sign;
+	}
+	else if (bigint_cmp_abs(a, b) >= 0)
+	{
+		if (bigint_sub_abs(r, a, b) == FAILURE)
+			return FAILURE;
+		r->sign = a_sign;
+	}
+	else
+	{
+		if (bigint_sub_abs(r, b, a) == FAILURE)
+			return FAILURE;
+		r->sign = b_sign;
+	}
+	bigint_normalize(r);
+	return SUCCESS;
+}
+
+int bigint_add(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	return bigint_add_sign(r, a, b, b->sign);
+}
+
+/* acc += x without allocating once acc has grown to its working size */
+int bigint_add_inplace(bigint_t *acc, const bigint_t *x)
+{
+	return bigint_add_sign(acc, acc, x, x->sign);
+}
+
 int addition(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR)
 {
-	/* Definition goes here */
+	return dlist_operation(bigint_add, head1, tail1, head2, tail2, headR);
 }
@@ -0,0 +1,122 @@
+/*******************************************************************************************************************************************************************
+*Title			: Limb memory pool
+*Description		: These functions hand out the limb buffers of big integers and the scratch space of the multiplication and division
+*			: engine. Sizes are rounded up to a power of two and a freed buffer goes onto a per thread free list of its size
+*			: class, so the next request of that class reuses it without a call to malloc() and without any locking. Each class
+*			: keeps a few buffers up to a few megabytes, bigger ones go straight back to the system. Counters of system
+*			: allocations and reused buffers let the benchmarks check how many allocations an operation really makes.
+*Prototype		: void *apc_alloc(size_t bytes);
+*			: void apc_release(void *ptr);
+*			: size_t apc_alloc_size(const void *ptr);
+*			: void apc_pool_trim(void);
+*			: void apc_alloc_stats(long *heap, long *reused);
+*Output			: Buffer / NULL when out of memory
+*******************************************************************************************************************************************************************/
+#include <stddef.h>
+#include "apc.h"
+
+/* Buffers are 2^class bytes including the header, cached for classes up to APC_POOL_MAX_CLASS */
+#ifndef APC_POOL_MAX_CLASS
+#define APC_POOL_MAX_CLASS 22
+#endif
+#ifndef APC_POOL_DEPTH
+#define APC_POOL_DEPTH 16
+#endif
+#define MIN_CLASS 6
+#define CLASSES 48
+
+/* Sits in front of every buffer and keeps the payload 16 byte aligned */
+typedef union header
+{
+	struct
+	{
+		int class;
+		union header *next;
+	}h;
+	max_align_t align;
+}header_t;
+
+static _Thread_local struct
+{
+	header_t *head[APC_POOL_MAX_CLASS + 1];
+	int count[APC_POOL_MAX_CLASS + 1];
+}cache;
+
+static atomic_long heap_allocs;
+static atomic_long reused_allocs;
+
+static int size_class(size_t bytes)
+{
+	int class = MIN_CLASS;
+
+	while (class < CLASSES && ((size_t)1 << class) < bytes + sizeof(header_t))
+		class++;
+	return class;
+}
+
+void *apc_alloc(size_t bytes)
+{
+	int class = size_class(bytes);
+	header_t *block;
+
+	if (class >= CLASSES)
+		return NULL;
+	if (class <= APC_POOL_MAX_CLASS && (block = cache.head[class]) != NULL)
+	{
+		cache.head[class] = block->h.next;
+		cache.count[class]--;
+		atomic_fetch_add_explicit(&reused_allocs, 1, memory_order_relaxed);
+		return block + 1;
+	}
+	if ((block = malloc((size_t)1 << class)) == NULL)
+		return NULL;
+	atomic_fetch_add_explicit(&heap_allocs, 1, memory_order_relaxed);
+	block->h.class = class;
+	return block + 1;
+}
+
+/* Return ptr to this thread's free list, or to the system when the list is full */
+void apc_release(void *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	header_t *block = (header_t *)ptr - 1;
+	int class = block->h.class;
+	if (class <= APC_POOL_MAX_CLASS && cache.count[class] < APC_POOL_DEPTH)
+	{
+		block->h.next = cache.head[class];
+		cache.head[class] = block;
+		cache.count[class]++;
+	}
+	else
+		free(block);
+}
+
+/* Usable bytes of a buffer from apc_alloc(), at least what was asked for */
+size_t apc_alloc_size(const void *ptr)
+{
+	return ((size_t)1 << ((const header_t *)ptr - 1)->h.class) - sizeof(header_t);
+}
+
+/* Free the buffers cached by the calling thread, run as threads exit */
+void apc_pool_trim(void)
+{
+	for (int class = 0; class <= APC_POOL_MAX_CLASS; class++)
+	{
+		while (cache.head[class])
+		{
+			header_t *next = cache.head[class]->h.next;
+			free(cache.head[class]);
+			cache.head[class] = next;
+		}
+		cache.count[class] = 0;
+	}
+}
+
+/* Buffers taken from malloc() and from the free lists so far, over all threads */
+void apc_alloc_stats(long *heap, long *reused)
+{
+	*heap = atomic_load(&heap_allocs);
+	*reused = atomic_load(&reused_allocs);
+}
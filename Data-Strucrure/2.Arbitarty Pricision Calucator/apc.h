@@ -1,5 +1,11 @@
 #ifndef APC_H
 #define APC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
 #define SUCCESS 0
 #define FAILURE -1
 
@@ -11,6 +17,244 @@ typedef struct node
 	struct node *next;
 }Dlist;
 
+/*
+ * Big integer: contiguous little-endian limbs in base 10^9.
+ * limb[0] is the least significant limb, size is 0 for zero
+ * and limb[size - 1] is never 0. sign is 1 or -1.
+ */
+#define APC_BASE 1000000000u
+#define APC_BASE_DIGITS 9
+
+/* Multiplication crossover points in limbs, run ./a.out -t to tune them for this machine */
+#ifndef APC_KARATSUBA_THRESHOLD
+#define APC_KARATSUBA_THRESHOLD 40
+#endif
+#ifndef APC_TOOM3_THRESHOLD
+#define APC_TOOM3_THRESHOLD 1000
+#endif
+#ifndef APC_NTT_THRESHOLD
+#define APC_NTT_THRESHOLD 1500
+#endif
+
+/* Divisor length in limbs from which division goes through a Newton reciprocal */
+#ifndef APC_NEWTON_THRESHOLD
+#define APC_NEWTON_THRESHOLD 150
+#endif
+
+/* Products with the smaller operand at or above this many limbs split their work over the thread pool */
+#ifndef APC_PARALLEL_THRESHOLD
+#define APC_PARALLEL_THRESHOLD 400
+#endif
+
+/* Limbs held inside bigint_t itself, enough for any long long, so small values never touch the heap */
+#define APC_INLINE_LIMBS 3
+
+/*
+ * limb points at small while alloc is APC_INLINE_LIMBS, and at a pooled buffer once the
+ * number outgrows it. A bigint_t moved by plain assignment must go through bigint_move().
+ */
+typedef uint32_t limb_t;
+typedef struct
+{
+	limb_t *limb;
+	int size;
+	int alloc;
+	int sign;
+	limb_t small[APC_INLINE_LIMBS];
+}bigint_t;
+
+/* Big decimal: the value mant * 10^exp, see decimal.c */
+typedef struct
+{
+	bigint_t mant;
+	long exp;
+}bigdec_t;
+
+/* Divisor prepared for repeated division: v = f b has its top limb >= B / 2, inv = floor(B^2m / v) */
+typedef struct
+{
+	bigint_t v;
+	bigint_t inv;
+	limb_t f;
+}bigint_divisor_t;
+
+/* Fork-join task for the thread pool, see pool.c */
+typedef struct
+{
+	void (*fn)(void *arg);
+	void *arg;
+	atomic_int done;
+}apc_task_t;
+
+/* Named variable, kept in a single linked list */
+typedef struct apc_var
+{
+	char *name;
+	bigdec_t value;
+	struct apc_var *next;
+}apc_var_t;
+
+/*
+ * Evaluation state kept across expressions: the variables and one temporary per tree level,
+ * so a batch of formulas reuses the same limb buffers instead of allocating per operation.
+ * precision 0 computes with integers, otherwise with decimals of that many digits.
+ */
+typedef struct
+{
+	apc_var_t *vars;
+	bigdec_t *temp;
+	int temp_count;
+	bigdec_t scratch;
+	int precision;
+	const char *error;
+	int column;
+}apc_env_t;
+
+/* Montgomery context for a modulus m of n limbs coprime to 10, with R = B^n */
+typedef struct
+{
+	bigint_t m;
+	int n;
+	limb_t minv;	/* -m^-1 mod B */
+	bigint_t r2;	/* R^2 mod m */
+	limb_t *t;	/* 2n + 1 limbs of product scratch */
+}apc_mont_t;
+
+typedef int (*bigint_op_t)(bigint_t *r, const bigint_t *a, const bigint_t *b);
+
 /* Include the prototypes here */
 
+/* Dlist helpers: one decimal digit per node, the sign travels on the head digit */
+int dl_insert_first(Dlist **head, Dlist **tail, data_t data);
+int dl_insert_last(Dlist **head, Dlist **tail, data_t data);
+void dl_delete_list(Dlist **head, Dlist **tail);
+int string_to_dlist(const char *str, Dlist **head, Dlist **tail);
+void print_list(Dlist *head);
+int dlist_operation(bigint_op_t op, Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
+
+/* Big integer storage and conversions */
+void bigint_init(bigint_t *a);
+void bigint_free(bigint_t *a);
+int bigint_reserve(bigint_t *a, int limbs);
+void bigint_normalize(bigint_t *a);
+void bigint_swap(bigint_t *a, bigint_t *b);
+void bigint_move(bigint_t *dst, bigint_t *src);
+int bigint_copy(bigint_t *dst, const bigint_t *src);
+int bigint_set_int(bigint_t *a, long long value);
+int bigint_is_zero(const bigint_t *a);
+int bigint_cmp_abs(const bigint_t *a, const bigint_t *b);
+int bigint_cmp(const bigint_t *a, const bigint_t *b);
+int bigint_shl_limbs(bigint_t *r, const bigint_t *a, int k);
+int bigint_shr_limbs(bigint_t *r, const bigint_t *a, int k);
+int bigint_from_string(bigint_t *a, const char *str);
+char *bigint_to_string(const bigint_t *a);
+int bigint_from_dlist(bigint_t *a, Dlist *head, Dlist *tail);
+int bigint_to_dlist(const bigint_t *a, Dlist **head, Dlist **tail);
+int bigint_from_hex(bigint_t *a, const char *str);
+char *bigint_to_hex(const bigint_t *a);
+uint32_t *bigint_to_words(const bigint_t *a, int *count);
+
+/* Limb and scratch buffers, recycled through a per thread pool */
+void *apc_alloc(size_t bytes);
+void apc_release(void *ptr);
+size_t apc_alloc_size(const void *ptr);
+void apc_pool_trim(void);
+void apc_alloc_stats(long *heap, long *reused);
+
+/* Limb kernels on equal length limb arrays, r may alias a or b */
+limb_t apc_add_n(limb_t *r, const limb_t *a, const limb_t *b, int n);
+limb_t apc_add_1(limb_t *r, const limb_t *a, int n, limb_t carry);
+limb_t apc_sub_n(limb_t *r, const limb_t *a, const limb_t *b, int n);
+limb_t apc_sub_1(limb_t *r, const limb_t *a, int n, limb_t borrow);
+limb_t apc_mul_1(limb_t *r, const limb_t *a, int n, limb_t d);
+limb_t apc_addmul_1(limb_t *r, const limb_t *a, int n, limb_t d);
+limb_t apc_divrem_1(limb_t *q, const limb_t *a, int n, limb_t d);
+
+/* Multiplication engine on limb arrays, r must not alias a or b */
+extern int apc_karatsuba_threshold;
+extern int apc_toom3_threshold;
+extern int apc_ntt_threshold;
+void apc_mul_basecase(limb_t *r, const limb_t *a, int n, const limb_t *b, int m);
+int apc_mul_ntt(limb_t *r, const limb_t *a, int n, const limb_t *b, int m);
+int apc_ntt_max_limbs(void);
+int apc_mul(limb_t *r, const limb_t *a, int n, const limb_t *b, int m);
+
+/* Magnitude helpers, bigint_sub_abs needs |a| >= |b| */
+int bigint_add_abs(bigint_t *r, const bigint_t *a, const bigint_t *b);
+int bigint_sub_abs(bigint_t *r, const bigint_t *a, const bigint_t *b);
+int bigint_add_sign(bigint_t *r, const bigint_t *a, const bigint_t *b, int b_sign);
+
+/* Big integer arithmetic, result may alias an operand */
+int bigint_add(bigint_t *r, const bigint_t *a, const bigint_t *b);
+int bigint_sub(bigint_t *r, const bigint_t *a, const bigint_t *b);
+int bigint_add_inplace(bigint_t *acc, const bigint_t *x);
+int bigint_sub_inplace(bigint_t *acc, const bigint_t *x);
+int bigint_mul(bigint_t *r, const bigint_t *a, const bigint_t *b);
+int bigint_mul_1(bigint_t *r, const bigint_t *a, limb_t d);
+int bigint_divrem(bigint_t *q, bigint_t *rem, const bigint_t *a, const bigint_t *b);
+int bigint_divrem_1(bigint_t *q, const bigint_t *a, limb_t d, limb_t *rem);
+int bigint_reciprocal(bigint_t *x, const bigint_t *v);
+int bigint_divisor_init(bigint_divisor_t *d, const bigint_t *b);
+void bigint_divisor_free(bigint_divisor_t *d);
+int bigint_divrem_pre(bigint_t *q, bigint_t *r, const bigint_t *a, const bigint_divisor_t *d);
+extern int apc_newton_threshold;
+
+/* Modular arithmetic, results in [0, m) */
+int apc_mont_init(apc_mont_t *ctx, const bigint_t *m);
+void apc_mont_free(apc_mont_t *ctx);
+int apc_mont_mul(apc_mont_t *ctx, bigint_t *r, const bigint_t *a, const bigint_t *b);
+int apc_mont_to(apc_mont_t *ctx, bigint_t *r, const bigint_t *a);
+int apc_mont_from(apc_mont_t *ctx, bigint_t *r, const bigint_t *a);
+int bigint_mod(bigint_t *r, const bigint_t *a, const bigint_t *m);
+int bigint_powmod(bigint_t *r, const bigint_t *base, const bigint_t *exp, const bigint_t *m);
+int bigint_invmod(bigint_t *r, const bigint_t *a, const bigint_t *m);
+
+/* Big decimals, results correctly rounded to prec significant digits */
+void bigdec_init(bigdec_t *a);
+void bigdec_free(bigdec_t *a);
+int bigdec_copy(bigdec_t *dst, const bigdec_t *src);
+void bigdec_swap(bigdec_t *a, bigdec_t *b);
+void bigdec_move(bigdec_t *dst, bigdec_t *src);
+long bigint_digits(const bigint_t *a);
+int bigdec_round(bigdec_t *r, const bigdec_t *a, int prec);
+int bigdec_to_bigint(bigint_t *r, const bigdec_t *a);
+int bigdec_from_string(bigdec_t *a, const char *str);
+char *bigdec_to_string(const bigdec_t *a);
+int bigdec_add(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+int bigdec_sub(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+int bigdec_mul(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+int bigdec_div(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+int bigdec_sqrt(bigdec_t *r, const bigdec_t *a, int prec);
+int bigint_sqrt(bigint_t *r, bigint_t *rem, const bigint_t *a);
+
+/* Constants pi, e and sqrt2 to digits significant digits, with the time of each stage */
+int apc_constant(bigdec_t *r, const char *name, int digits, double stage[3]);
+
+/* Thread pool */
+int apc_set_threads(int count);
+int apc_get_threads(void);
+void apc_spawn(apc_task_t *task, void (*fn)(void *), void *arg);
+void apc_wait(apc_task_t *task);
+void apc_parallel_for(int n, int grain, void (*fn)(void *ctx, int lo, int hi), void *ctx);
+extern int apc_parallel_threshold;
+
+/* Expression evaluator */
+void apc_env_init(apc_env_t *env);
+void apc_env_free(apc_env_t *env);
+int apc_eval_line(apc_env_t *env, const char *line, const bigdec_t **result);
+
+/* Benchmarks */
+double apc_now(void);
+int apc_tune(void);
+int apc_bench_threads(int max_threads);
+int apc_bench_modexp(void);
+int apc_bench_alloc(void);
+int apc_bench(int max_digits);
+
+/* Dlist entry points */
+int addition(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
+int subtraction(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
+int multiplication(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
+int division(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
+
 #endif
@@ -0,0 +1,364 @@
+/*******************************************************************************************************************************************************************
+*Title			: Benchmark and differential check
+*Description		: This function times addition, subtraction, multiplication, division and the decimal and hexadecimal conversions on
+*			: random operands of 10 up to max_digits decimal digits, growing tenfold, and prints the time per operation and the
+*			: operations per second for every size, so the rows trace a time versus size curve per operation. Every result is
+*			: checked before it is timed: against a slow reference that works digit by digit on decimal strings and shares no
+*			: code with the limb engine (up to REFERENCE_DIGITS digits), and at every size against identities such as
+*			: (a b + r) / b = a remainder r, (a + b) - b = a, a b mod p = (a mod p)(b mod p) mod p and string round trips.
+*			: Operands of all nines are checked too, they drive every carry and borrow as far as it goes.
+*Prototype		: int apc_bench(int max_digits);
+*Input Parameters	: max_digits: Largest operand size in decimal digits, up to 10^7 is practical.
+*Output			: Status (SUCCESS / FAILURE when a check fails)
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include "apc.h"
+
+/* Results are compared with the string reference up to this many digits, its products and quotients are quadratic */
+#define REFERENCE_DIGITS 10000
+#define BENCH_MIN_TIME 0.2
+#define CHECK_PRIME 999999937u
+
+enum
+{
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_TO_STRING,
+	OP_FROM_STRING,
+	OP_TO_HEX,
+	OP_FROM_HEX,
+	OP_COUNT
+};
+
+static const char *op_name[OP_COUNT] = {"add", "sub", "mul", "div", "to_dec", "from_dec", "to_hex", "from_hex"};
+
+/* Operands and results of one size, a has 2n digits for the division and n for the rest */
+typedef struct
+{
+	bigint_t a, b, half, r, q, rem, t;
+	char *dec;
+	char *hex;
+}bench_t;
+
+static uint64_t bench_state = 0x2545f4914f6cdd1dull;
+
+static unsigned next_digit(void)
+{
+	bench_state ^= bench_state << 13;
+	bench_state ^= bench_state >> 7;
+	bench_state ^= bench_state << 17;
+	return bench_state % 10;
+}
+
+/* Random decimal string of exactly n digits, or n nines */
+static char *random_digits(int n, int nines)
+{
+	char *str = malloc((size_t)n + 1);
+	if (str == NULL)
+		return NULL;
+	for (int i = 0; i < n; i++)
+		str[i] = nines ? '9' : '0' + next_digit();
+	if (str[0] == '0')
+		str[0] = '1';
+	str[n] = '\0';
+	return str;
+}
+
+/* Reference arithmetic on unsigned decimal strings, most significant digit first, no leading zeros */
+
+static char *ref_trim(char *buf, int len)
+{
+	int start = 0;
+	while (start < len - 1 && buf[start] == '0')
+		start++;
+	memmove(buf, buf + start, len - start);
+	buf[len - start] = '\0';
+	return buf;
+}
+
+static int ref_cmp(const char *a, const char *b)
+{
+	size_t la = strlen(a), lb = strlen(b);
+	if (la != lb)
+		return la < lb ? -1 : 1;
+	int c = strcmp(a, b);
+	return (c > 0) - (c < 0);
+}
+
+static char *ref_add(const char *a, const char *b)
+{
+	int la = strlen(a), lb = strlen(b), len = (la > lb ? la : lb) + 1, carry = 0;
+	char *r = malloc((size_t)len + 1);
+	if (r == NULL)
+		return NULL;
+	for (int i = 0; i < len; i++)
+	{
+		int d = carry + (i < la ? a[la - 1 - i] - '0' : 0) + (i < lb ? b[lb - 1 - i] - '0' : 0);
+		r[len - 1 - i] = '0' + d % 10;
+		carry = d / 10;
+	}
+	return ref_trim(r, len);
+}
+
+/* a - b for a >= b */
+static char *ref_sub(const char *a, const char *b)
+{
+	int la = strlen(a), lb = strlen(b), borrow = 0;
+	char *r = malloc((size_t)la + 1);
+	if (r == NULL)
+		return NULL;
+	for (int i = 0; i < la; i++)
+	{
+		int d = a[la - 1 - i] - '0' - borrow - (i < lb ? b[lb - 1 - i] - '0' : 0);
+		borrow = d < 0;
+		r[la - 1 - i] = '0' + d + 10 * borrow;
+	}
+	return ref_trim(r, la);
+}
+
+static char *ref_mul(const char *a, const char *b)
+{
+	int la = strlen(a), lb = strlen(b), len = la + lb;
+	int *col = calloc(len, sizeof(int));
+	char *r = malloc((size_t)len + 1);
+	if (col == NULL || r == NULL)
+	{
+		free(col);
+		free(r);
+		return NULL;
+	}
+	for (int i = la - 1; i >= 0; i--)
+	{
+		int carry = 0, d = a[i] - '0';
+		for (int j = lb - 1; j >= 0; j--)
+		{
+			int t = col[i + j + 1] + d * (b[j] - '0') + carry;
+			col[i + j + 1] = t % 10;
+			carry = t / 10;
+		}
+		col[i] += carry;
+	}
+	for (int i = 0; i < len; i++)
+		r[i] = '0' + col[i];
+	free(col);
+	return ref_trim(r, len);
+}
+
+/* Long division a / b, one quotient digit at a time by repeated subtraction, the remainder goes to *rem */
+static char *ref_divrem(const char *a, const char *b, char **rem)
+{
+	int la = strlen(a);
+	char *q = malloc((size_t)la + 1), *r = malloc((size_t)la + 2);
+	if (q == NULL || r == NULL)
+	{
+		free(q);
+		free(r);
+		return NULL;
+	}
+	strcpy(r, "0");
+	for (int i = 0; i < la; i++)
+	{
+		/* r = 10 r + a[i] */
+		size_t lr = strlen(r);
+		if (lr == 1 && r[0] == '0')
+			lr = 0;
+		r[lr] = a[i];
+		r[lr + 1] = '\0';
+		ref_trim(r, lr + 1);
+
+		int d = 0;
+		while (ref_cmp(r, b) >= 0)
+		{
+			char *next = ref_sub(r, b);
+			if (next == NULL)
+			{
+				free(q);
+				free(r);
+				return NULL;
+			}
+			strcpy(r, next);
+			free(next);
+			d++;
+		}
+		q[i] = '0' + d;
+	}
+	*rem = r;
+	return ref_trim(q, la);
+}
+
+/* Compare a big integer with a reference string, the sign given separately */
+static int same(const bigint_t *x, const char *ref, int negative)
+{
+	char *str = bigint_to_string(x);
+	int equal = str && (negative ? str[0] == '-' && strcmp(str + 1, ref) == 0 : strcmp(str, ref) == 0);
+	free(str);
+	return equal;
+}
+
+static int check_reference(bench_t *s, const char *a, const char *b, const char *half)
+{
+	char *sum = ref_add(a, b), *diff = NULL, *prod = ref_mul(a, b), *rem = NULL, *quot = NULL;
+	int negative = ref_cmp(a, b) < 0, ok = 0;
+
+	diff = negative ? ref_sub(b, a) : ref_sub(a, b);
+	quot = ref_divrem(s->dec, half, &rem);
+	if (sum && diff && prod && quot &&
+			bigint_add(&s->r, &s->a, &s->b) == SUCCESS && same(&s->r, sum, 0) &&
+			bigint_sub(&s->r, &s->a, &s->b) == SUCCESS && same(&s->r, diff, negative && strcmp(diff, "0")) &&
+			bigint_mul(&s->r, &s->a, &s->b) == SUCCESS && same(&s->r, prod, 0) &&
+			bigint_divrem(&s->q, &s->rem, &s->t, &s->half) == SUCCESS && same(&s->q, quot, 0) && same(&s->rem, rem, 0))
+		ok = 1;
+	free(sum);
+	free(diff);
+	free(prod);
+	free(quot);
+	free(rem);
+	return ok;
+}
+
+/* |x| mod CHECK_PRIME */
+static limb_t mod_prime(const bigint_t *x)
+{
+	bigint_t q;
+	limb_t rem = 0;
+
+	bigint_init(&q);
+	bigint_divrem_1(&q, x, CHECK_PRIME, &rem);
+	bigint_free(&q);
+	return rem;
+}
+
+/* Identities that hold at any size, with t the 2n digit dividend */
+static int check_identities(bench_t *s)
+{
+	char *str;
+	int ok;
+
+	/* (a + b) - b = a */
+	if (bigint_add(&s->r, &s->a, &s->b) == FAILURE || bigint_sub(&s->r, &s->r, &s->b) == FAILURE || bigint_cmp(&s->r, &s->a))
+		return 0;
+	/* a b mod p = (a mod p)(b mod p) mod p */
+	if (bigint_mul(&s->r, &s->a, &s->b) == FAILURE ||
+			mod_prime(&s->r) != (uint64_t)mod_prime(&s->a) * mod_prime(&s->b) % CHECK_PRIME)
+		return 0;
+	/* (a b + rem) / b = a remainder rem, for the rem of t / b */
+	if (bigint_divrem(&s->q, &s->rem, &s->t, &s->b) == FAILURE || bigint_cmp_abs(&s->rem, &s->b) >= 0 ||
+			bigint_add(&s->r, &s->r, &s->rem) == FAILURE || bigint_divrem(&s->q, &s->t, &s->r, &s->b) == FAILURE ||
+			bigint_cmp(&s->q, &s->a) || bigint_cmp(&s->t, &s->rem))
+		return 0;
+	/* t = q half + rem, rebuilt from the quotient and remainder of the timed division */
+	if (bigint_from_string(&s->t, s->dec) == FAILURE || bigint_divrem(&s->q, &s->rem, &s->t, &s->half) == FAILURE ||
+			bigint_mul(&s->r, &s->q, &s->half) == FAILURE || bigint_add(&s->r, &s->r, &s->rem) == FAILURE ||
+			bigint_cmp(&s->r, &s->t) || bigint_cmp_abs(&s->rem, &s->half) >= 0)
+		return 0;
+	/* Decimal and hexadecimal round trips */
+	str = bigint_to_string(&s->t);
+	ok = str && strcmp(str, s->dec) == 0;
+	free(str);
+	if (!ok || (str = bigint_to_hex(&s->t)) == NULL)
+		return 0;
+	ok = bigint_from_hex(&s->r, str) == SUCCESS && bigint_cmp(&s->r, &s->t) == 0;
+	free(s->hex);
+	s->hex = str;
+	return ok;
+}
+
+static int run_op(bench_t *s, int op)
+{
+	char *str;
+
+	switch (op)
+	{
+		case OP_ADD:
+			return bigint_add(&s->r, &s->a, &s->b);
+		case OP_SUB:
+			return bigint_sub(&s->r, &s->a, &s->b);
+		case OP_MUL:
+			return bigint_mul(&s->r, &s->a, &s->b);
+		case OP_DIV:
+			return bigint_divrem(&s->q, &s->rem, &s->t, &s->half);
+		case OP_TO_STRING:
+		case OP_TO_HEX:
+			str = op == OP_TO_STRING ? bigint_to_string(&s->t) : bigint_to_hex(&s->t);
+			free(str);
+			return str ? SUCCESS : FAILURE;
+		case OP_FROM_STRING:
+			return bigint_from_string(&s->r, s->dec);
+		default:
+			return bigint_from_hex(&s->r, s->hex);
+	}
+}
+
+/* Set up operands of n digits (2n for the dividend) and check every operation on them */
+static int prepare(bench_t *s, int n, int nines)
+{
+	char *a = random_digits(n, nines), *b = random_digits(n, nines), *half = random_digits(n - n / 2, nines);
+	int ok = 0;
+
+	free(s->dec);
+	s->dec = random_digits(2 * n, nines);
+	if (a && b && half && s->dec && bigint_from_string(&s->a, a) == SUCCESS && bigint_from_string(&s->b, b) == SUCCESS &&
+			bigint_from_string(&s->half, half) == SUCCESS && bigint_from_string(&s->t, s->dec) == SUCCESS)
+	{
+		ok = n > REFERENCE_DIGITS || check_reference(s, a, b, half);
+		if (ok)
+			ok = check_identities(s);
+	}
+	free(a);
+	free(b);
+	free(half);
+	return ok;
+}
+
+int apc_bench(int max_digits)
+{
+	bench_t s;
+	bigint_t *all[] = {&s.a, &s.b, &s.half, &s.r, &s.q, &s.rem, &s.t};
+	int status = SUCCESS;
+
+	if (max_digits < 10)
+		return FAILURE;
+	for (int i = 0; i < 7; i++)
+		bigint_init(all[i]);
+	s.dec = s.hex = NULL;
+
+	printf("%10s %10s %8s %14s %14s\n", "digits", "operation", "reps", "time (ms)", "ops/s");
+	for (long n = 10; n <= max_digits && status == SUCCESS; n *= 10)
+	{
+		if (!prepare(&s, n, 1) || !prepare(&s, n, 0))
+		{
+			printf("Error: check failed at %ld digits\n", n);
+			status = FAILURE;
+			break;
+		}
+		for (int op = 0; op < OP_COUNT; op++)
+		{
+			int reps = 0;
+			double start = apc_now(), elapsed;
+			do
+			{
+				if (run_op(&s, op) == FAILURE)
+				{
+					printf("Error: %s failed at %ld digits\n", op_name[op], n);
+					status = FAILURE;
+					break;
+				}
+				reps++;
+				elapsed = apc_now() - start;
+			}while (elapsed < BENCH_MIN_TIME);
+			if (status == FAILURE)
+				break;
+			printf("%10ld %10s %8d %14.4f %14.1f\n", n, op_name[op], reps, elapsed * 1e3 / reps, reps / elapsed);
+		}
+	}
+	if (status == SUCCESS)
+		printf("All results match the reference and the identities\n");
+
+	for (int i = 0; i < 7; i++)
+		bigint_free(all[i]);
+	free(s.dec);
+	free(s.hex);
+	return status;
+}
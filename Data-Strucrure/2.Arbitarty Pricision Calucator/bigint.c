@@ -0,0 +1,288 @@
+/*******************************************************************************************************************************************************************
+*Title			: Big integer storage
+*Description		: These functions manage the contiguous base 10^9 limb vector of a bigint_t and convert it to and from decimal strings
+*			: and one digit per node double linked lists. Up to APC_INLINE_LIMBS limbs live inside the bigint_t, longer vectors
+*			: come from the limb pool, and bigint_move() hands a vector over without copying it.
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "apc.h"
+
+void bigint_init(bigint_t *a)
+{
+	a->limb = a->small;
+	a->size = 0;
+	a->alloc = APC_INLINE_LIMBS;
+	a->sign = 1;
+}
+
+void bigint_free(bigint_t *a)
+{
+	if (a->limb != a->small)
+		apc_release(a->limb);
+	bigint_init(a);
+}
+
+/* Point an inline number back at its own storage after the struct was moved */
+static void rebind(bigint_t *a)
+{
+	if (a->alloc == APC_INLINE_LIMBS)
+		a->limb = a->small;
+}
+
+/* Make room for at least limbs limbs, growing geometrically so accumulators do not reallocate every step */
+int bigint_reserve(bigint_t *a, int limbs)
+{
+	if (limbs <= a->alloc)
+		return SUCCESS;
+	if (limbs < 2 * a->alloc)
+		limbs = 2 * a->alloc;
+
+	limb_t *new = apc_alloc((size_t)limbs * sizeof(limb_t));
+	if (new == NULL)
+		return FAILURE;
+	memcpy(new, a->limb, (size_t)a->alloc * sizeof(limb_t));
+	if (a->limb != a->small)
+		apc_release(a->limb);
+	size_t usable = apc_alloc_size(new) / sizeof(limb_t);
+	a->limb = new;
+	a->alloc = usable < INT_MAX ? (int)usable : INT_MAX;
+	return SUCCESS;
+}
+
+/* Drop the zero limbs at the top, zero is always positive */
+void bigint_normalize(bigint_t *a)
+{
+	while (a->size > 0 && a->limb[a->size - 1] == 0)
+		a->size--;
+	if (a->size == 0)
+		a->sign = 1;
+}
+
+void bigint_swap(bigint_t *a, bigint_t *b)
+{
+	bigint_t temp = *a;
+	*a = *b;
+	*b = temp;
+	rebind(a);
+	rebind(b);
+}
+
+/* dst takes over the value and buffer of src, which is left zero */
+void bigint_move(bigint_t *dst, bigint_t *src)
+{
+	if (dst == src)
+		return;
+	bigint_free(dst);
+	*dst = *src;
+	rebind(dst);
+	bigint_init(src);
+}
+
+int bigint_copy(bigint_t *dst, const bigint_t *src)
+{
+	if (dst == src)
+		return SUCCESS;
+	if (bigint_reserve(dst, src->size) == FAILURE)
+		return FAILURE;
+	if (src->size)
+		memcpy(dst->limb, src->limb, (size_t)src->size * sizeof(limb_t));
+	dst->size = src->size;
+	dst->sign = src->sign;
+	return SUCCESS;
+}
+
+int bigint_set_int(bigint_t *a, long long value)
+{
+	unsigned long long mag = value < 0 ? -(unsigned long long)value : (unsigned long long)value;
+
+	if (bigint_reserve(a, 3) == FAILURE)
+		return FAILURE;
+	a->size = 0;
+	while (mag)
+	{
+		a->limb[a->size++] = mag % APC_BASE;
+		mag /= APC_BASE;
+	}
+	a->sign = value < 0 ? -1 : 1;
+	bigint_normalize(a);
+	return SUCCESS;
+}
+
+int bigint_is_zero(const bigint_t *a)
+{
+	return a->size == 0;
+}
+
+/* Compare magnitudes, returns -1, 0 or 1 */
+int bigint_cmp_abs(const bigint_t *a, const bigint_t *b)
+{
+	if (a->size != b->size)
+		return a->size < b->size ? -1 : 1;
+	for (int i = a->size - 1; i >= 0; i--)
+		if (a->limb[i] != b->limb[i])
+			return a->limb[i] < b->limb[i] ? -1 : 1;
+	return 0;
+}
+
+/* Compare signed values, returns -1, 0 or 1 */
+int bigint_cmp(const bigint_t *a, const bigint_t *b)
+{
+	if (a->sign != b->sign)
+		return a->sign < b->sign ? -1 : 1;
+	return a->sign * bigint_cmp_abs(a, b);
+}
+
+/* r = a * B^k, shifting whole limbs up */
+int bigint_shl_limbs(bigint_t *r, const bigint_t *a, int k)
+{
+	if (a->size == 0)
+		return bigint_set_int(r, 0);
+	if (bigint_reserve(r, a->size + k) == FAILURE)
+		return FAILURE;
+	memmove(r->limb + k, a->limb, (size_t)a->size * sizeof(limb_t));
+	memset(r->limb, 0, (size_t)k * sizeof(limb_t));
+	r->size = a->size + k;
+	r->sign = a->sign;
+	return SUCCESS;
+}
+
+/* r = a / B^k truncated toward zero, dropping the k low limbs */
+int bigint_shr_limbs(bigint_t *r, const bigint_t *a, int k)
+{
+	if (a->size <= k)
+		return bigint_set_int(r, 0);
+	if (bigint_reserve(r, a->size - k) == FAILURE)
+		return FAILURE;
+	memmove(r->limb, a->limb + k, (size_t)(a->size - k) * sizeof(limb_t));
+	r->size = a->size - k;
+	r->sign = a->sign;
+	return SUCCESS;
+}
+
+/* Parse an optionally signed decimal string, nine digits per limb */
+int bigint_from_string(bigint_t *a, const char *str)
+{
+	int sign = 1;
+
+	if (*str == '-' || *str == '+')
+		sign = (*str++ == '-') ? -1 : 1;
+	if (*str == '\0')
+		return FAILURE;
+	while (*str == '0')
+		str++;
+
+	int len = strlen(str);
+	for (int i = 0; i < len; i++)
+		if (!isdigit((unsigned char)str[i]))
+			return FAILURE;
+
+	if (bigint_reserve(a, (len + APC_BASE_DIGITS - 1) / APC_BASE_DIGITS) == FAILURE)
+		return FAILURE;
+	a->size = 0;
+	for (int end = len; end > 0; end -= APC_BASE_DIGITS)
+	{
+		int start = end > APC_BASE_DIGITS ? end - APC_BASE_DIGITS : 0;
+		limb_t value = 0;
+		for (int i = start; i < end; i++)
+			value = value * 10 + (str[i] - '0');
+		a->limb[a->size++] = value;
+	}
+	a->sign = sign;
+	bigint_normalize(a);
+	return SUCCESS;
+}
+
+/* Return a malloc'd decimal string of a, NULL when out of memory */
+char *bigint_to_string(const bigint_t *a)
+{
+	if (a->size == 0)
+	{
+		char *str = malloc(2);
+		if (str)
+			strcpy(str, "0");
+		return str;
+	}
+
+	char top[APC_BASE_DIGITS + 1];
+	int top_len = snprintf(top, sizeof(top), "%u", a->limb[a->size - 1]);
+	size_t len = (a->sign < 0) + top_len + (size_t)(a->size - 1) * APC_BASE_DIGITS;
+	char *str = malloc(len + 1);
+	if (str == NULL)
+		return NULL;
+
+	char *ptr = str;
+	if (a->sign < 0)
+		*ptr++ = '-';
+	memcpy(ptr, top, top_len);
+	ptr += top_len;
+	for (int i = a->size - 2; i >= 0; i--)
+	{
+		limb_t value = a->limb[i];
+		for (int j = APC_BASE_DIGITS - 1; j >= 0; j--)
+		{
+			ptr[j] = '0' + value % 10;
+			value /= 10;
+		}
+		ptr += APC_BASE_DIGITS;
+	}
+	*ptr = '\0';
+	return str;
+}
+
+/* Pack the digits of a list, walking from the least significant tail node */
+int bigint_from_dlist(bigint_t *a, Dlist *head, Dlist *tail)
+{
+	int digits = 0;
+
+	for (Dlist *temp = head; temp; temp = temp->next)
+		digits++;
+	if (bigint_reserve(a, (digits + APC_BASE_DIGITS - 1) / APC_BASE_DIGITS) == FAILURE)
+		return FAILURE;
+
+	a->size = 0;
+	a->sign = (head && head->data < 0) ? -1 : 1;
+	while (tail)
+	{
+		limb_t value = 0, scale = 1;
+		for (int i = 0; i < APC_BASE_DIGITS && tail; i++, tail = tail->prev)
+		{
+			int digit = tail->data < 0 ? -tail->data : tail->data;
+			if (digit > 9)
+				return FAILURE;
+			value += digit * scale;
+			scale *= 10;
+		}
+		a->limb[a->size++] = value;
+	}
+	bigint_normalize(a);
+	return SUCCESS;
+}
+
+/* Unpack a into a new list, one digit per node, most significant digit at head */
+int bigint_to_dlist(const bigint_t *a, Dlist **head, Dlist **tail)
+{
+	*head = *tail = NULL;
+	if (a->size == 0)
+		return dl_insert_first(head, tail, 0);
+
+	for (int i = 0; i < a->size; i++)
+	{
+		limb_t value = a->limb[i];
+		for (int j = 0; j < APC_BASE_DIGITS; j++)
+		{
+			if (i == a->size - 1 && value == 0)
+				break;
+			if (dl_insert_first(head, tail, value % 10) == FAILURE)
+			{
+				dl_delete_list(head, tail);
+				return FAILURE;
+			}
+			value /= 10;
+		}
+	}
+	if (a->sign < 0)
+		(*head)->data = -(*head)->data;
+	return SUCCESS;
+}
@@ -0,0 +1,247 @@
+/*******************************************************************************************************************************************************************
+*Title			: Constants
+*Description		: These functions compute pi, e and sqrt(2) to a given number of significant digits. pi sums the Chudnovsky series
+*			: and e the series of 1 / k!, both by binary splitting: the terms of a range fold into a few big integers P, Q, T
+*			: through products of balanced size, which is where the fast multiplication pays off, and the two halves of a
+*			: large range are evaluated on the thread pool at the same time. One big division (and for pi a square root)
+*			: turns the integers into decimals. sqrt(2) is a single Newton square root. The time of every stage is reported,
+*			: so a run doubles as an end to end benchmark of multiplication, division and radix conversion.
+*Prototype		: int apc_constant(bigdec_t *r, const char *name, int digits, double stage[3]);
+*Input Parameters	: name: "pi", "e" or "sqrt2".
+*			: digits: Significant digits of the result.
+*			: stage: Seconds spent in the series, in the final division and square root, and left for the caller's conversion.
+*Output			: Status (SUCCESS / FAILURE)
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include "apc.h"
+
+/* Ranges of at least this many terms split their halves over the thread pool */
+#define SPLIT_PARALLEL_TERMS 256
+#define GUARD_DIGITS 10
+
+/* 640320^3 / 24 */
+#define CHUDNOVSKY_C3_24 10939058860032000ll
+
+/* Sums of the series over the terms [a, b) */
+typedef struct split
+{
+	long a;
+	long b;
+	int need_p;
+	int status;
+	bigint_t p;
+	bigint_t q;
+	bigint_t t;
+}split_t;
+
+static void split_init(split_t *s, long a, long b, int need_p)
+{
+	s->a = a;
+	s->b = b;
+	s->need_p = need_p;
+	s->status = FAILURE;
+	bigint_init(&s->p);
+	bigint_init(&s->q);
+	bigint_init(&s->t);
+}
+
+static void split_free(split_t *s)
+{
+	bigint_free(&s->p);
+	bigint_free(&s->q);
+	bigint_free(&s->t);
+}
+
+/*
+ * Chudnovsky term a: p = (6a - 5)(2a - 1)(6a - 1), q = a^3 C^3 / 24,
+ * t = (-1)^a p (13591409 + 545140134 a), with p = q = 1 for a = 0
+ */
+static int chudnovsky_leaf(split_t *s)
+{
+	long a = s->a;
+
+	if (a == 0)
+	{
+		if (bigint_set_int(&s->p, 1) == FAILURE || bigint_set_int(&s->q, 1) == FAILURE)
+			return FAILURE;
+	}
+	else if (bigint_set_int(&s->p, (6ll * a - 5) * (2 * a - 1)) == FAILURE || bigint_mul_1(&s->p, &s->p, 6 * a - 1) == FAILURE ||
+			bigint_set_int(&s->q, (long long)a * a) == FAILURE || bigint_mul_1(&s->q, &s->q, a) == FAILURE ||
+			bigint_set_int(&s->t, CHUDNOVSKY_C3_24) == FAILURE || bigint_mul(&s->q, &s->q, &s->t) == FAILURE)
+		return FAILURE;
+
+	if (bigint_set_int(&s->t, 13591409 + 545140134ll * a) == FAILURE || bigint_mul(&s->t, &s->t, &s->p) == FAILURE)
+		return FAILURE;
+	if (a % 2 && s->t.size)
+		s->t.sign = -1;
+	return SUCCESS;
+}
+
+/* e, term a: q = a + 1 and t = 1, so that t / q over [a, b) is the sum of 1 / ((a + 1) ... k) for k in (a, b] */
+static int e_leaf(split_t *s)
+{
+	return bigint_set_int(&s->q, s->a + 1) == FAILURE || bigint_set_int(&s->t, 1) == FAILURE ? FAILURE : SUCCESS;
+}
+
+/* Which series a split belongs to, passed down the recursion */
+static int (*split_leaf)(split_t *s);
+
+static void split_run(void *arg);
+
+/*
+ * P = P1 P2, Q = Q1 Q2, T = T1 Q2 + P1 T2. For e every leaf has P = 1, so P stays 1 and
+ * T = T1 Q2 + T2. The right half runs on the pool while this thread does the left one.
+ */
+static int split_range(split_t *s)
+{
+	if (s->b - s->a == 1)
+		return split_leaf(s);
+
+	long mid = s->a + (s->b - s->a) / 2;
+	split_t left, right;
+	apc_task_t task;
+	int status = FAILURE, chudnovsky = split_leaf == chudnovsky_leaf;
+
+	split_init(&left, s->a, mid, 1);
+	split_init(&right, mid, s->b, s->need_p);
+	if (s->b - s->a >= SPLIT_PARALLEL_TERMS)
+	{
+		apc_spawn(&task, split_run, &right);
+		left.status = split_range(&left);
+		apc_wait(&task);
+	}
+	else
+	{
+		left.status = split_range(&left);
+		right.status = split_range(&right);
+	}
+	if (left.status == FAILURE || right.status == FAILURE)
+		goto out;
+
+	if (bigint_mul(&s->t, &left.t, &right.q) == FAILURE)
+		goto out;
+	if (chudnovsky)
+	{
+		if (bigint_mul(&right.t, &left.p, &right.t) == FAILURE || bigint_add(&s->t, &s->t, &right.t) == FAILURE)
+			goto out;
+		if (s->need_p && bigint_mul(&s->p, &left.p, &right.p) == FAILURE)
+			goto out;
+	}
+	else if (bigint_add(&s->t, &s->t, &right.t) == FAILURE)
+		goto out;
+	status = bigint_mul(&s->q, &left.q, &right.q);
+out:
+	split_free(&left);
+	split_free(&right);
+	return status;
+}
+
+static void split_run(void *arg)
+{
+	split_t *s = arg;
+	s->status = split_range(s);
+}
+
+/* pi = 426880 sqrt(10005) Q / T over the first terms, each term adds 14.18 digits */
+static int compute_pi(bigdec_t *r, int digits, double stage[3])
+{
+	int prec = digits + GUARD_DIGITS, status = FAILURE;
+	split_t s;
+	bigdec_t x, y;
+
+	split_leaf = chudnovsky_leaf;
+	split_init(&s, 0, (long)(prec / 14.181647462725477) + 2, 0);
+	bigdec_init(&x);
+	bigdec_init(&y);
+
+	double start = apc_now();
+	if (split_range(&s) == FAILURE)
+		goto out;
+	stage[0] = apc_now() - start;
+
+	/* Q and T run to a few times prec digits, rounding them first keeps the division at prec */
+	start = apc_now();
+	bigint_move(&x.mant, &s.q);
+	bigint_move(&y.mant, &s.t);
+	if (bigdec_round(&x, &x, prec) == FAILURE || bigdec_round(&y, &y, prec) == FAILURE || bigdec_div(&x, &x, &y, prec) == FAILURE)
+		goto out;
+	if (bigint_set_int(&y.mant, 10005) == FAILURE || (y.exp = 0, bigdec_sqrt(&y, &y, prec)) == FAILURE ||
+			bigint_mul_1(&y.mant, &y.mant, 426880) == FAILURE || bigdec_mul(&x, &x, &y, prec) == FAILURE ||
+			bigdec_round(r, &x, digits) == FAILURE)
+		goto out;
+	stage[1] = apc_now() - start;
+	status = SUCCESS;
+out:
+	split_free(&s);
+	bigdec_free(&x);
+	bigdec_free(&y);
+	return status;
+}
+
+/* e = 1 + T / Q over the terms up to N, with N! > 10^prec */
+static int compute_e(bigdec_t *r, int digits, double stage[3])
+{
+	int prec = digits + GUARD_DIGITS, status = FAILURE;
+	long n = 1, factorial_digits = 0;
+	double factorial = 1;
+	split_t s;
+	bigdec_t x, y;
+
+	/* n! kept as factorial 10^factorial_digits with 1 <= factorial < 10 */
+	while (factorial_digits <= prec)
+	{
+		factorial *= ++n;
+		while (factorial >= 10)
+		{
+			factorial /= 10;
+			factorial_digits++;
+		}
+	}
+
+	split_leaf = e_leaf;
+	split_init(&s, 0, n, 0);
+	bigdec_init(&x);
+	bigdec_init(&y);
+
+	double start = apc_now();
+	if (split_range(&s) == FAILURE)
+		goto out;
+	stage[0] = apc_now() - start;
+
+	start = apc_now();
+	if (bigint_add(&s.t, &s.t, &s.q) == FAILURE)
+		goto out;
+	bigint_move(&x.mant, &s.t);
+	bigint_move(&y.mant, &s.q);
+	if (bigdec_div(&x, &x, &y, prec) == FAILURE || bigdec_round(r, &x, digits) == FAILURE)
+		goto out;
+	stage[1] = apc_now() - start;
+	status = SUCCESS;
+out:
+	split_free(&s);
+	bigdec_free(&x);
+	bigdec_free(&y);
+	return status;
+}
+
+int apc_constant(bigdec_t *r, const char *name, int digits, double stage[3])
+{
+	stage[0] = stage[1] = stage[2] = 0;
+	if (digits < 1)
+		return FAILURE;
+	if (strcmp(name, "pi") == 0)
+		return compute_pi(r, digits, stage);
+	if (strcmp(name, "e") == 0)
+		return compute_e(r, digits, stage);
+	if (strcmp(name, "sqrt2") == 0)
+	{
+		double start = apc_now();
+		bigdec_t two;
+		bigdec_init(&two);
+		int status = bigint_set_int(&two.mant, 2) == FAILURE ? FAILURE : bigdec_sqrt(r, &two, digits);
+		bigdec_free(&two);
+		stage[1] = apc_now() - start;
+		return status;
+	}
+	return FAILURE;
+}
@@ -0,0 +1,492 @@
+/*******************************************************************************************************************************************************************
+*Title			: Big decimals
+*Description		: These functions compute with decimal numbers mant * 10^exp, where the mantissa is a big integer, to a precision of
+*			: prec significant digits chosen per call. Every result is the exact value correctly rounded to prec digits, ties to
+*			: even: sums and products are formed exactly by the integer engine and rounded once, quotients and square roots are
+*			: computed with guard digits and a sticky bit from the integer remainder. The integer square root runs Newton's
+*			: iteration from the square root of the top half of the number, so its cost is a few divisions of full size.
+*			: Results are kept with the trailing zeros of the mantissa moved into the exponent.
+*Prototype		: int bigdec_add(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+*			: int bigdec_sub(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+*			: int bigdec_mul(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+*			: int bigdec_div(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec);
+*			: int bigdec_sqrt(bigdec_t *r, const bigdec_t *a, int prec);
+*			: int bigint_sqrt(bigint_t *r, bigint_t *rem, const bigint_t *a);
+*Input Parameters	: prec: Significant decimal digits of the result, at least 1. r may alias an operand.
+*Output			: Status (SUCCESS / FAILURE)
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "apc.h"
+
+static const limb_t pow10[APC_BASE_DIGITS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+void bigdec_init(bigdec_t *a)
+{
+	bigint_init(&a->mant);
+	a->exp = 0;
+}
+
+void bigdec_free(bigdec_t *a)
+{
+	bigint_free(&a->mant);
+	a->exp = 0;
+}
+
+int bigdec_copy(bigdec_t *dst, const bigdec_t *src)
+{
+	if (bigint_copy(&dst->mant, &src->mant) == FAILURE)
+		return FAILURE;
+	dst->exp = src->exp;
+	return SUCCESS;
+}
+
+void bigdec_swap(bigdec_t *a, bigdec_t *b)
+{
+	long exp = a->exp;
+
+	bigint_swap(&a->mant, &b->mant);
+	a->exp = b->exp;
+	b->exp = exp;
+}
+
+void bigdec_move(bigdec_t *dst, bigdec_t *src)
+{
+	bigint_move(&dst->mant, &src->mant);
+	dst->exp = src->exp;
+	src->exp = 0;
+}
+
+/* Number of decimal digits of |a|, 0 for zero */
+long bigint_digits(const bigint_t *a)
+{
+	int top = 1;
+
+	if (a->size == 0)
+		return 0;
+	while (top < APC_BASE_DIGITS && a->limb[a->size - 1] >= pow10[top])
+		top++;
+	return (long)(a->size - 1) * APC_BASE_DIGITS + top;
+}
+
+/* r = a * 10^k for k >= 0 */
+static int scale_up(bigint_t *r, const bigint_t *a, long k)
+{
+	if (k > (long)INT_MAX / 2)
+		return FAILURE;
+	if (bigint_shl_limbs(r, a, k / APC_BASE_DIGITS) == FAILURE)
+		return FAILURE;
+	return k % APC_BASE_DIGITS ? bigint_mul_1(r, r, pow10[k % APC_BASE_DIGITS]) : SUCCESS;
+}
+
+/* r = a / 10^k truncated toward zero for k >= 0 */
+static int scale_down(bigint_t *r, const bigint_t *a, long k)
+{
+	if (bigint_shr_limbs(r, a, k / APC_BASE_DIGITS) == FAILURE)
+		return FAILURE;
+	return k % APC_BASE_DIGITS ? bigint_divrem_1(r, r, pow10[k % APC_BASE_DIGITS], NULL) : SUCCESS;
+}
+
+/* Decimal digit p of |a|, counting from 0 at the units */
+static int digit_at(const bigint_t *a, long p)
+{
+	return a->limb[p / APC_BASE_DIGITS] / pow10[p % APC_BASE_DIGITS] % 10;
+}
+
+/* Whether any digit of |a| below position p is non zero */
+static int nonzero_below(const bigint_t *a, long p)
+{
+	long i = p / APC_BASE_DIGITS;
+
+	if (a->limb[i] % pow10[p % APC_BASE_DIGITS])
+		return 1;
+	while (i-- > 0)
+		if (a->limb[i])
+			return 1;
+	return 0;
+}
+
+/* Move the trailing decimal zeros of the mantissa into the exponent, zero gets exponent 0 */
+static int strip_zeros(bigdec_t *a)
+{
+	long zeros = 0;
+
+	if (a->mant.size == 0)
+	{
+		a->exp = 0;
+		return SUCCESS;
+	}
+	while (a->mant.limb[zeros / APC_BASE_DIGITS] == 0)
+		zeros += APC_BASE_DIGITS;
+	while (digit_at(&a->mant, zeros) == 0)
+		zeros++;
+	if (zeros == 0)
+		return SUCCESS;
+	a->exp += zeros;
+	return scale_down(&a->mant, &a->mant, zeros);
+}
+
+/*
+ * Round a to prec digits, ties to even. sticky says the true value lies strictly beyond the
+ * mantissa in the direction away from zero, so it needs at least one digit below the rounding
+ * position to decide ties; the callers that pass it always leave a guard digit.
+ */
+static int round_to(bigdec_t *a, int prec, int sticky)
+{
+	long drop = bigint_digits(&a->mant) - prec;
+
+	if (drop > 0)
+	{
+		int digit = digit_at(&a->mant, drop - 1);
+		int rest = sticky || nonzero_below(&a->mant, drop - 1);
+
+		if (scale_down(&a->mant, &a->mant, drop) == FAILURE)
+			return FAILURE;
+		a->exp += drop;
+
+		/* A mantissa of prec nines carries into 10^prec, which strip_zeros() folds back */
+		if (digit > 5 || (digit == 5 && (rest || a->mant.limb[0] % 2)))
+		{
+			int n = a->mant.size;
+			if (bigint_reserve(&a->mant, n + 1) == FAILURE)
+				return FAILURE;
+			a->mant.limb[n] = apc_add_1(a->mant.limb, a->mant.limb, n, 1);
+			a->mant.size = n + 1;
+			bigint_normalize(&a->mant);
+		}
+	}
+	return strip_zeros(a);
+}
+
+/* Round a to prec significant digits into r */
+int bigdec_round(bigdec_t *r, const bigdec_t *a, int prec)
+{
+	if (prec < 1 || bigdec_copy(r, a) == FAILURE)
+		return FAILURE;
+	return round_to(r, prec, 0);
+}
+
+/* r = a as an integer, FAILURE when a has a fractional part */
+int bigdec_to_bigint(bigint_t *r, const bigdec_t *a)
+{
+	bigdec_t t;
+	int status;
+
+	bigdec_init(&t);
+	status = bigdec_copy(&t, a);
+	if (status == SUCCESS)
+		status = strip_zeros(&t);
+	if (status == SUCCESS)
+		status = t.exp < 0 ? FAILURE : scale_up(r, &t.mant, t.exp);
+	bigdec_free(&t);
+	return status;
+}
+
+/*
+ * Parse an optionally signed decimal number with an optional fraction and exponent,
+ * such as -12.5e-3, exactly
+ */
+int bigdec_from_string(bigdec_t *a, const char *str)
+{
+	const char *s = str;
+	long frac = 0, exp = 0;
+	int digits = 0, exp_sign = 1;
+
+	char *buf = malloc(strlen(str) + 2);
+	if (buf == NULL)
+		return FAILURE;
+	char *ptr = buf;
+
+	if (*s == '-' || *s == '+')
+		*ptr++ = *s++;
+	for (int dot = 0; isdigit((unsigned char)*s) || (*s == '.' && !dot); s++)
+	{
+		if (*s == '.')
+		{
+			dot = 1;
+			continue;
+		}
+		*ptr++ = *s;
+		digits++;
+		frac += dot;
+	}
+	*ptr = '\0';
+	if (digits && (*s == 'e' || *s == 'E'))
+	{
+		s++;
+		if (*s == '-' || *s == '+')
+			exp_sign = *s++ == '-' ? -1 : 1;
+		if (!isdigit((unsigned char)*s))
+			digits = 0;
+		for (; isdigit((unsigned char)*s) && exp < INT_MAX; s++)
+			exp = exp * 10 + (*s - '0');
+	}
+
+	int status = digits && *s == '\0' && exp < INT_MAX ? bigint_from_string(&a->mant, buf) : FAILURE;
+	free(buf);
+	if (status == FAILURE)
+		return FAILURE;
+	a->exp = exp_sign * exp - frac;
+	return strip_zeros(a);
+}
+
+/*
+ * Return a malloc'd decimal string of a: plain notation while it stays short, such as
+ * 1234.5 or 0.00012, otherwise one digit before the point and an exponent, 1.2345e+40
+ */
+char *bigdec_to_string(const bigdec_t *a)
+{
+	bigint_t mag = a->mant;
+	mag.sign = 1;
+	char *digits = bigint_to_string(&mag);
+	if (digits == NULL)
+		return NULL;
+
+	long len = strlen(digits), exp = a->mant.size ? a->exp : 0, point = len + exp;
+	char *str = malloc(len + 64);
+	char *ptr = str;
+	if (str == NULL)
+	{
+		free(digits);
+		return NULL;
+	}
+	if (a->mant.sign < 0 && a->mant.size)
+		*ptr++ = '-';
+
+	if (exp >= 0 && point <= len + 20)
+	{
+		/* Integer, padded with the exponent's zeros */
+		memcpy(ptr, digits, len);
+		memset(ptr + len, '0', exp);
+		ptr[len + exp] = '\0';
+	}
+	else if (exp < 0 && point > 0)
+		sprintf(ptr, "%.*s.%s", (int)point, digits, digits + point);
+	else if (exp < 0 && point > -10)
+	{
+		*ptr++ = '0';
+		*ptr++ = '.';
+		memset(ptr, '0', -point);
+		strcpy(ptr - point, digits);
+	}
+	else
+		sprintf(ptr, "%c%s%se%+ld", digits[0], len > 1 ? "." : "", digits + 1, point - 1);
+	free(digits);
+	return str;
+}
+
+/* r = a + b_sign * b rounded to prec digits */
+static int add_sign(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int b_sign, int prec)
+{
+	bigdec_t x, y, tiny;
+	const bigdec_t *p = a, *q = b;
+	int status = FAILURE;
+
+	if (prec < 1)
+		return FAILURE;
+	bigdec_init(&x);
+	bigdec_init(&y);
+	bigdec_init(&tiny);
+
+	/*
+	 * An operand wholly below the other's last digit and two digits past the rounding position
+	 * only decides which way to round, so it is replaced by a single digit just below both.
+	 * This keeps 1e1000000 + 1e-1000000 from building a two million digit sum.
+	 */
+	if (a->mant.size && b->mant.size)
+	{
+		long top_a = a->exp + bigint_digits(&a->mant), top_b = b->exp + bigint_digits(&b->mant);
+		long floor_a = a->exp < top_a - prec - 2 ? a->exp : top_a - prec - 2;
+		long floor_b = b->exp < top_b - prec - 2 ? b->exp : top_b - prec - 2;
+		if (top_b < floor_a || top_a < floor_b)
+		{
+			const bigdec_t *small = top_b < floor_a ? b : a;
+			if (bigint_set_int(&tiny.mant, small->mant.sign) == FAILURE)
+				goto out;
+			tiny.exp = (top_b < floor_a ? floor_a : floor_b) - 1;
+			if (small == b)
+				q = &tiny;
+			else
+				p = &tiny;
+		}
+	}
+
+	/* Line both up on the lower exponent, the sum is then exact */
+	long exp = p->exp < q->exp ? p->exp : q->exp;
+	if (scale_up(&x.mant, &p->mant, p->exp - exp) == FAILURE || scale_up(&y.mant, &q->mant, q->exp - exp) == FAILURE)
+		goto out;
+	if (bigint_add_sign(&x.mant, &x.mant, &y.mant, b_sign * y.mant.sign) == FAILURE)
+		goto out;
+	x.exp = exp;
+	if (round_to(&x, prec, 0) == FAILURE)
+		goto out;
+	bigdec_move(r, &x);
+	status = SUCCESS;
+out:
+	bigdec_free(&x);
+	bigdec_free(&y);
+	bigdec_free(&tiny);
+	return status;
+}
+
+int bigdec_add(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec)
+{
+	return add_sign(r, a, b, 1, prec);
+}
+
+int bigdec_sub(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec)
+{
+	return add_sign(r, a, b, -1, prec);
+}
+
+/* The exact product rounded once */
+int bigdec_mul(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec)
+{
+	bigdec_t x;
+	int status = FAILURE;
+
+	if (prec < 1)
+		return FAILURE;
+	bigdec_init(&x);
+	if (bigint_mul(&x.mant, &a->mant, &b->mant) == SUCCESS)
+	{
+		x.exp = a->exp + b->exp;
+		if (round_to(&x, prec, 0) == SUCCESS)
+		{
+			bigdec_move(r, &x);
+			status = SUCCESS;
+		}
+	}
+	bigdec_free(&x);
+	return status;
+}
+
+/* The dividend is scaled so the integer quotient has a guard digit past prec, the remainder is the sticky bit */
+int bigdec_div(bigdec_t *r, const bigdec_t *a, const bigdec_t *b, int prec)
+{
+	bigdec_t x;
+	bigint_t n, rem;
+	int status = FAILURE;
+
+	if (prec < 1 || b->mant.size == 0)
+		return FAILURE;
+	bigdec_init(&x);
+	bigint_init(&n);
+	bigint_init(&rem);
+
+	long shift = prec + 2 + bigint_digits(&b->mant) - bigint_digits(&a->mant);
+	if (shift < 0)
+		shift = 0;
+	if (scale_up(&n, &a->mant, shift) == SUCCESS && bigint_divrem(&x.mant, &rem, &n, &b->mant) == SUCCESS)
+	{
+		x.exp = a->exp - b->exp - shift;
+		if (round_to(&x, prec, rem.size != 0) == SUCCESS)
+		{
+			bigdec_move(r, &x);
+			status = SUCCESS;
+		}
+	}
+	bigdec_free(&x);
+	bigint_free(&n);
+	bigint_free(&rem);
+	return status;
+}
+
+/* floor(sqrt(a)) for a < B^2 */
+static uint64_t sqrt_u64(uint64_t a)
+{
+	uint64_t x = a, y = (x + 1) / 2;
+
+	while (y < x)
+	{
+		x = y;
+		y = (x + a / x) / 2;
+	}
+	return x;
+}
+
+/*
+ * r = floor(sqrt(a)), rem = a - r^2 when not NULL. The square root y of the top half
+ * a / B^2h gives x = y B^h to about half the digits, one Newton step x = (x + a / x) / 2
+ * doubles them and lands on or above the root, and the steps continue while x shrinks.
+ */
+int bigint_sqrt(bigint_t *r, bigint_t *rem, const bigint_t *a)
+{
+	bigint_t x, q, t;
+	int status = FAILURE;
+
+	if (a->sign < 0 && a->size)
+		return FAILURE;
+	bigint_init(&x);
+	bigint_init(&q);
+	bigint_init(&t);
+
+	if (a->size <= 2)
+	{
+		uint64_t value = a->size == 0 ? 0 : a->size == 1 ? a->limb[0] : (uint64_t)a->limb[1] * APC_BASE + a->limb[0];
+		if (bigint_set_int(&x, (long long)sqrt_u64(value)) == FAILURE)
+			goto out;
+	}
+	else
+	{
+		int h = a->size / 4 > 0 ? a->size / 4 : 1;
+		if (bigint_shr_limbs(&t, a, 2 * h) == FAILURE || bigint_sqrt(&q, NULL, &t) == FAILURE ||
+				bigint_shl_limbs(&x, &q, h) == FAILURE)
+			goto out;
+		if (x.size == 0 && bigint_set_int(&x, 1) == FAILURE)
+			goto out;
+		for (int first = 1;; first = 0)
+		{
+			if (bigint_divrem(&q, NULL, a, &x) == FAILURE || bigint_add(&q, &q, &x) == FAILURE ||
+					bigint_divrem_1(&q, &q, 2, NULL) == FAILURE)
+				goto out;
+			if (!first && bigint_cmp(&q, &x) >= 0)
+				break;
+			bigint_swap(&x, &q);
+		}
+	}
+
+	if (rem && (bigint_mul(&t, &x, &x) == FAILURE || bigint_sub(rem, a, &t) == FAILURE))
+		goto out;
+	bigint_move(r, &x);
+	status = SUCCESS;
+out:
+	bigint_free(&x);
+	bigint_free(&q);
+	bigint_free(&t);
+	return status;
+}
+
+/* The mantissa is scaled to an even exponent and at least 2 (prec + 2) digits before the integer root */
+int bigdec_sqrt(bigdec_t *r, const bigdec_t *a, int prec)
+{
+	bigdec_t x;
+	bigint_t n, rem;
+	int status = FAILURE;
+
+	if (prec < 1 || a->mant.sign < 0)
+		return FAILURE;
+	bigdec_init(&x);
+	bigint_init(&n);
+	bigint_init(&rem);
+
+	long shift = 2 * ((long)prec + 2) - bigint_digits(&a->mant);
+	if (shift < 0)
+		shift = 0;
+	if ((a->exp - shift) & 1)
+		shift++;
+	if (scale_up(&n, &a->mant, shift) == SUCCESS && bigint_sqrt(&x.mant, &rem, &n) == SUCCESS)
+	{
+		x.exp = (a->exp - shift) / 2;
+		if (round_to(&x, prec, rem.size != 0) == SUCCESS)
+		{
+			bigdec_move(r, &x);
+			status = SUCCESS;
+		}
+	}
+	bigdec_free(&x);
+	bigint_free(&n);
+	bigint_free(&rem);
+	return status;
+}
@@ -1,6 +1,9 @@
 /*******************************************************************************************************************************************************************
 *Title			: Division
 *Description		: This function performs division of two given large numbers and store the result in the resultant list.
+			: The lists are packed into base 10^9 limb vectors (bigint_t) and the limb kernel does the work.
+			: Knuth's Algorithm D handles short divisors and quotients, a Newton reciprocal with the fast multiplication
+			: engine the long ones, so large by large division costs a small multiple of one multiplication.
 *Prototype		: int division(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
 *Input Parameters	: head1: Pointer to the first node of the first double linked list.
 			: tail1: Pointer to the last node of the first double linked list.
@@ -11,7 +14,323 @@
 *******************************************************************************************************************************************************************/
 #include "apc.h"
 
+/* Limb kernel: q[0..n) = a[0..n) / d for 0 < d < APC_BASE, returns the remainder, q may alias a */
+limb_t apc_divrem_1(limb_t *q, const limb_t *a, int n, limb_t d)
+{
+	uint64_t rem = 0;
+
+	for (int i = n - 1; i >= 0; i--)
+	{
+		uint64_t cur = rem * APC_BASE + a[i];
+		q[i] = cur / d;
+		rem = cur % d;
+	}
+	return rem;
+}
+
+/* q = a / d truncated toward zero, the magnitude of the remainder goes to rem when not NULL */
+int bigint_divrem_1(bigint_t *q, const bigint_t *a, limb_t d, limb_t *rem)
+{
+	if (d == 0 || d >= APC_BASE || bigint_reserve(q, a->size) == FAILURE)
+		return FAILURE;
+
+	limb_t r = apc_divrem_1(q->limb, a->limb, a->size, d);
+	q->size = a->size;
+	q->sign = a->sign;
+	bigint_normalize(q);
+	if (rem)
+		*rem = r;
+	return SUCCESS;
+}
+
+int apc_newton_threshold = APC_NEWTON_THRESHOLD;
+
+/* Reciprocals of divisors shorter than this come straight from Algorithm D */
+#define RECIPROCAL_BASECASE 40
+
+/*
+ * Knuth Algorithm D: q[0..n-m] = u[0..n] / v[0..m), the remainder is left in u[0..m).
+ * u holds n + 1 limbs, v is normalized (v[m - 1] >= APC_BASE / 2) and m >= 2.
+ */
+static void knuth_divrem(limb_t *q, limb_t *u, int n, const limb_t *v, int m)
+{
+	uint64_t vtop = v[m - 1], vnext = v[m - 2];
+
+	for (int j = n - m; j >= 0; j--)
+	{
+		/* estimate from the top two limbs, at most two too large after the test below */
+		uint64_t num = (uint64_t)u[j + m] * APC_BASE + u[j + m - 1];
+		uint64_t qhat = num / vtop, rhat = num % vtop;
+		while (qhat >= APC_BASE || qhat * vnext > rhat * APC_BASE + u[j + m - 2])
+		{
+			qhat--;
+			rhat += vtop;
+			if (rhat >= APC_BASE)
+				break;
+		}
+
+		/* u[j..j+m] -= qhat * v */
+		uint64_t carry = 0;
+		int64_t borrow = 0;
+		for (int i = 0; i < m; i++)
+		{
+			uint64_t p = qhat * v[i] + carry;
+			carry = p / APC_BASE;
+			int64_t t = (int64_t)u[i + j] - (int64_t)(p % APC_BASE) - borrow;
+			borrow = t < 0;
+			u[i + j] = t + (borrow ? APC_BASE : 0);
+		}
+		int64_t top = (int64_t)u[j + m] - (int64_t)carry - borrow;
+
+		/* rare: qhat was one too large, add v back */
+		if (top < 0)
+		{
+			qhat--;
+			top += apc_add_n(u + j, u + j, v, m);
+		}
+		u[j + m] = top;
+		q[j] = qhat;
+	}
+}
+
+/* |q| = |a| / |b|, |r| = |a| % |b| by Algorithm D for |a| >= |b| and b->size >= 2 */
+static int divrem_knuth(bigint_t *q, bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	int n = a->size, m = b->size;
+	limb_t f = APC_BASE / (b->limb[m - 1] + 1);
+	limb_t *v = apc_alloc((size_t)m * sizeof(limb_t));
+
+	if (v == NULL || bigint_reserve(q, n - m + 1) == FAILURE || bigint_reserve(r, n + 1) == FAILURE)
+	{
+		apc_release(v);
+		return FAILURE;
+	}
+	/* scale both so the divisor's top limb is at least APC_BASE / 2, the quotient does not change */
+	apc_mul_1(v, b->limb, m, f);
+	r->limb[n] = apc_mul_1(r->limb, a->limb, n, f);
+	knuth_divrem(q->limb, r->limb, n, v, m);
+	apc_divrem_1(r->limb, r->limb, m, f);
+	apc_release(v);
+
+	q->size = n - m + 1;
+	q->sign = 1;
+	bigint_normalize(q);
+	r->size = m;
+	r->sign = 1;
+	bigint_normalize(r);
+	return SUCCESS;
+}
+
+/* x = B^k */
+static int power_of_base(bigint_t *x, int k)
+{
+	if (bigint_reserve(x, k + 1) == FAILURE)
+		return FAILURE;
+	for (int i = 0; i < k; i++)
+		x->limb[i] = 0;
+	x->limb[k] = 1;
+	x->size = k + 1;
+	x->sign = 1;
+	return SUCCESS;
+}
+
+/* Nudge q until r = a - q v lies in [0, v), one v per step; the estimates fed in are off by a few at most */
+static int correct_quotient(bigint_t *q, bigint_t *r, const bigint_t *v, bigint_t *one)
+{
+	while (r->sign < 0)
+		if (bigint_sub_inplace(q, one) == FAILURE || bigint_add_inplace(r, v) == FAILURE)
+			return FAILURE;
+	while (bigint_cmp(r, v) >= 0)
+		if (bigint_add_inplace(q, one) == FAILURE || bigint_sub_inplace(r, v) == FAILURE)
+			return FAILURE;
+	return SUCCESS;
+}
+
+/*
+ * x = floor(B^2m / v) for a normalized, positive v of m limbs. The reciprocal of the top
+ * half of v, shifted into place, is refined by one Newton step x += x (B^2m - v x) / B^2m,
+ * which doubles the number of correct limbs, and the last unit is fixed up exactly.
+ */
+int bigint_reciprocal(bigint_t *x, const bigint_t *v)
+{
+	int m = v->size, k = (m + 1) / 2, status = FAILURE;
+	bigint_t num, vh, e, t, one;
+
+	bigint_init(&num);
+	bigint_init(&vh);
+	bigint_init(&e);
+	bigint_init(&t);
+	bigint_init(&one);
+	if (power_of_base(&num, 2 * m) == FAILURE || bigint_set_int(&one, 1) == FAILURE)
+		goto out;
+
+	if (m < RECIPROCAL_BASECASE)
+	{
+		status = m == 1 ? bigint_divrem_1(x, &num, v->limb[0], NULL) : divrem_knuth(x, &t, &num, v);
+		goto out;
+	}
+
+	if (bigint_shr_limbs(&vh, v, m - k) == FAILURE || bigint_reciprocal(&t, &vh) == FAILURE ||
+			bigint_shl_limbs(x, &t, m - k) == FAILURE)
+		goto out;
+
+	/* e = B^2m - v x, t = x e / B^2m */
+	if (bigint_mul(&e, v, x) == FAILURE || bigint_sub(&e, &num, &e) == FAILURE ||
+			bigint_mul(&t, x, &e) == FAILURE || bigint_shr_limbs(&t, &t, 2 * m) == FAILURE ||
+			bigint_add_inplace(x, &t) == FAILURE)
+		goto out;
+
+	/* remainder of the estimate, then exact correction */
+	if (bigint_mul(&e, v, x) == FAILURE || bigint_sub(&e, &num, &e) == FAILURE)
+		goto out;
+	status = correct_quotient(x, &e, v, &one);
+out:
+	bigint_free(&num);
+	bigint_free(&vh);
+	bigint_free(&e);
+	bigint_free(&t);
+	bigint_free(&one);
+	return status;
+}
+
+/* Scale b so its top limb is at least B / 2 and precompute the reciprocal of the result */
+int bigint_divisor_init(bigint_divisor_t *d, const bigint_t *b)
+{
+	bigint_init(&d->v);
+	bigint_init(&d->inv);
+	if (b->size == 0)
+		return FAILURE;
+	d->f = APC_BASE / (b->limb[b->size - 1] + 1);
+	if (bigint_mul_1(&d->v, b, d->f) == FAILURE)
+		return FAILURE;
+	d->v.sign = 1;
+	return bigint_reciprocal(&d->inv, &d->v);
+}
+
+void bigint_divisor_free(bigint_divisor_t *d)
+{
+	bigint_free(&d->v);
+	bigint_free(&d->inv);
+}
+
+/*
+ * |q| = |a| / |b|, |r| = |a| % |b| through the precomputed reciprocal of the scaled divisor v
+ * (m limbs). The scaled dividend is consumed m limbs at a time from the top like a long division
+ * whose digits are m limbs wide: each step divides a value below B^2m by v with two multiplications.
+ * q and r must not alias a.
+ */
+int bigint_divrem_pre(bigint_t *q, bigint_t *r, const bigint_t *a, const bigint_divisor_t *d)
+{
+	const bigint_t *v = &d->v;
+	int m = v->size, status = FAILURE;
+	bigint_t u, cur, qd, t, one;
+	bigint_t *all[] = {&u, &cur, &qd, &t, &one};
+
+	for (int i = 0; i < 5; i++)
+		bigint_init(all[i]);
+	if (bigint_mul_1(&u, a, d->f) == FAILURE || bigint_set_int(&one, 1) == FAILURE)
+		goto out;
+	u.sign = 1;
+
+	int blocks = (u.size + m - 1) / m;
+	if (bigint_reserve(q, blocks * m) == FAILURE)
+		goto out;
+	for (int i = 0; i < blocks * m; i++)
+		q->limb[i] = 0;
+
+	bigint_set_int(r, 0);
+	for (int blk = blocks - 1; blk >= 0; blk--)
+	{
+		/* cur = r B^m + next m limbs of u, below v B^m */
+		int from = blk * m, to = from + m < u.size ? from + m : u.size;
+		if (bigint_shl_limbs(&cur, r, m) == FAILURE || bigint_reserve(&cur, m + to - from) == FAILURE)
+			goto out;
+		if (cur.size == 0)
+			cur.size = to - from;
+		for (int i = from; i < to; i++)
+			cur.limb[i - from] = u.limb[i];
+		bigint_normalize(&cur);
+
+		/* qd = cur inv / B^2m, r = cur - qd v, then fix the last units */
+		if (bigint_mul(&qd, &cur, &d->inv) == FAILURE || bigint_shr_limbs(&qd, &qd, 2 * m) == FAILURE ||
+				bigint_mul(&t, &qd, v) == FAILURE || bigint_sub(r, &cur, &t) == FAILURE ||
+				correct_quotient(&qd, r, v, &one) == FAILURE)
+			goto out;
+		for (int i = 0; i < qd.size; i++)
+			q->limb[from + i] = qd.limb[i];
+	}
+	q->size = blocks * m;
+	q->sign = 1;
+	bigint_normalize(q);
+	status = bigint_divrem_1(r, r, d->f, NULL);
+out:
+	for (int i = 0; i < 5; i++)
+		bigint_free(all[i]);
+	return status;
+}
+
+static int divrem_newton(bigint_t *q, bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	bigint_divisor_t d;
+	int status = bigint_divisor_init(&d, b);
+
+	if (status == SUCCESS)
+		status = bigint_divrem_pre(q, r, a, &d);
+	bigint_divisor_free(&d);
+	return status;
+}
+
+/*
+ * q = a / b truncated toward zero and rem = a - q b, which takes the sign of a.
+ * Either output may be NULL or alias an operand. Short divisors and short quotients
+ * use Algorithm D, long ones a Newton reciprocal and the fast multiplication engine.
+ */
+int bigint_divrem(bigint_t *q, bigint_t *rem, const bigint_t *a, const bigint_t *b)
+{
+	bigint_t tq, tr;
+	int status, sign_q = a->sign * b->sign, sign_r = a->sign;
+
+	if (b->size == 0)
+		return FAILURE;
+
+	bigint_init(&tq);
+	bigint_init(&tr);
+	if (bigint_cmp_abs(a, b) < 0)
+		status = bigint_copy(&tr, a) == SUCCESS ? bigint_set_int(&tq, 0) : FAILURE;
+	else if (b->size == 1)
+	{
+		limb_t r;
+		status = bigint_divrem_1(&tq, a, b->limb[0], &r);
+		if (status == SUCCESS)
+			status = bigint_set_int(&tr, r);
+	}
+	else if (b->size >= apc_newton_threshold && a->size - b->size >= apc_newton_threshold)
+		status = divrem_newton(&tq, &tr, a, b);
+	else
+		status = divrem_knuth(&tq, &tr, a, b);
+
+	if (status == SUCCESS)
+	{
+		tq.sign = sign_q;
+		tr.sign = sign_r;
+		bigint_normalize(&tq);
+		bigint_normalize(&tr);
+		if (q)
+			bigint_swap(q, &tq);
+		if (rem)
+			bigint_swap(rem, &tr);
+	}
+	bigint_free(&tq);
+	bigint_free(&tr);
+	return status;
+}
+
+static int quotient(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	return bigint_divrem(r, NULL, a, b);
+}
+
 int division(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR)
 {
-	/* Definition goes here */
+	return dlist_operation(quotient, head1, tail1, head2, tail2, headR);
 }
@@ -0,0 +1,109 @@
+/*******************************************************************************************************************************************************************
+*Title			: Double linked list helpers
+*Description		: These functions build, print and free the one digit per node double linked lists used by the Dlist entry points.
+*			: A negative number is stored with a negative digit in the head node.
+*******************************************************************************************************************************************************************/
+#include <ctype.h>
+#include "apc.h"
+
+int dl_insert_first(Dlist **head, Dlist **tail, data_t data)
+{
+	Dlist *new = malloc(sizeof(Dlist));
+	if (new == NULL)
+		return FAILURE;
+
+	new->data = data;
+	new->prev = NULL;
+	new->next = *head;
+	if (*head == NULL)
+		*tail = new;
+	else
+		(*head)->prev = new;
+	*head = new;
+	return SUCCESS;
+}
+
+int dl_insert_last(Dlist **head, Dlist **tail, data_t data)
+{
+	Dlist *new = malloc(sizeof(Dlist));
+	if (new == NULL)
+		return FAILURE;
+
+	new->data = data;
+	new->next = NULL;
+	new->prev = *tail;
+	if (*tail == NULL)
+		*head = new;
+	else
+		(*tail)->next = new;
+	*tail = new;
+	return SUCCESS;
+}
+
+void dl_delete_list(Dlist **head, Dlist **tail)
+{
+	while (*head)
+	{
+		Dlist *temp = (*head)->next;
+		free(*head);
+		*head = temp;
+	}
+	*tail = NULL;
+}
+
+/* Store the digits of str, with an optional leading sign, one digit per node */
+int string_to_dlist(const char *str, Dlist **head, Dlist **tail)
+{
+	int sign = 1;
+
+	*head = *tail = NULL;
+	if (*str == '-' || *str == '+')
+		sign = (*str++ == '-') ? -1 : 1;
+	if (*str == '\0')
+		return FAILURE;
+	while (*str == '0' && str[1] != '\0')
+		str++;
+	for (; *str; str++)
+	{
+		if (!isdigit((unsigned char)*str) || dl_insert_last(head, tail, *str - '0') == FAILURE)
+		{
+			dl_delete_list(head, tail);
+			return FAILURE;
+		}
+	}
+	if (sign < 0)
+		(*head)->data = -(*head)->data;
+	return SUCCESS;
+}
+
+void print_list(Dlist *head)
+{
+	if (head && head->data < 0)
+	{
+		printf("-%d", -head->data);
+		head = head->next;
+	}
+	for (; head; head = head->next)
+		printf("%d", head->data);
+	printf("\n");
+}
+
+/* Run a big integer operation on two lists and unpack the result into a new list at headR */
+int dlist_operation(bigint_op_t op, Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR)
+{
+	bigint_t a, b, r;
+	Dlist *tailR;
+	int status = FAILURE;
+
+	*headR = NULL;
+	bigint_init(&a);
+	bigint_init(&b);
+	bigint_init(&r);
+	if (bigint_from_dlist(&a, *head1, *tail1) == SUCCESS && bigint_from_dlist(&b, *head2, *tail2) == SUCCESS &&
+			op(&r, &a, &b) == SUCCESS)
+		status = bigint_to_dlist(&r, headR, &tailR);
+	bigint_free(&a);
+	bigint_free(&b);
+	bigint_free(&r);
+	return status;
+}
@@ -0,0 +1,695 @@
+/*******************************************************************************************************************************************************************
+*Title			: Expression evaluator
+*Description		: These functions tokenize one line, parse it with a Pratt parser into an expression tree and evaluate the tree with
+*			: the big integer engine. A line is either an expression or an assignment "name = expression". Operators are + - * / %
+*			: and ^ (power, right associative) with the usual precedence, unary minus and parentheses, plus the functions
+*			: powmod(b, e, m), invmod(a, m) and sqrt(a). Numbers are decimal or 0x prefixed hexadecimal, '#' starts a comment.
+*			: With env->precision set the values are decimals such as 1.5e-3, every operation is rounded to that many digits
+*			: and / is exact division, while %, powmod and invmod still want integers. Every tree level evaluates into a
+*			: temporary owned by apc_env_t, so the limb buffers grow once and are reused by all later operations and lines.
+*Prototype		: int apc_eval_line(apc_env_t *env, const char *line, const bigdec_t **result);
+*Input Parameters	: env: Variables and temporaries, set up with apc_env_init(), precision 0 for integers.
+*			: line: One expression or assignment.
+*			: result: Set to the value of an expression, NULL for assignments and empty lines.
+*Output			: Status (SUCCESS / FAILURE), on failure env->error and env->column tell what went wrong
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "apc.h"
+
+typedef enum
+{
+	TOK_END,
+	TOK_NUMBER,
+	TOK_NAME,
+	TOK_OP,
+	TOK_ERROR
+}token_type_t;
+
+typedef struct
+{
+	token_type_t type;
+	const char *start;
+	int len;
+}token_t;
+
+typedef struct
+{
+	const char *line;
+	const char *pos;
+	token_t tok;
+	apc_env_t *env;
+}parser_t;
+
+typedef enum
+{
+	EXPR_NUMBER,
+	EXPR_VARIABLE,
+	EXPR_NEGATE,
+	EXPR_BINARY,
+	EXPR_CALL
+}expr_type_t;
+
+typedef struct expr_node
+{
+	expr_type_t type;
+	char op;	/* operator, or index into functions[] for a call */
+	int slots;	/* temporaries the node needs from its own level up */
+	bigdec_t value;
+	char *name;
+	struct expr_node *left;	/* operand, or first argument of a call */
+	struct expr_node *right;
+	struct expr_node *next;	/* next argument of a call */
+}expr_node_t;
+
+/* Built-in functions */
+static const struct
+{
+	const char *name;
+	int argc;
+}functions[] = {
+	{"powmod", 3},
+	{"invmod", 2},
+	{"sqrt", 1},
+};
+
+/* Binding power of unary minus, between the multiplicative operators and ^ */
+#define UNARY_BP 30
+
+void apc_env_init(apc_env_t *env)
+{
+	env->vars = NULL;
+	env->temp = NULL;
+	env->temp_count = 0;
+	bigdec_init(&env->scratch);
+	env->precision = 0;
+	env->error = NULL;
+	env->column = 0;
+}
+
+void apc_env_free(apc_env_t *env)
+{
+	while (env->vars)
+	{
+		apc_var_t *next = env->vars->next;
+		free(env->vars->name);
+		bigdec_free(&env->vars->value);
+		free(env->vars);
+		env->vars = next;
+	}
+	for (int i = 0; i < env->temp_count; i++)
+		bigdec_free(&env->temp[i]);
+	free(env->temp);
+	bigdec_free(&env->scratch);
+	apc_env_init(env);
+}
+
+static apc_var_t *find_var(apc_env_t *env, const char *name)
+{
+	for (apc_var_t *var = env->vars; var; var = var->next)
+		if (strcmp(var->name, name) == 0)
+			return var;
+	return NULL;
+}
+
+/* Find the variable or insert it at the head of the list with value 0 */
+static apc_var_t *get_var(apc_env_t *env, const char *name)
+{
+	apc_var_t *var = find_var(env, name);
+	if (var)
+		return var;
+
+	var = malloc(sizeof(apc_var_t));
+	if (var == NULL)
+		return NULL;
+	var->name = strdup(name);
+	if (var->name == NULL)
+	{
+		free(var);
+		return NULL;
+	}
+	bigdec_init(&var->value);
+	var->next = env->vars;
+	env->vars = var;
+	return var;
+}
+
+/* Make sure temp[0..count) exist, new slots start empty and the old ones move over with their buffers */
+static int reserve_temps(apc_env_t *env, int count)
+{
+	if (count <= env->temp_count)
+		return SUCCESS;
+
+	bigdec_t *new = malloc((size_t)count * sizeof(bigdec_t));
+	if (new == NULL)
+		return FAILURE;
+	for (int i = 0; i < count; i++)
+	{
+		bigdec_init(&new[i]);
+		if (i < env->temp_count)
+			bigdec_move(&new[i], &env->temp[i]);
+	}
+	free(env->temp);
+	env->temp = new;
+	env->temp_count = count;
+	return SUCCESS;
+}
+
+static int set_error(parser_t *p, const char *pos, const char *msg)
+{
+	if (p->env->error == NULL)
+	{
+		p->env->error = msg;
+		p->env->column = pos - p->line + 1;
+	}
+	return FAILURE;
+}
+
+/* Tokenizer: numbers start with a digit and may hold a point and a signed exponent, names start with a letter or '_' */
+static void next_token(parser_t *p)
+{
+	const char *s = p->pos;
+
+	while (isspace((unsigned char)*s))
+		s++;
+	p->tok.start = s;
+	if (*s == '\0' || *s == '#')
+		p->tok.type = TOK_END;
+	else if (isdigit((unsigned char)*s))
+	{
+		int hex = s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+		p->tok.type = TOK_NUMBER;
+		while (isalnum((unsigned char)*s) || *s == '.' || (!hex && (*s == '+' || *s == '-') && (s[-1] == 'e' || s[-1] == 'E')))
+			s++;
+	}
+	else if (isalpha((unsigned char)*s) || *s == '_')
+	{
+		p->tok.type = TOK_NAME;
+		while (isalnum((unsigned char)*s) || *s == '_')
+			s++;
+	}
+	else if (strchr("+-*/%^()=,", *s))
+	{
+		p->tok.type = TOK_OP;
+		s++;
+	}
+	else
+	{
+		p->tok.type = TOK_ERROR;
+		s++;
+	}
+	p->tok.len = s - p->tok.start;
+	p->pos = s;
+}
+
+static int is_op(const parser_t *p, char op)
+{
+	return p->tok.type == TOK_OP && *p->tok.start == op;
+}
+
+static void free_tree(expr_node_t *node)
+{
+	if (node == NULL)
+		return;
+	free_tree(node->left);
+	free_tree(node->right);
+	free_tree(node->next);
+	bigdec_free(&node->value);
+	free(node->name);
+	free(node);
+}
+
+static expr_node_t *new_node(expr_type_t type, char op, expr_node_t *left, expr_node_t *right)
+{
+	expr_node_t *node = malloc(sizeof(expr_node_t));
+	if (node == NULL)
+		return NULL;
+
+	node->type = type;
+	node->op = op;
+	bigdec_init(&node->value);
+	node->name = NULL;
+	node->left = left;
+	node->right = right;
+	node->next = NULL;
+
+	/* A negation copies into its level, a binary operator also needs the next two (see eval) */
+	node->slots = 0;
+	if (type == EXPR_NEGATE)
+		node->slots = left->slots > 1 ? left->slots : 1;
+	else if (type == EXPR_BINARY)
+	{
+		node->slots = left->slots > right->slots + 1 ? left->slots : right->slots + 1;
+		if (node->slots < 3)
+			node->slots = 3;
+	}
+	return node;
+}
+
+/* Left and right binding powers of a binary operator, 0 when the token is not one */
+static int binding_power(const parser_t *p, int *right)
+{
+	if (p->tok.type != TOK_OP)
+		return 0;
+	switch (*p->tok.start)
+	{
+		case '+':
+		case '-':
+			*right = 11;
+			return 10;
+		case '*':
+		case '/':
+		case '%':
+			*right = 21;
+			return 20;
+		case '^':
+			/* Right associative: the right operand may contain another ^ */
+			*right = 40;
+			return 41;
+		default:
+			return 0;
+	}
+}
+
+static expr_node_t *parse_expr(parser_t *p, int min_bp);
+
+/* name(arg, ...) with the current token on '(': argument i is evaluated at level i of the call, the result at level argc */
+static expr_node_t *parse_call(parser_t *p, token_t name)
+{
+	int func = 0, argc = 0, count = sizeof(functions) / sizeof(functions[0]);
+	expr_node_t *node, **tail;
+
+	while (func < count && ((int)strlen(functions[func].name) != name.len || strncmp(functions[func].name, name.start, name.len)))
+		func++;
+	if (func == count)
+	{
+		set_error(p, name.start, "unknown function");
+		return NULL;
+	}
+	if ((node = new_node(EXPR_CALL, func, NULL, NULL)) == NULL)
+	{
+		set_error(p, name.start, "out of memory");
+		return NULL;
+	}
+
+	tail = &node->left;
+	do
+	{
+		next_token(p);
+		if ((*tail = parse_expr(p, 0)) == NULL)
+		{
+			free_tree(node);
+			return NULL;
+		}
+		if (argc + (*tail)->slots > node->slots)
+			node->slots = argc + (*tail)->slots;
+		tail = &(*tail)->next;
+		argc++;
+	}while (is_op(p, ','));
+
+	if (!is_op(p, ')') || argc != functions[func].argc)
+	{
+		set_error(p, is_op(p, ')') ? name.start : p->tok.start, is_op(p, ')') ? "wrong number of arguments" : "expected ')'");
+		free_tree(node);
+		return NULL;
+	}
+	if (node->slots < argc + 1)
+		node->slots = argc + 1;
+	next_token(p);
+	return node;
+}
+
+static expr_node_t *parse_prefix(parser_t *p)
+{
+	token_t tok = p->tok;
+	expr_node_t *node;
+
+	switch (tok.type)
+	{
+		case TOK_NAME:
+			next_token(p);
+			if (is_op(p, '('))
+				return parse_call(p, tok);
+			/* fall through */
+		case TOK_NUMBER:
+			node = new_node(tok.type == TOK_NUMBER ? EXPR_NUMBER : EXPR_VARIABLE, 0, NULL, NULL);
+			if (node == NULL)
+			{
+				set_error(p, tok.start, "out of memory");
+				return NULL;
+			}
+			node->name = strndup(tok.start, tok.len);
+			if (node->name == NULL || (tok.type == TOK_NUMBER && (tok.start[0] == '0' && (tok.start[1] == 'x' || tok.start[1] == 'X') ?
+						bigint_from_hex(&node->value.mant, node->name) : p->env->precision ?
+						bigdec_from_string(&node->value, node->name) : bigint_from_string(&node->value.mant, node->name)) == FAILURE))
+			{
+				set_error(p, tok.start, node->name ? "invalid number" : "out of memory");
+				free_tree(node);
+				return NULL;
+			}
+			if (tok.type == TOK_NUMBER)
+				next_token(p);
+			return node;
+
+		case TOK_OP:
+			if (is_op(p, '-') || is_op(p, '+'))
+			{
+				char op = *tok.start;
+				next_token(p);
+				expr_node_t *operand = parse_expr(p, UNARY_BP);
+				if (operand == NULL || op == '+')
+					return operand;
+				node = new_node(EXPR_NEGATE, '-', operand, NULL);
+				if (node == NULL)
+				{
+					set_error(p, tok.start, "out of memory");
+					free_tree(operand);
+				}
+				return node;
+			}
+			if (is_op(p, '('))
+			{
+				next_token(p);
+				node = parse_expr(p, 0);
+				if (node && !is_op(p, ')'))
+				{
+					set_error(p, p->tok.start, "expected ')'");
+					free_tree(node);
+					return NULL;
+				}
+				next_token(p);
+				return node;
+			}
+			/* fall through */
+		default:
+			set_error(p, tok.start, tok.type == TOK_END ? "unexpected end of expression" : "unexpected token");
+			return NULL;
+	}
+}
+
+/* Pratt loop: keep taking binary operators that bind at least as tightly as min_bp */
+static expr_node_t *parse_expr(parser_t *p, int min_bp)
+{
+	expr_node_t *left = parse_prefix(p);
+	int right_bp, left_bp;
+
+	while (left && (left_bp = binding_power(p, &right_bp)) && left_bp >= min_bp)
+	{
+		const char *at = p->tok.start;
+		char op = *at;
+		next_token(p);
+
+		expr_node_t *right = parse_expr(p, right_bp);
+		if (right == NULL)
+		{
+			free_tree(left);
+			return NULL;
+		}
+		expr_node_t *node = new_node(EXPR_BINARY, op, left, right);
+		if (node == NULL)
+		{
+			set_error(p, at, "out of memory");
+			free_tree(left);
+			free_tree(right);
+			return NULL;
+		}
+		left = node;
+	}
+	return left;
+}
+
+/* The integer value of a, from the decimal itself or converted into buf, NULL with env->error set when it has a fraction */
+static const bigint_t *integer(apc_env_t *env, const bigdec_t *a, bigint_t *buf)
+{
+	if (a->exp == 0)
+		return &a->mant;
+	if (bigdec_to_bigint(buf, a) == FAILURE)
+	{
+		env->error = "operand must be an integer";
+		return NULL;
+	}
+	return buf;
+}
+
+/* out *= a, exactly for integers and rounded to digits for decimals */
+static int times(apc_env_t *env, bigdec_t *out, const bigdec_t *a, int digits)
+{
+	if (env->precision)
+		return bigdec_mul(out, out, a, digits);
+	if (bigint_mul(&env->scratch.mant, &out->mant, &a->mant) == FAILURE)
+		return FAILURE;
+	bigint_swap(&out->mant, &env->scratch.mant);
+	return SUCCESS;
+}
+
+/*
+ * out = a^b by left to right square and multiply. Decimals carry ten guard digits through the
+ * products, and a negative exponent divides into one at the end.
+ */
+static int power(apc_env_t *env, bigdec_t *out, const bigdec_t *a, const bigdec_t *b)
+{
+	bigint_t buf;
+	const bigint_t *exp;
+	int status = FAILURE, work = env->precision + 10;
+
+	bigint_init(&buf);
+	if ((exp = integer(env, b, &buf)) == NULL)
+		goto out;
+	if (exp->sign < 0 && (env->precision == 0 || a->mant.size == 0))
+	{
+		env->error = env->precision ? "division by zero" : "negative exponent";
+		goto out;
+	}
+	if (exp->size > 2 || (exp->size == 2 && exp->limb[1] >= (INT_MAX / APC_BASE)))
+	{
+		env->error = "exponent too large";
+		goto out;
+	}
+
+	long long e = exp->size == 0 ? 0 : exp->size == 1 ? exp->limb[0] : (long long)exp->limb[1] * APC_BASE + exp->limb[0];
+	int bit = 0;
+	while ((e >> bit) > 1)
+		bit++;
+
+	if (bigint_set_int(&out->mant, 1) == FAILURE)
+		goto out;
+	out->exp = 0;
+	for (; e && bit >= 0; bit--)
+		if (times(env, out, out, work) == FAILURE || ((e >> bit) & 1 && times(env, out, a, work) == FAILURE))
+			goto out;
+	if (env->precision)
+	{
+		if (bigint_set_int(&env->scratch.mant, 1) == FAILURE)
+			goto out;
+		env->scratch.exp = 0;
+		if ((exp->sign < 0 ? bigdec_div(out, &env->scratch, out, env->precision) : bigdec_round(out, out, env->precision)) == FAILURE)
+			goto out;
+	}
+	status = SUCCESS;
+out:
+	bigint_free(&buf);
+	return status;
+}
+
+/* Integer division and remainder, for % on decimals too */
+static int divide(apc_env_t *env, char op, bigdec_t *out, const bigdec_t *a, const bigdec_t *b)
+{
+	bigint_t buf_a, buf_b;
+	const bigint_t *x, *y;
+	int status = FAILURE;
+
+	bigint_init(&buf_a);
+	bigint_init(&buf_b);
+	if ((x = integer(env, a, &buf_a)) != NULL && (y = integer(env, b, &buf_b)) != NULL)
+	{
+		out->exp = 0;
+		status = op == '/' ? bigint_divrem(&out->mant, NULL, x, y) : bigint_divrem(NULL, &out->mant, x, y);
+	}
+	bigint_free(&buf_a);
+	bigint_free(&buf_b);
+	return status;
+}
+
+static int apply(apc_env_t *env, char op, bigdec_t *out, const bigdec_t *a, const bigdec_t *b)
+{
+	int prec = env->precision;
+
+	if (op != '^')
+		out->exp = 0;
+	switch (op)
+	{
+		case '+':
+			return prec ? bigdec_add(out, a, b, prec) : bigint_add(&out->mant, &a->mant, &b->mant);
+		case '-':
+			return prec ? bigdec_sub(out, a, b, prec) : bigint_sub(&out->mant, &a->mant, &b->mant);
+		case '*':
+			return prec ? bigdec_mul(out, a, b, prec) : bigint_mul(&out->mant, &a->mant, &b->mant);
+		case '/':
+		case '%':
+			if (b->mant.size == 0)
+			{
+				env->error = "division by zero";
+				return FAILURE;
+			}
+			return prec && op == '/' ? bigdec_div(out, a, b, prec) : divide(env, op, out, a, b);
+		case '^':
+			return power(env, out, a, b);
+		default:
+			return FAILURE;
+	}
+}
+
+static int call(apc_env_t *env, int func, bigdec_t *out, const bigdec_t **arg)
+{
+	bigint_t buf[3];
+	const bigint_t *x[3];
+	int argc = functions[func].argc, status = FAILURE;
+
+	if (func == 2)
+	{
+		if (arg[0]->mant.sign < 0)
+		{
+			env->error = "square root of a negative number";
+			return FAILURE;
+		}
+		if (env->precision)
+			return bigdec_sqrt(out, arg[0], env->precision);
+		out->exp = 0;
+		return bigint_sqrt(&out->mant, NULL, &arg[0]->mant);
+	}
+
+	for (int i = 0; i < argc; i++)
+		bigint_init(&buf[i]);
+	for (int i = 0; i < argc; i++)
+		if ((x[i] = integer(env, arg[i], &buf[i])) == NULL)
+			goto out;
+	out->exp = 0;
+	status = func == 0 ? bigint_powmod(&out->mant, x[0], x[1], x[2]) : bigint_invmod(&out->mant, x[0], x[1]);
+	if (status == FAILURE)
+		env->error = x[argc - 1]->size == 0 || x[argc - 1]->sign < 0 ? "modulus must be positive" : "not invertible";
+out:
+	for (int i = 0; i < argc; i++)
+		bigint_free(&buf[i]);
+	return status;
+}
+
+/*
+ * Evaluate node at tree level depth. The value lands in temp[depth] or is a constant or
+ * variable owned elsewhere. The right operand uses temp[depth + 1] and the operation
+ * writes into temp[depth + 2], which never aliases an operand, before swapping it down.
+ */
+static const bigdec_t *eval(apc_env_t *env, const expr_node_t *node, int depth)
+{
+	const bigdec_t *a, *b;
+	bigdec_t *out;
+
+	switch (node->type)
+	{
+		case EXPR_NUMBER:
+			return &node->value;
+
+		case EXPR_VARIABLE:
+		{
+			apc_var_t *var = find_var(env, node->name);
+			if (var == NULL)
+				env->error = "undefined variable";
+			return var ? &var->value : NULL;
+		}
+
+		case EXPR_NEGATE:
+			out = &env->temp[depth];
+			if ((a = eval(env, node->left, depth)) == NULL || bigdec_copy(out, a) == FAILURE)
+				return NULL;
+			if (out->mant.size)
+				out->mant.sign = -out->mant.sign;
+			return out;
+
+		case EXPR_BINARY:
+			out = &env->temp[depth + 2];
+			if ((a = eval(env, node->left, depth)) == NULL || (b = eval(env, node->right, depth + 1)) == NULL ||
+					apply(env, node->op, out, a, b) == FAILURE)
+				return NULL;
+			bigdec_swap(&env->temp[depth], out);
+			return &env->temp[depth];
+
+		case EXPR_CALL:
+		{
+			const bigdec_t *arg[3];
+			int argc = 0;
+			for (const expr_node_t *x = node->left; x; x = x->next, argc++)
+				if ((arg[argc] = eval(env, x, depth + argc)) == NULL)
+					return NULL;
+			out = &env->temp[depth + argc];
+			if (call(env, node->op, out, arg) == FAILURE)
+				return NULL;
+			bigdec_swap(&env->temp[depth], out);
+			return &env->temp[depth];
+		}
+	}
+	return NULL;
+}
+
+int apc_eval_line(apc_env_t *env, const char *line, const bigdec_t **result)
+{
+	parser_t p = {line, line, {TOK_END, line, 0}, env};
+	char *name = NULL;
+	int status = FAILURE;
+
+	env->error = NULL;
+	env->column = 0;
+	*result = NULL;
+
+	next_token(&p);
+	if (p.tok.type == TOK_END)
+		return SUCCESS;
+
+	/* name = expression, looked ahead on a copy so a plain expression starting with a name re-parses */
+	if (p.tok.type == TOK_NAME)
+	{
+		parser_t ahead = p;
+		next_token(&ahead);
+		if (is_op(&ahead, '='))
+		{
+			if ((name = strndup(p.tok.start, p.tok.len)) == NULL)
+				return set_error(&p, p.tok.start, "out of memory");
+			next_token(&ahead);
+			p = ahead;
+		}
+	}
+
+	expr_node_t *tree = parse_expr(&p, 0);
+	if (tree && p.tok.type != TOK_END)
+		set_error(&p, p.tok.start, "unexpected token");
+	else if (tree && reserve_temps(env, tree->slots + 1) == FAILURE)
+		set_error(&p, line, "out of memory");
+	else if (tree)
+	{
+		const bigdec_t *value = eval(env, tree, 0);
+		bigdec_t *slot = &env->temp[0];
+
+		/* Constants and variables are returned by address, copy them out of the tree */
+		if (value == NULL || (value != slot && bigdec_copy(slot, value) == FAILURE))
+			set_error(&p, line, "out of memory");
+		else if (name)
+		{
+			/* The old value's buffer becomes the next temporary */
+			apc_var_t *var = get_var(env, name);
+			if (var == NULL)
+				set_error(&p, line, "out of memory");
+			else
+			{
+				bigdec_swap(&var->value, slot);
+				status = SUCCESS;
+			}
+		}
+		else
+		{
+			*result = slot;
+			status = SUCCESS;
+		}
+	}
+	free_tree(tree);
+	free(name);
+	return status;
+}
@@ -2,40 +2,227 @@
 *Title		: main function(Driver function)
 *Description	: This function is used as the driver function for the all the functions
 ***************************************************************************************************************************************************************/
+#include <ctype.h>
+#include <string.h>
+#include <unistd.h>
 #include "apc.h"
 
-int main()
+/* Read one line of any length without its newline, NULL at end of input */
+static char *read_line(FILE *fptr)
 {
-	/* Declare the pointers */
-	Dlist *head1, *tail1, *head2, *tail2, *headR;
-	char option, operator;
+	size_t len = 0, cap = 128;
+	char *buf = malloc(cap);
+	int ch;
 
+	if (buf == NULL)
+		return NULL;
+	while ((ch = getc(fptr)) != EOF && ch != '\n')
+	{
+		if (len + 1 == cap)
+		{
+			char *new = realloc(buf, cap *= 2);
+			if (new == NULL)
+				break;
+			buf = new;
+		}
+		buf[len++] = ch;
+	}
+	if (ch == EOF && len == 0)
+	{
+		free(buf);
+		return NULL;
+	}
+	buf[len] = '\0';
+	return buf;
+}
+
+static void print_result(const bigdec_t *result, int hex)
+{
+	bigint_t value;
+	char *str = NULL;
+
+	bigint_init(&value);
+	if (!hex)
+		str = bigdec_to_string(result);
+	else if (bigdec_to_bigint(&value, result) == SUCCESS)
+		str = bigint_to_hex(&value);
+	if (str)
+		printf("%s\n", str);
+	else
+		printf("Operation failed:-(\n");
+	free(str);
+	bigint_free(&value);
+}
+
+static void print_error(const apc_env_t *env, int line_no)
+{
+	if (line_no)
+		fprintf(stderr, "Error: line %d", line_no);
+	else
+		fprintf(stderr, "Error");
+	if (env->column)
+		fprintf(stderr, ", column %d", env->column);
+	fprintf(stderr, ": %s\n", env->error ? env->error : "operation failed");
+}
+
+/* Evaluate every line of fptr, variables carry over from line to line */
+static int batch(FILE *fptr, int hex, int precision)
+{
+	apc_env_t env;
+	const bigdec_t *result;
+	char *line;
+	int line_no = 0, failed = 0;
+
+	apc_env_init(&env);
+	env.precision = precision;
+	while ((line = read_line(fptr)) != NULL)
+	{
+		line_no++;
+		if (apc_eval_line(&env, line, &result) == FAILURE)
+		{
+			print_error(&env, line_no);
+			failed++;
+		}
+		else if (result)
+			print_result(result, hex);
+		free(line);
+	}
+	apc_env_free(&env);
+	return failed ? FAILURE : SUCCESS;
+}
+
+/* Compute and print one constant, timing the conversion to decimal as the last stage */
+static int constant(const char *name, int digits)
+{
+	bigdec_t value;
+	double stage[3];
+	char *str = NULL;
+
+	bigdec_init(&value);
+	if (apc_constant(&value, name, digits, stage) == SUCCESS)
+	{
+		double start = apc_now();
+		str = bigdec_to_string(&value);
+		stage[2] = apc_now() - start;
+	}
+	if (str)
+	{
+		/* Results are kept without trailing zeros, print all the digits asked for */
+		long missing = digits - bigint_digits(&value.mant);
+		printf("%s%s", str, missing > 0 && strchr(str, '.') == NULL ? "." : "");
+		while (missing-- > 0)
+			putchar('0');
+		putchar('\n');
+		fprintf(stderr, "series: %.3f s, division and root: %.3f s, conversion: %.3f s, threads: %d\n",
+				stage[0], stage[1], stage[2], apc_get_threads());
+	}
+	else
+		printf("Error: Unable to compute %s to %d digits\n", name, digits);
+	free(str);
+	bigdec_free(&value);
+	return str ? SUCCESS : FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+	apc_env_t env;
+	const bigdec_t *result;
+	char *line, *option;
+	int hex = 0, precision = 0, arg = 1, again;
+
+	/* Hand the limb buffers cached by this thread back on the way out */
+	atexit(apc_pool_trim);
+
+	/* ./a.out -j N ... runs large multiplications on N threads */
+	if (arg + 1 < argc && strcmp(argv[arg], "-j") == 0)
+	{
+		if (apc_set_threads(atoi(argv[arg + 1])) == FAILURE)
+		{
+			printf("Error: Unable to start %s threads\n", argv[arg + 1]);
+			return 1;
+		}
+		arg += 2;
+	}
+	/* ./a.out -t tunes the multiplication thresholds for this machine */
+	if (arg < argc && strcmp(argv[arg], "-t") == 0)
+		return apc_tune() == SUCCESS ? 0 : 1;
+	/* ./a.out -p [N] times large multiplications on 1 up to N threads, all online cores by default */
+	if (arg < argc && strcmp(argv[arg], "-p") == 0)
+		return apc_bench_threads(arg + 1 < argc ? atoi(argv[arg + 1]) : (int)sysconf(_SC_NPROCESSORS_ONLN)) == SUCCESS ? 0 : 1;
+	/* ./a.out -m times 2048 and 4096 bit modular exponentiation */
+	if (arg < argc && strcmp(argv[arg], "-m") == 0)
+		return apc_bench_modexp() == SUCCESS ? 0 : 1;
+	/* ./a.out -c pi|e|sqrt2 N prints the constant to N digits, and the time of each stage to stderr */
+	if (arg + 2 < argc && strcmp(argv[arg], "-c") == 0)
+		return constant(argv[arg + 1], atoi(argv[arg + 2])) == SUCCESS ? 0 : 1;
+	/* ./a.out -s [N] times and checks every operation on 10 up to N digits, 10^6 by default */
+	if (arg < argc && strcmp(argv[arg], "-s") == 0)
+		return apc_bench(arg + 1 < argc ? atoi(argv[arg + 1]) : 1000000) == SUCCESS ? 0 : 1;
+	/* ./a.out -a counts the allocations behind each operation */
+	if (arg < argc && strcmp(argv[arg], "-a") == 0)
+		return apc_bench_alloc() == SUCCESS ? 0 : 1;
+	/* ./a.out -d N ... computes with decimals rounded to N significant digits */
+	if (arg + 1 < argc && strcmp(argv[arg], "-d") == 0)
+	{
+		if ((precision = atoi(argv[arg + 1])) < 1)
+		{
+			printf("Error: Precision must be at least one digit\n");
+			return 1;
+		}
+		arg += 2;
+	}
+	/* ./a.out -x prints the results in hexadecimal */
+	if (arg < argc && strcmp(argv[arg], "-x") == 0)
+	{
+		hex = 1;
+		arg++;
+	}
+	/* ./a.out [-x] -b [file] evaluates one expression per line of file, or of stdin */
+	if (arg < argc && strcmp(argv[arg], "-b") == 0)
+	{
+		FILE *fptr = arg + 1 < argc ? fopen(argv[arg + 1], "r") : stdin;
+		if (fptr == NULL)
+		{
+			printf("Error: Unable to open %s\n", argv[arg + 1]);
+			return 1;
+		}
+		int status = batch(fptr, hex, precision);
+		if (fptr != stdin)
+			fclose(fptr);
+		apc_set_threads(1);
+		return status == SUCCESS ? 0 : 1;
+	}
+
+	apc_env_init(&env);
+	env.precision = precision;
 	do
 	{
 		/* Code for reading the inputs */
+		printf("Enter the expression: ");
+		fflush(stdout);
+		if ((line = read_line(stdin)) == NULL)
+			break;
 
-		/* Function for extracting the operator */
-
-		switch (operator)
+		if (apc_eval_line(&env, line, &result) == FAILURE)
+			print_error(&env, 0);
+		else if (result)
 		{
-			case '+':
-				/* call the function to perform the addition operation */
-				break;
-			case '-':	
-				/* call the function to perform the subtraction operation */
-				break;
-			case '*':	
-				/* call the function to perform the multiplication operation */
-				break;
-			case '/':	
-				/* call the function to perform the division operation */
-				break;
-			default:
-				printf("Invalid Input:-( Try again...\n");
+			printf("Result: ");
+			print_result(result, hex);
 		}
+		free(line);
+
 		printf("Want to continue? Press [yY | nN]: ");
-		scanf("\n%c", &option);
-	}while (option == 'y' || option == 'Y');
+		fflush(stdout);
+		if ((line = read_line(stdin)) == NULL)
+			break;
+		for (option = line; isspace((unsigned char)*option); option++)
+			;
+		again = *option == 'y' || *option == 'Y';
+		free(line);
+	}while (again);
 
+	apc_env_free(&env);
+	apc_set_threads(1);
 	return 0;
 }
@@ -0,0 +1,299 @@
+/*******************************************************************************************************************************************************************
+*Title			: Modular arithmetic
+*Description		: These functions do modular multiplication, exponentiation and inversion on big integers. A modulus coprime to 10 (so to
+*			: the limb base 10^9) gets Montgomery arithmetic with R = B^n: a product is formed by the multiplication engine and
+*			: reduced limb by limb with no division at all. Other moduli reduce each product by a division, through a precomputed
+*			: reciprocal once the modulus is long enough for Newton division. Exponentiation scans the binary exponent with a
+*			: sliding window of odd powers. The inverse comes from the extended Euclidean algorithm. None of it is constant time.
+*Prototype		: int bigint_powmod(bigint_t *r, const bigint_t *base, const bigint_t *exp, const bigint_t *m);
+*			: int bigint_invmod(bigint_t *r, const bigint_t *a, const bigint_t *m);
+*Input Parameters	: m: Modulus, must be positive. A negative exponent inverts the base first.
+*Output			: Status (SUCCESS / FAILURE), r in [0, m)
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include "apc.h"
+
+/* -m0^-1 mod B for m0 coprime to 10: Hensel lifting doubles the correct decimal digits per step, 1 -> 16 in four */
+static limb_t neg_inverse_mod_base(limb_t m0)
+{
+	static const uint64_t digit_inverse[10] = {0, 1, 0, 7, 0, 0, 0, 3, 0, 9};
+	uint64_t x = digit_inverse[m0 % 10];
+
+	for (int i = 0; i < 4; i++)
+		x = x * ((2 + APC_BASE - (uint64_t)m0 * x % APC_BASE) % APC_BASE) % APC_BASE;
+	return (APC_BASE - x) % APC_BASE;
+}
+
+int apc_mont_init(apc_mont_t *ctx, const bigint_t *m)
+{
+	bigint_t r2;
+
+	bigint_init(&ctx->m);
+	bigint_init(&ctx->r2);
+	ctx->t = NULL;
+	if (m->size == 0 || m->sign < 0 || m->limb[0] % 2 == 0 || m->limb[0] % 5 == 0 || (m->size == 1 && m->limb[0] == 1))
+		return FAILURE;
+
+	ctx->n = m->size;
+	ctx->minv = neg_inverse_mod_base(m->limb[0]);
+	ctx->t = apc_alloc((size_t)(2 * ctx->n + 1) * sizeof(limb_t));
+	bigint_init(&r2);
+	if (ctx->t == NULL || bigint_copy(&ctx->m, m) == FAILURE || bigint_set_int(&r2, 1) == FAILURE ||
+			bigint_shl_limbs(&r2, &r2, 2 * ctx->n) == FAILURE || bigint_divrem(NULL, &ctx->r2, &r2, m) == FAILURE)
+	{
+		bigint_free(&r2);
+		apc_mont_free(ctx);
+		return FAILURE;
+	}
+	bigint_free(&r2);
+	return SUCCESS;
+}
+
+void apc_mont_free(apc_mont_t *ctx)
+{
+	bigint_free(&ctx->m);
+	bigint_free(&ctx->r2);
+	apc_release(ctx->t);
+	ctx->t = NULL;
+}
+
+/*
+ * r = a b R^-1 mod m for a, b in [0, m). The product t < m^2 is reduced one limb at a time:
+ * adding u m B^i with u = t[i] (-m^-1) mod B clears limb i, so after n steps t is a multiple
+ * of R = B^n and t / R < 2m. r may alias a or b.
+ */
+int apc_mont_mul(apc_mont_t *ctx, bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	int n = ctx->n;
+	limb_t *t = ctx->t;
+
+	memset(t, 0, (size_t)(2 * n + 1) * sizeof(limb_t));
+	if (a->size && b->size && apc_mul(t, a->limb, a->size, b->limb, b->size) == FAILURE)
+		return FAILURE;
+	for (int i = 0; i < n; i++)
+	{
+		limb_t u = (uint64_t)t[i] * ctx->minv % APC_BASE;
+		limb_t carry = apc_addmul_1(t + i, ctx->m.limb, n, u);
+		apc_add_1(t + i + n, t + i + n, n + 1 - i, carry);
+	}
+
+	if (bigint_reserve(r, n + 1) == FAILURE)
+		return FAILURE;
+	memcpy(r->limb, t + n, (size_t)(n + 1) * sizeof(limb_t));
+	r->size = n + 1;
+	r->sign = 1;
+	bigint_normalize(r);
+	if (bigint_cmp_abs(r, &ctx->m) >= 0)
+	{
+		if (bigint_sub_abs(r, r, &ctx->m) == FAILURE)
+			return FAILURE;
+		bigint_normalize(r);
+	}
+	return SUCCESS;
+}
+
+/* r = a R mod m, into Montgomery form */
+int apc_mont_to(apc_mont_t *ctx, bigint_t *r, const bigint_t *a)
+{
+	return apc_mont_mul(ctx, r, a, &ctx->r2);
+}
+
+/* r = a R^-1 mod m, out of Montgomery form */
+int apc_mont_from(apc_mont_t *ctx, bigint_t *r, const bigint_t *a)
+{
+	bigint_t one;
+	int status;
+
+	bigint_init(&one);
+	status = bigint_set_int(&one, 1);
+	if (status == SUCCESS)
+		status = apc_mont_mul(ctx, r, a, &one);
+	bigint_free(&one);
+	return status;
+}
+
+/* r = a mod m in [0, m) for m > 0 */
+int bigint_mod(bigint_t *r, const bigint_t *a, const bigint_t *m)
+{
+	if (m->size == 0 || m->sign < 0 || bigint_divrem(NULL, r, a, m) == FAILURE)
+		return FAILURE;
+	if (r->sign < 0 && r->size)
+		return bigint_add(r, r, m);
+	return SUCCESS;
+}
+
+/* Multiplication modulo m in whichever representation suits the modulus */
+typedef struct
+{
+	int mont;
+	apc_mont_t mctx;
+	int pre;
+	bigint_divisor_t div;
+	const bigint_t *m;
+	bigint_t prod;
+	bigint_t quot;
+}mod_ctx_t;
+
+static int mod_init(mod_ctx_t *c, const bigint_t *m)
+{
+	c->m = m;
+	c->pre = 0;
+	bigint_init(&c->prod);
+	bigint_init(&c->quot);
+	bigint_init(&c->div.v);
+	bigint_init(&c->div.inv);
+	c->mont = apc_mont_init(&c->mctx, m) == SUCCESS;
+	if (!c->mont && m->size >= apc_newton_threshold)
+	{
+		if (bigint_divisor_init(&c->div, m) == FAILURE)
+			return FAILURE;
+		c->pre = 1;
+	}
+	return SUCCESS;
+}
+
+static void mod_free(mod_ctx_t *c)
+{
+	if (c->mont)
+		apc_mont_free(&c->mctx);
+	bigint_divisor_free(&c->div);
+	bigint_free(&c->prod);
+	bigint_free(&c->quot);
+}
+
+/* r = a b mod m in the context's representation, r may alias a or b */
+static int mod_mul(mod_ctx_t *c, bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	if (c->mont)
+		return apc_mont_mul(&c->mctx, r, a, b);
+	if (bigint_mul(&c->prod, a, b) == FAILURE)
+		return FAILURE;
+	return c->pre ? bigint_divrem_pre(&c->quot, r, &c->prod, &c->div) : bigint_divrem(NULL, r, &c->prod, c->m);
+}
+
+/* Window width for an exponent of bits bits, balancing the table against the multiplications saved */
+static int window_bits(int bits)
+{
+	static const int limit[] = {7, 25, 81, 241, 673, 1793};
+	int k = 1;
+
+	while (k < 7 && bits > limit[k - 1])
+		k++;
+	return k;
+}
+
+static int exp_bit(const uint32_t *w, int i)
+{
+	return w[i / 32] >> (i % 32) & 1;
+}
+
+int bigint_powmod(bigint_t *r, const bigint_t *base, const bigint_t *exp, const bigint_t *m)
+{
+	bigint_t g, acc, table[64];
+	mod_ctx_t c;
+	uint32_t *w = NULL;
+	int count, status = FAILURE, k = 0;
+
+	if (m->size == 0 || m->sign < 0)
+		return FAILURE;
+	if (m->size == 1 && m->limb[0] == 1)
+		return bigint_set_int(r, 0);
+	if (exp->size == 0)
+		return bigint_set_int(r, 1);
+
+	bigint_init(&g);
+	bigint_init(&acc);
+	if (mod_init(&c, m) == FAILURE)
+		goto out;
+
+	/* g = base mod m, or its inverse for a negative exponent */
+	if ((exp->sign < 0 ? bigint_invmod(&g, base, m) : bigint_mod(&g, base, m)) == FAILURE)
+		goto out;
+	if (c.mont && apc_mont_to(&c.mctx, &g, &g) == FAILURE)
+		goto out;
+	if ((w = bigint_to_words(exp, &count)) == NULL)
+		goto out;
+
+	int bits = 32 * count;
+	while (bits > 1 && !exp_bit(w, bits - 1))
+		bits--;
+
+	/* table[i] = g^(2i + 1) */
+	k = window_bits(bits);
+	for (int i = 0; i < 1 << (k - 1); i++)
+		bigint_init(&table[i]);
+	if (bigint_copy(&table[0], &g) == FAILURE || (k > 1 && mod_mul(&c, &acc, &g, &g) == FAILURE))
+		goto out;
+	for (int i = 1; i < 1 << (k - 1); i++)
+		if (mod_mul(&c, &table[i], &table[i - 1], &acc) == FAILURE)
+			goto out;
+
+	/* Left to right: a zero bit squares, a window of up to k bits ending in a one squares and multiplies once */
+	int first = 1;
+	for (int i = bits - 1; i >= 0;)
+	{
+		if (!exp_bit(w, i))
+		{
+			if (mod_mul(&c, &acc, &acc, &acc) == FAILURE)
+				goto out;
+			i--;
+			continue;
+		}
+		int low = i - k + 1 < 0 ? 0 : i - k + 1, value = 0;
+		while (!exp_bit(w, low))
+			low++;
+		for (int j = i; j >= low; j--)
+		{
+			value = value << 1 | exp_bit(w, j);
+			if (!first && mod_mul(&c, &acc, &acc, &acc) == FAILURE)
+				goto out;
+		}
+		if ((first ? bigint_copy(&acc, &table[value / 2]) : mod_mul(&c, &acc, &acc, &table[value / 2])) == FAILURE)
+			goto out;
+		first = 0;
+		i = low - 1;
+	}
+
+	status = c.mont ? apc_mont_from(&c.mctx, r, &acc) : bigint_copy(r, &acc);
+out:
+	for (int i = 0; k && i < 1 << (k - 1); i++)
+		bigint_free(&table[i]);
+	free(w);
+	mod_free(&c);
+	bigint_free(&g);
+	bigint_free(&acc);
+	return status;
+}
+
+/* r = a^-1 mod m by the extended Euclidean algorithm, FAILURE when gcd(a, m) != 1 */
+int bigint_invmod(bigint_t *r, const bigint_t *a, const bigint_t *m)
+{
+	bigint_t r0, r1, s0, s1, q, t;
+	bigint_t *all[] = {&r0, &r1, &s0, &s1, &q, &t};
+	int status = FAILURE;
+
+	for (int i = 0; i < 6; i++)
+		bigint_init(all[i]);
+
+	/* Invariant: r0 = s0 a (mod m), r1 = s1 a (mod m) */
+	if (bigint_copy(&r0, m) == FAILURE || bigint_mod(&r1, a, m) == FAILURE ||
+			bigint_set_int(&s0, 0) == FAILURE || bigint_set_int(&s1, 1) == FAILURE)
+		goto out;
+	while (r1.size)
+	{
+		if (bigint_divrem(&q, &t, &r0, &r1) == FAILURE)
+			goto out;
+		bigint_swap(&r0, &r1);
+		bigint_swap(&r1, &t);
+		if (bigint_mul(&t, &q, &s1) == FAILURE || bigint_sub(&t, &s0, &t) == FAILURE)
+			goto out;
+		bigint_swap(&s0, &s1);
+		bigint_swap(&s1, &t);
+	}
+	if (r0.size == 1 && r0.limb[0] == 1)
+		status = bigint_mod(r, &s0, m);
+out:
+	for (int i = 0; i < 6; i++)
+		bigint_free(all[i]);
+	return status;
+}
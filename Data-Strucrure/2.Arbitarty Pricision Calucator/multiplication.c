@@ -1,6 +1,7 @@
 /*******************************************************************************************************************************************************************
 *Title			: Multiplication
 *Description		: This function performs multiplication of two given large numbers and store the result in the resultant list.
+			: The lists are packed into base 10^9 limb vectors (bigint_t) and the limb kernel does the work.
 *Prototype		: int multiplication(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
 *Input Parameters	: head1: Pointer to the first node of the first double linked list.
 			: tail1: Pointer to the last node of the first double linked list.
@@ -9,9 +10,368 @@
 			: headR: Pointer to the first node of the resultant double linked list.
 *Output			: Status (SUCCESS / FAILURE)
 *******************************************************************************************************************************************************************/
+#include <string.h>
 #include "apc.h"
 
+/* Crossover points in limbs, see apc_tune() */
+int apc_karatsuba_threshold = APC_KARATSUBA_THRESHOLD;
+int apc_toom3_threshold = APC_TOOM3_THRESHOLD;
+int apc_ntt_threshold = APC_NTT_THRESHOLD;
+int apc_parallel_threshold = APC_PARALLEL_THRESHOLD;
+
+/* Limb kernel: r[0..n) = a[0..n) * d for d < APC_BASE, returns the carry out, r may alias a */
+limb_t apc_mul_1(limb_t *r, const limb_t *a, int n, limb_t d)
+{
+	uint64_t carry = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		uint64_t t = (uint64_t)a[i] * d + carry;
+		r[i] = t % APC_BASE;
+		carry = t / APC_BASE;
+	}
+	return carry;
+}
+
+/* r = a * d for d < APC_BASE */
+int bigint_mul_1(bigint_t *r, const bigint_t *a, limb_t d)
+{
+	int n = a->size;
+
+	if (bigint_reserve(r, n + 1) == FAILURE)
+		return FAILURE;
+	r->limb[n] = apc_mul_1(r->limb, a->limb, n, d);
+	r->size = n + 1;
+	r->sign = a->sign;
+	bigint_normalize(r);
+	return SUCCESS;
+}
+
+/* Limb kernel: r[0..n) += a[0..n) * d for d < APC_BASE, returns the carry out */
+limb_t apc_addmul_1(limb_t *r, const limb_t *a, int n, limb_t d)
+{
+	uint64_t carry = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		uint64_t t = (uint64_t)a[i] * d + r[i] + carry;
+		r[i] = t % APC_BASE;
+		carry = t / APC_BASE;
+	}
+	return carry;
+}
+
+/* Products below 10^18 leave room for 18 of them in a 64 bit column before it has to be carried */
+#define COLUMN_ROWS 18
+#define BASECASE_STACK 512
+
+/* Schoolbook product r[0..n+m) = a[0..n) * b[0..m), r must not alias a or b */
+void apc_mul_basecase(limb_t *r, const limb_t *a, int n, const limb_t *b, int m)
+{
+	uint64_t stack[BASECASE_STACK], *acc = stack;
+
+	if (n + m > BASECASE_STACK && (acc = apc_alloc((size_t)(n + m) * sizeof(uint64_t))) == NULL)
+	{
+		/* out of memory: fall back to carrying every row */
+		memset(r, 0, (size_t)(n + m) * sizeof(limb_t));
+		for (int i = 0; i < n; i++)
+		{
+			uint64_t carry = 0;
+			for (int j = 0; j < m; j++)
+			{
+				uint64_t t = (uint64_t)a[i] * b[j] + r[i + j] + carry;
+				r[i + j] = t % APC_BASE;
+				carry = t / APC_BASE;
+			}
+			r[i + m] = carry;
+		}
+		return;
+	}
+
+	memset(acc, 0, (size_t)(n + m) * sizeof(uint64_t));
+	for (int i = 0; i < n; i += COLUMN_ROWS - 1)
+	{
+		int rows = n - i < COLUMN_ROWS - 1 ? n - i : COLUMN_ROWS - 1;
+		for (int k = i; k < i + rows; k++)
+		{
+			uint64_t ak = a[k];
+			uint64_t *col = acc + k;
+			for (int j = 0; j < m; j++)
+				col[j] += ak * b[j];
+		}
+		/* carry the touched columns so each one holds less than APC_BASE again */
+		uint64_t carry = 0;
+		for (int k = i; k < n + m; k++)
+		{
+			uint64_t t = acc[k] + carry;
+			acc[k] = t % APC_BASE;
+			carry = t / APC_BASE;
+			if (carry == 0 && k >= i + rows + m)
+				break;
+		}
+	}
+	for (int k = 0; k < n + m; k++)
+		r[k] = acc[k];
+	if (acc != stack)
+		apc_release(acc);
+}
+
+/* r[0..len) += x[0..xn) with the carry rippling up, xn <= len */
+static void add_into(limb_t *r, int len, const limb_t *x, int xn)
+{
+	limb_t carry = apc_add_n(r, r, x, xn);
+	apc_add_1(r + xn, r + xn, len - xn, carry);
+}
+
+/* Independent sub-products, handed to the thread pool when they are big enough to pay for it */
+typedef struct
+{
+	limb_t *r;
+	const limb_t *a;
+	int n;
+	const limb_t *b;
+	int m;
+	int status;
+}mul_job_t;
+
+static void mul_job(void *arg)
+{
+	mul_job_t *job = arg;
+	job->status = apc_mul(job->r, job->a, job->n, job->b, job->m);
+}
+
+/* Run count jobs, spread over the pool when parallel is set, SUCCESS when all of them succeed */
+static int run_jobs(mul_job_t *job, int count, int parallel)
+{
+	apc_task_t task[count];
+	int status = SUCCESS;
+
+	parallel = parallel && apc_get_threads() > 1;
+	for (int i = 1; i < count; i++)
+		if (parallel)
+			apc_spawn(&task[i], mul_job, &job[i]);
+		else
+			mul_job(&job[i]);
+	mul_job(&job[0]);
+	for (int i = 0; i < count; i++)
+	{
+		if (parallel && i > 0)
+			apc_wait(&task[i]);
+		if (job[i].status == FAILURE)
+			status = FAILURE;
+	}
+	return status;
+}
+
+/*
+ * Unbalanced product, m <= n / 2: multiply b by m limb slices of a and add them up.
+ * With more than one thread a group of slices is multiplied at once into separate buffers.
+ */
+static int mul_slices(limb_t *r, const limb_t *a, int n, const limb_t *b, int m)
+{
+	int group = m >= apc_parallel_threshold ? apc_get_threads() : 1;
+	limb_t *temp = apc_alloc((size_t)2 * m * group * sizeof(limb_t));
+	if (temp == NULL)
+		return FAILURE;
+
+	memset(r, 0, (size_t)(n + m) * sizeof(limb_t));
+	for (int i = 0; i < n; i += m * group)
+	{
+		mul_job_t job[group];
+		int count = 0;
+		for (int k = i; k < n && count < group; k += m, count++)
+			job[count] = (mul_job_t){temp + 2 * m * count, b, m, a + k, n - k < m ? n - k : m, SUCCESS};
+		if (run_jobs(job, count, group > 1) == FAILURE)
+		{
+			apc_release(temp);
+			return FAILURE;
+		}
+		for (int c = 0; c < count; c++)
+			add_into(r + i + c * m, n + m - i - c * m, job[c].r, m + job[c].m);
+	}
+	apc_release(temp);
+	return SUCCESS;
+}
+
+/*
+ * Karatsuba, n / 2 < m <= n: with a = a1 B^h + a0 and b = b1 B^h + b0,
+ * a b = z2 B^2h + ((a0 + a1)(b0 + b1) - z0 - z2) B^h + z0
+ */
+static int mul_karatsuba(limb_t *r, const limb_t *a, int n, const limb_t *b, int m)
+{
+	int h = (n + 1) / 2, n1 = n - h, m1 = m - h;
+	limb_t *sa = apc_alloc((size_t)(4 * h + 4) * sizeof(limb_t));
+	if (sa == NULL)
+		return FAILURE;
+	limb_t *sb = sa + h + 1, *z1 = sb + h + 1;
+
+	sa[h] = apc_add_1(sa + n1, a + n1, h - n1, apc_add_n(sa, a, a + h, n1));
+	sb[h] = apc_add_1(sb + m1, b + m1, h - m1, apc_add_n(sb, b, b + h, m1));
+
+	/* z1 has its own buffer and z0, z2 land in disjoint halves of r, so the three products are independent */
+	mul_job_t job[3] = {
+		{z1, sa, h + 1, sb, h + 1, SUCCESS},
+		{r, a, h, b, h, SUCCESS},
+		{r + 2 * h, a + h, n1, b + h, m1, SUCCESS},
+	};
+	int status = run_jobs(job, 3, m >= apc_parallel_threshold);
+	if (status == SUCCESS)
+	{
+		apc_sub_1(z1 + 2 * h, z1 + 2 * h, 2, apc_sub_n(z1, z1, r, 2 * h));
+		apc_sub_1(z1 + n1 + m1, z1 + n1 + m1, 2 * h + 2 - n1 - m1, apc_sub_n(z1, z1, r + 2 * h, n1 + m1));
+
+		/* the middle term fits below B^(n + m - h), its top limbs are zero */
+		int len = 2 * h + 2 < n + m - h ? 2 * h + 2 : n + m - h;
+		add_into(r + h, n + m - h, z1, len);
+	}
+	apc_release(sa);
+	return status;
+}
+
+/* Copy limbs [from, to) of a into a bigint, clamped to n */
+static int slice(bigint_t *dst, const limb_t *a, int n, int from, int to)
+{
+	if (to > n)
+		to = n;
+	if (from > to)
+		from = to;
+	if (bigint_reserve(dst, to - from + 1) == FAILURE)
+		return FAILURE;
+	if (to > from)
+		memcpy(dst->limb, a + from, (size_t)(to - from) * sizeof(limb_t));
+	dst->size = to - from;
+	dst->sign = 1;
+	bigint_normalize(dst);
+	return SUCCESS;
+}
+
+/* Evaluate x2 t^2 + x1 t + x0 at t = 0, 1, -1, -2 into v[0..4) */
+static int toom3_evaluate(bigint_t *v, const bigint_t *x0, const bigint_t *x1, const bigint_t *x2)
+{
+	if (bigint_copy(&v[0], x0) == FAILURE || bigint_add(&v[1], x0, x2) == FAILURE ||
+			bigint_sub(&v[2], &v[1], x1) == FAILURE || bigint_add(&v[1], &v[1], x1) == FAILURE ||
+			bigint_add(&v[3], &v[2], x2) == FAILURE || bigint_add(&v[3], &v[3], &v[3]) == FAILURE ||
+			bigint_sub(&v[3], &v[3], x0) == FAILURE)
+		return FAILURE;
+	return SUCCESS;
+}
+
+/*
+ * Toom-3 over the points 0, 1, -1, -2 and infinity with Bodrato's interpolation sequence,
+ * 2n / 3 < m <= n. The five pointwise products recurse through bigint_mul.
+ */
+static int mul_toom3(limb_t *r, const limb_t *a, int n, const limb_t *b, int m)
+{
+	int k = (n + 2) / 3, status = FAILURE;
+	bigint_t x[3], y[3], va[4], vb[4], w[5];
+	bigint_t *all[] = {&x[0], &x[1], &x[2], &y[0], &y[1], &y[2], &va[0], &va[1], &va[2], &va[3],
+		&vb[0], &vb[1], &vb[2], &vb[3], &w[0], &w[1], &w[2], &w[3], &w[4]};
+	int total = sizeof(all) / sizeof(all[0]);
+
+	for (int i = 0; i < total; i++)
+		bigint_init(all[i]);
+
+	for (int i = 0; i < 3; i++)
+		if (slice(&x[i], a, n, i * k, (i + 1) * k) == FAILURE || slice(&y[i], b, m, i * k, (i + 1) * k) == FAILURE)
+			goto out;
+	if (toom3_evaluate(va, &x[0], &x[1], &x[2]) == FAILURE || toom3_evaluate(vb, &y[0], &y[1], &y[2]) == FAILURE)
+		goto out;
+
+	/* w0 = r(0), w1 = r(1), w2 = r(-1), w3 = r(-2), w4 = r(inf), as independent limb products */
+	mul_job_t job[5];
+	const bigint_t *pa[5] = {&va[0], &va[1], &va[2], &va[3], &x[2]}, *pb[5] = {&vb[0], &vb[1], &vb[2], &vb[3], &y[2]};
+	int count = 0;
+	for (int i = 0; i < 5; i++)
+	{
+		int size = pa[i]->size + pb[i]->size;
+		if (bigint_reserve(&w[i], size) == FAILURE)
+			goto out;
+		w[i].size = pa[i]->size && pb[i]->size ? size : 0;
+		w[i].sign = pa[i]->sign * pb[i]->sign;
+		if (w[i].size)
+			job[count++] = (mul_job_t){w[i].limb, pa[i]->limb, pa[i]->size, pb[i]->limb, pb[i]->size, SUCCESS};
+	}
+	if (count && run_jobs(job, count, m >= apc_parallel_threshold) == FAILURE)
+		goto out;
+	for (int i = 0; i < 5; i++)
+		bigint_normalize(&w[i]);
+
+	/* interpolation: every division below is exact */
+	if (bigint_sub(&w[3], &w[3], &w[1]) == FAILURE || bigint_divrem_1(&w[3], &w[3], 3, NULL) == FAILURE ||
+			bigint_sub(&w[1], &w[1], &w[2]) == FAILURE || bigint_divrem_1(&w[1], &w[1], 2, NULL) == FAILURE ||
+			bigint_sub(&w[2], &w[2], &w[0]) == FAILURE ||
+			bigint_sub(&w[3], &w[2], &w[3]) == FAILURE || bigint_divrem_1(&w[3], &w[3], 2, NULL) == FAILURE ||
+			bigint_add(&w[3], &w[3], &w[4]) == FAILURE || bigint_add(&w[3], &w[3], &w[4]) == FAILURE ||
+			bigint_add(&w[2], &w[2], &w[1]) == FAILURE || bigint_sub(&w[2], &w[2], &w[4]) == FAILURE ||
+			bigint_sub(&w[1], &w[1], &w[3]) == FAILURE)
+		goto out;
+
+	/* recomposition: the coefficients w0, w1, w2, w3, w4 of t^0 .. t^4 are all non negative */
+	memset(r, 0, (size_t)(n + m) * sizeof(limb_t));
+	for (int i = 0; i < 5; i++)
+		if (w[i].size)
+			add_into(r + i * k, n + m - i * k, w[i].limb, w[i].size);
+	status = SUCCESS;
+out:
+	for (int i = 0; i < total; i++)
+		bigint_free(all[i]);
+	return status;
+}
+
+/* Product r[0..n+m) = a[0..n) * b[0..m) for n, m >= 1, picking the algorithm by size */
+int apc_mul(limb_t *r, const limb_t *a, int n, const limb_t *b, int m)
+{
+	if (n < m)
+		return apc_mul(r, b, m, a, n);
+	if (m < apc_karatsuba_threshold)
+	{
+		apc_mul_basecase(r, a, n, b, m);
+		return SUCCESS;
+	}
+	/* the transform takes unbalanced operands as they are; when out of memory fall back to Toom-Cook */
+	if (m >= apc_ntt_threshold && n + m <= apc_ntt_max_limbs() && apc_mul_ntt(r, a, n, b, m) == SUCCESS)
+		return SUCCESS;
+	if (m <= (n + 1) / 2)
+		return mul_slices(r, a, n, b, m);
+	if (m >= apc_toom3_threshold && m > 2 * ((n + 2) / 3))
+		return mul_toom3(r, a, n, b, m);
+	return mul_karatsuba(r, a, n, b, m);
+}
+
+int bigint_mul(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	if (a->size == 0 || b->size == 0)
+		return bigint_set_int(r, 0);
+
+	/* A result distinct from both operands is written in place, so a reused temporary keeps its buffer */
+	if (r != a && r != b)
+	{
+		if (bigint_reserve(r, a->size + b->size) == FAILURE ||
+				apc_mul(r->limb, a->limb, a->size, b->limb, b->size) == FAILURE)
+			return FAILURE;
+		r->size = a->size + b->size;
+		r->sign = a->sign * b->sign;
+		bigint_normalize(r);
+		return SUCCESS;
+	}
+
+	bigint_t temp;
+	bigint_init(&temp);
+	if (bigint_reserve(&temp, a->size + b->size) == FAILURE ||
+			apc_mul(temp.limb, a->limb, a->size, b->limb, b->size) == FAILURE)
+	{
+		bigint_free(&temp);
+		return FAILURE;
+	}
+	temp.size = a->size + b->size;
+	temp.sign = a->sign * b->sign;
+	bigint_normalize(&temp);
+	bigint_swap(r, &temp);
+	bigint_free(&temp);
+	return SUCCESS;
+}
+
 int multiplication(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR)
 {
-	/* Definition goes here */
+	return dlist_operation(bigint_mul, head1, tail1, head2, tail2, headR);
 }
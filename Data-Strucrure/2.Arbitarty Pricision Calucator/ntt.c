@@ -0,0 +1,405 @@
+/*******************************************************************************************************************************************************************
+*Title			: NTT multiplication
+*Description		: This function multiplies very large limb arrays with a number theoretic transform over three 30 bit primes and rebuilds
+*			: the exact convolution by the Chinese remainder theorem. A convolution term is at most 2^24 * (10^9 - 1)^2 < 1.7 * 10^25,
+*			: below the product of the primes (5.9 * 10^25), so the reconstruction is exact for every length the primes support.
+*			: With more than one thread the three primes, the halves of every large transform and the elementwise passes run on
+*			: the thread pool.
+*Prototype		: int apc_mul_ntt(limb_t *r, const limb_t *a, int n, const limb_t *b, int m);
+*Input Parameters	: r: Result limbs, n + m of them, must not alias a or b.
+			: a, n: First operand and its limb count.
+			: b, m: Second operand and its limb count.
+*Output			: Status (SUCCESS / FAILURE)
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include <pthread.h>
+#include "apc.h"
+
+/* Primes p = c 2^k + 1 below 2^30, each with its primitive root and Montgomery constants (filled in on first use) */
+typedef struct
+{
+	uint32_t p;
+	uint32_t g;
+	int log2_max;
+	uint32_t pinv;	/* -p^-1 mod 2^32 */
+	uint32_t r2;	/* 2^64 mod p */
+}ntt_prime_t;
+
+static ntt_prime_t primes[3] = {
+	{469762049, 3, 26, 0, 0},
+	{167772161, 3, 25, 0, 0},
+	{754974721, 11, 24, 0, 0},
+};
+
+static inline uint32_t mont_reduce(uint64_t t, const ntt_prime_t *P)
+{
+	uint32_t q = (uint32_t)t * P->pinv;
+	uint32_t u = (t + (uint64_t)q * P->p) >> 32;
+	return u >= P->p ? u - P->p : u;
+}
+
+static inline uint32_t mont_mul(uint32_t a, uint32_t b, const ntt_prime_t *P)
+{
+	return mont_reduce((uint64_t)a * b, P);
+}
+
+static inline uint32_t mod_add(uint32_t a, uint32_t b, uint32_t p)
+{
+	uint32_t s = a + b;
+	return s >= p ? s - p : s;
+}
+
+static inline uint32_t mod_sub(uint32_t a, uint32_t b, uint32_t p)
+{
+	return a >= b ? a - b : a + p - b;
+}
+
+static uint32_t pow_mod(uint64_t base, uint64_t exp, uint32_t p)
+{
+	uint64_t result = 1;
+
+	base %= p;
+	for (; exp; exp >>= 1)
+	{
+		if (exp & 1)
+			result = result * base % p;
+		base = base * base % p;
+	}
+	return result;
+}
+
+static void prime_setup(ntt_prime_t *P)
+{
+	if (P->pinv)
+		return;
+
+	/* Newton iteration for p^-1 mod 2^32, each step doubles the correct bits */
+	uint32_t inv = P->p;
+	for (int i = 0; i < 4; i++)
+		inv *= 2 - P->p * inv;
+	P->r2 = (uint32_t)(((unsigned __int128)1 << 64) % P->p);
+	P->pinv = -inv;
+}
+
+/* Root table w[j] = root^j for j < len / 2 in Montgomery form, root of order len (inverse root when inverse is set) */
+static void root_table(uint32_t *w, int len, int inverse, const ntt_prime_t *P)
+{
+	uint32_t root = pow_mod(P->g, (P->p - 1) / len, P->p);
+	if (inverse)
+		root = pow_mod(root, P->p - 2, P->p);
+
+	uint32_t step = mont_mul(root, P->r2, P), cur = mont_mul(1, P->r2, P);
+	for (int j = 0; j < len / 2; j++)
+	{
+		w[j] = cur;
+		cur = mont_mul(cur, step, P);
+	}
+}
+
+/* Gentleman-Sande forward transform: natural order in, bit reversed order out. base is the root stride of a block inside a longer transform */
+static void ntt_dif(uint32_t *a, int len, const uint32_t *w, int base, const ntt_prime_t *P)
+{
+	uint32_t p = P->p;
+
+	for (int size = len; size >= 2; size >>= 1)
+	{
+		int half = size / 2, stride = base * (len / size);
+		for (int i = 0; i < len; i += size)
+			for (int j = 0; j < half; j++)
+			{
+				uint32_t u = a[i + j], v = a[i + j + half];
+				a[i + j] = mod_add(u, v, p);
+				a[i + j + half] = mont_mul(mod_sub(u, v, p), w[j * stride], P);
+			}
+	}
+}
+
+/* Cooley-Tukey inverse transform: bit reversed order in, natural order out, scaled by len */
+static void ntt_dit(uint32_t *a, int len, const uint32_t *w, int base, const ntt_prime_t *P)
+{
+	uint32_t p = P->p;
+
+	for (int size = 2; size <= len; size <<= 1)
+	{
+		int half = size / 2, stride = base * (len / size);
+		for (int i = 0; i < len; i += size)
+			for (int j = 0; j < half; j++)
+			{
+				uint32_t u = a[i + j], v = mont_mul(a[i + j + half], w[j * stride], P);
+				a[i + j] = mod_add(u, v, p);
+				a[i + j + half] = mod_sub(u, v, p);
+			}
+	}
+}
+
+/*
+ * With threads the transforms recurse: the first (forward) or last (inverse) stage of a block is one row
+ * of len / 2 butterflies, split over the pool, and the two halves are independent transforms of half the
+ * length run as separate tasks. Blocks up to NTT_PARALLEL_GRAIN use the loops above.
+ */
+#define NTT_PARALLEL_GRAIN (1 << 14)
+
+typedef struct
+{
+	uint32_t *a;
+	int len;
+	const uint32_t *w;
+	int base;
+	int inverse;
+	const ntt_prime_t *P;
+}ntt_block_t;
+
+static void butterfly_row(void *ctx, int lo, int hi)
+{
+	ntt_block_t *blk = ctx;
+	uint32_t *a = blk->a, p = blk->P->p;
+	int half = blk->len / 2;
+
+	for (int j = lo; j < hi; j++)
+	{
+		uint32_t u = a[j], v = a[j + half], t = blk->w[j * blk->base];
+		if (blk->inverse)
+		{
+			v = mont_mul(v, t, blk->P);
+			a[j] = mod_add(u, v, p);
+			a[j + half] = mod_sub(u, v, p);
+		}
+		else
+		{
+			a[j] = mod_add(u, v, p);
+			a[j + half] = mont_mul(mod_sub(u, v, p), t, blk->P);
+		}
+	}
+}
+
+static void ntt_block(void *arg)
+{
+	ntt_block_t *blk = arg;
+
+	if (blk->len <= NTT_PARALLEL_GRAIN || apc_get_threads() == 1)
+	{
+		(blk->inverse ? ntt_dit : ntt_dif)(blk->a, blk->len, blk->w, blk->base, blk->P);
+		return;
+	}
+
+	int half = blk->len / 2;
+	ntt_block_t low = {blk->a, half, blk->w, 2 * blk->base, blk->inverse, blk->P};
+	ntt_block_t high = {blk->a + half, half, blk->w, 2 * blk->base, blk->inverse, blk->P};
+	apc_task_t task;
+
+	if (!blk->inverse)
+		apc_parallel_for(half, NTT_PARALLEL_GRAIN / 4, butterfly_row, blk);
+	apc_spawn(&task, ntt_block, &high);
+	ntt_block(&low);
+	apc_wait(&task);
+	if (blk->inverse)
+		apc_parallel_for(half, NTT_PARALLEL_GRAIN / 4, butterfly_row, blk);
+}
+
+static void ntt_transform(uint32_t *a, int len, const uint32_t *w, int inverse, const ntt_prime_t *P)
+{
+	ntt_block_t blk = {a, len, w, 1, inverse, P};
+	ntt_block(&blk);
+}
+
+/* Elementwise passes, split over the pool in chunks of at least NTT_PASS_GRAIN */
+#define NTT_PASS_GRAIN 8192
+
+typedef struct
+{
+	uint32_t *f;
+	const limb_t *a;
+	int n;
+	const uint32_t *g;
+	uint32_t scale;
+	const ntt_prime_t *P;
+}ntt_pass_t;
+
+/* Load limbs into Montgomery form, zero padded */
+static void load_range(void *ctx, int lo, int hi)
+{
+	ntt_pass_t *pass = ctx;
+
+	for (int i = lo; i < hi; i++)
+		pass->f[i] = i < pass->n ? mont_mul(pass->a[i] % pass->P->p, pass->P->r2, pass->P) : 0;
+}
+
+/* f = f g pointwise, or f = f scale when g is NULL */
+static void mul_range(void *ctx, int lo, int hi)
+{
+	ntt_pass_t *pass = ctx;
+
+	for (int i = lo; i < hi; i++)
+		pass->f[i] = mont_mul(pass->f[i], pass->g ? pass->g[i] : pass->scale, pass->P);
+}
+
+/* Convolution of a and b modulo one prime into res[0..n+m) */
+static int ntt_convolve(uint32_t *res, const limb_t *a, int n, const limb_t *b, int m, int len, uint32_t *fa, uint32_t *fb, const ntt_prime_t *P)
+{
+	uint32_t *w = apc_alloc((size_t)(len / 2 + 1) * sizeof(uint32_t));
+	if (w == NULL)
+		return FAILURE;
+
+	root_table(w, len, 0, P);
+	apc_parallel_for(len, NTT_PASS_GRAIN, load_range, &(ntt_pass_t){fa, a, n, NULL, 0, P});
+	ntt_transform(fa, len, w, 0, P);
+	if (a == b && n == m)
+		fb = fa;
+	else
+	{
+		apc_parallel_for(len, NTT_PASS_GRAIN, load_range, &(ntt_pass_t){fb, b, m, NULL, 0, P});
+		ntt_transform(fb, len, w, 0, P);
+	}
+	apc_parallel_for(len, NTT_PASS_GRAIN, mul_range, &(ntt_pass_t){fa, NULL, 0, fb, 0, P});
+
+	root_table(w, len, 1, P);
+	ntt_transform(fa, len, w, 1, P);
+
+	/* mont_mul by the plain len^-1 drops both the scale and the Montgomery factor */
+	apc_parallel_for(n + m, NTT_PASS_GRAIN, mul_range, &(ntt_pass_t){fa, NULL, 0, NULL, pow_mod(len, P->p - 2, P->p), P});
+	memcpy(res, fa, (size_t)(n + m) * sizeof(uint32_t));
+	apc_release(w);
+	return SUCCESS;
+}
+
+/* One prime of the product, a task of its own when there are threads */
+typedef struct
+{
+	uint32_t *res;
+	const limb_t *a;
+	int n;
+	const limb_t *b;
+	int m;
+	int len;
+	uint32_t *fa;
+	uint32_t *fb;
+	const ntt_prime_t *P;
+	int status;
+}ntt_job_t;
+
+static void ntt_job(void *arg)
+{
+	ntt_job_t *job = arg;
+	job->status = ntt_convolve(job->res, job->a, job->n, job->b, job->m, job->len, job->fa, job->fb, job->P);
+}
+
+/* Garner reconstruction in chunks that each start from a zero carry */
+#define GARNER_CHUNKS 64
+
+typedef struct
+{
+	limb_t *r;
+	const uint32_t *res[3];
+	unsigned __int128 carry[GARNER_CHUNKS];	/* carry out of each chunk */
+	int chunks;
+	int total;
+}garner_t;
+
+/* Garner: x = x0 + p0 t1 + p0 p1 t2 with t1 < p1, t2 < p2, for limbs [lo, hi), returns the carry out */
+static unsigned __int128 garner_range(garner_t *g, int lo, int hi)
+{
+	uint64_t p0 = primes[0].p, p1 = primes[1].p, p2 = primes[2].p;
+	uint64_t inv_p0_p1 = pow_mod(p0, p1 - 2, p1);
+	uint64_t inv_p0p1_p2 = pow_mod(p0 * p1 % p2, p2 - 2, p2);
+	unsigned __int128 carry = 0;
+
+	for (int i = lo; i < hi; i++)
+	{
+		uint64_t x0 = g->res[0][i], x1 = g->res[1][i], x2 = g->res[2][i];
+		uint64_t t1 = (x1 + p1 - x0 % p1) % p1 * inv_p0_p1 % p1;
+		uint64_t t2 = (x2 + p2 - (x0 + p0 * t1) % p2) % p2 * inv_p0p1_p2 % p2;
+		unsigned __int128 value = x0 + p0 * t1 + (unsigned __int128)(p0 * p1) * t2 + carry;
+
+		g->r[i] = (limb_t)(value % APC_BASE);
+		carry = value / APC_BASE;
+	}
+	return carry;
+}
+
+static int chunk_start(const garner_t *g, int c)
+{
+	return (int)((long long)g->total * c / g->chunks);
+}
+
+static void garner_chunk(void *ctx, int lo, int hi)
+{
+	garner_t *g = ctx;
+
+	for (int c = lo; c < hi; c++)
+		g->carry[c] = garner_range(g, chunk_start(g, c), chunk_start(g, c + 1));
+}
+
+/* Largest product, in limbs, the transform can handle */
+int apc_ntt_max_limbs(void)
+{
+	return 1 << primes[2].log2_max;
+}
+
+static pthread_once_t setup_once = PTHREAD_ONCE_INIT;
+
+static void setup_primes(void)
+{
+	for (int i = 0; i < 3; i++)
+		prime_setup(&primes[i]);
+}
+
+int apc_mul_ntt(limb_t *r, const limb_t *a, int n, const limb_t *b, int m)
+{
+	int len = 1, total = n + m, parallel = apc_get_threads() > 1;
+
+	while (len < total)
+		len <<= 1;
+	if (len > apc_ntt_max_limbs())
+		return FAILURE;
+	pthread_once(&setup_once, setup_primes);
+
+	/* With threads every prime gets its own transform buffers so the three convolutions run side by side */
+	int sets = parallel ? 3 : 1;
+	uint32_t *fa = apc_alloc((size_t)(2 * len * sets + 3 * total) * sizeof(uint32_t));
+	if (fa == NULL)
+		return FAILURE;
+	uint32_t *res = fa + (size_t)2 * len * sets;
+
+	ntt_job_t job[3];
+	apc_task_t task[3];
+	int status = SUCCESS;
+	for (int i = 0; i < 3; i++)
+	{
+		uint32_t *f = fa + (size_t)2 * len * (parallel ? i : 0);
+		job[i] = (ntt_job_t){res + (size_t)i * total, a, n, b, m, len, f, f + len, &primes[i], SUCCESS};
+		if (parallel && i > 0)
+			apc_spawn(&task[i], ntt_job, &job[i]);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		if (!parallel || i == 0)
+			ntt_job(&job[i]);
+		else
+			apc_wait(&task[i]);
+		if (job[i].status == FAILURE)
+			status = FAILURE;
+	}
+	if (status == FAILURE)
+	{
+		apc_release(fa);
+		return FAILURE;
+	}
+
+	/* The chunk carries are rippled up afterwards, in order */
+	garner_t g = {r, {res, res + total, res + 2 * total}, {0}, parallel ? GARNER_CHUNKS : 1, total};
+	if (g.chunks > total)
+		g.chunks = total;
+	apc_parallel_for(g.chunks, 1, garner_chunk, &g);
+	for (int c = 0; c + 1 < g.chunks; c++)
+	{
+		unsigned __int128 carry = g.carry[c];
+		for (int i = chunk_start(&g, c + 1); carry && i < total; i++)
+		{
+			carry += r[i];
+			r[i] = (limb_t)(carry % APC_BASE);
+			carry /= APC_BASE;
+		}
+	}
+	apc_release(fa);
+	return SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*******************************************************************************************************************************************************************
+*Title			: Work stealing thread pool
+*Description		: These functions run fork-join tasks for the multiplication engine on a fixed set of worker threads. Every worker, and
+*			: the calling thread as worker 0, owns a deque: it pushes and pops its own tasks at the bottom (newest first, which keeps
+*			: the recursion depth first and cache friendly) while idle workers steal the oldest, biggest tasks from the top of the
+*			: others. A thread waiting for a task keeps running other tasks meanwhile, so nested spawns never block a worker.
+*			: With one thread (the default) apc_spawn() runs the task at once and no thread is ever started.
+*Prototype		: int apc_set_threads(int count);
+*			: void apc_spawn(apc_task_t *task, void (*fn)(void *), void *arg);
+*			: void apc_wait(apc_task_t *task);
+*			: void apc_parallel_for(int n, int grain, void (*fn)(void *ctx, int lo, int hi), void *ctx);
+*Output			: Status (SUCCESS / FAILURE)
+*******************************************************************************************************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include "apc.h"
+
+#define DEQUE_SIZE 1024
+#define MAX_CHUNKS 64
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	apc_task_t *task[DEQUE_SIZE];
+	int top;	/* oldest task, stolen by others */
+	int bottom;	/* one past the newest task, owner end */
+}deque_t;
+
+static struct
+{
+	int count;
+	pthread_t *thread;
+	deque_t *deque;
+	pthread_mutex_t idle_lock;
+	pthread_cond_t idle_cond;
+	atomic_int pending;
+	atomic_int stop;
+}pool = {1, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0};
+
+/* Deque owned by this thread, the calling thread and any thread outside the pool use 0 */
+static _Thread_local int worker_id;
+
+int apc_get_threads(void)
+{
+	return pool.count;
+}
+
+static int push(deque_t *d, apc_task_t *task)
+{
+	int status = FAILURE;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->bottom - d->top < DEQUE_SIZE)
+	{
+		d->task[d->bottom++ % DEQUE_SIZE] = task;
+		status = SUCCESS;
+	}
+	pthread_mutex_unlock(&d->lock);
+	return status;
+}
+
+static apc_task_t *pop(deque_t *d, int steal)
+{
+	apc_task_t *task = NULL;
+
+	pthread_mutex_lock(&d->lock);
+	if (d->bottom > d->top)
+		task = steal ? d->task[d->top++ % DEQUE_SIZE] : d->task[--d->bottom % DEQUE_SIZE];
+	if (d->bottom == d->top)
+		d->bottom = d->top = 0;
+	pthread_mutex_unlock(&d->lock);
+	if (task)
+		atomic_fetch_sub(&pool.pending, 1);
+	return task;
+}
+
+/* Own deque first, then steal round robin starting after ourselves */
+static apc_task_t *find_task(int id)
+{
+	apc_task_t *task = pop(&pool.deque[id], 0);
+
+	for (int i = 1; task == NULL && i < pool.count; i++)
+		task = pop(&pool.deque[(id + i) % pool.count], 1);
+	return task;
+}
+
+static void run(apc_task_t *task)
+{
+	task->fn(task->arg);
+	atomic_store_explicit(&task->done, 1, memory_order_release);
+}
+
+static void *worker(void *arg)
+{
+	worker_id = (int)(intptr_t)arg;
+	while (!atomic_load(&pool.stop))
+	{
+		apc_task_t *task = find_task(worker_id);
+		if (task)
+		{
+			run(task);
+			continue;
+		}
+		pthread_mutex_lock(&pool.idle_lock);
+		while (atomic_load(&pool.pending) == 0 && !atomic_load(&pool.stop))
+			pthread_cond_wait(&pool.idle_cond, &pool.idle_lock);
+		pthread_mutex_unlock(&pool.idle_lock);
+	}
+	apc_pool_trim();
+	return NULL;
+}
+
+/* Stop and join the workers 1 .. started - 1 and fall back to running everything on the caller */
+static void stop_workers(int started)
+{
+	pthread_mutex_lock(&pool.idle_lock);
+	atomic_store(&pool.stop, 1);
+	pthread_cond_broadcast(&pool.idle_cond);
+	pthread_mutex_unlock(&pool.idle_lock);
+	for (int i = 1; i < started; i++)
+		pthread_join(pool.thread[i], NULL);
+	for (int i = 0; i < pool.count; i++)
+		pthread_mutex_destroy(&pool.deque[i].lock);
+	free(pool.thread);
+	free(pool.deque);
+	pool.thread = NULL;
+	pool.deque = NULL;
+	pool.count = 1;
+	atomic_store(&pool.stop, 0);
+}
+
+/* Restart the pool with count threads in total, the caller included; must not run while tasks are in flight */
+int apc_set_threads(int count)
+{
+	if (count < 1)
+		return FAILURE;
+	if (pool.count > 1)
+		stop_workers(pool.count);
+	if (count == 1)
+		return SUCCESS;
+
+	pool.thread = malloc((size_t)count * sizeof(pthread_t));
+	pool.deque = calloc(count, sizeof(deque_t));
+	if (pool.thread == NULL || pool.deque == NULL)
+	{
+		free(pool.thread);
+		free(pool.deque);
+		pool.thread = NULL;
+		pool.deque = NULL;
+		return FAILURE;
+	}
+	for (int i = 0; i < count; i++)
+		pthread_mutex_init(&pool.deque[i].lock, NULL);
+	atomic_store(&pool.pending, 0);
+	worker_id = 0;
+
+	/* Workers read count, so it is set before any of them starts */
+	pool.count = count;
+	for (int i = 1; i < count; i++)
+		if (pthread_create(&pool.thread[i], NULL, worker, (void *)(intptr_t)i))
+		{
+			stop_workers(i);
+			return FAILURE;
+		}
+	return SUCCESS;
+}
+
+/* Queue task to run fn(arg), running it right away when there are no other threads or the deque is full */
+void apc_spawn(apc_task_t *task, void (*fn)(void *), void *arg)
+{
+	task->fn = fn;
+	task->arg = arg;
+	atomic_store(&task->done, 0);
+
+	if (pool.count == 1 || push(&pool.deque[worker_id], task) == FAILURE)
+	{
+		run(task);
+		return;
+	}
+	atomic_fetch_add(&pool.pending, 1);
+	pthread_mutex_lock(&pool.idle_lock);
+	pthread_cond_signal(&pool.idle_cond);
+	pthread_mutex_unlock(&pool.idle_lock);
+}
+
+/* Return once task has run, helping with queued tasks in the meantime */
+void apc_wait(apc_task_t *task)
+{
+	while (!atomic_load_explicit(&task->done, memory_order_acquire))
+	{
+		apc_task_t *other = find_task(worker_id);
+		if (other)
+			run(other);
+		else
+			sched_yield();
+	}
+}
+
+typedef struct
+{
+	void (*fn)(void *ctx, int lo, int hi);
+	void *ctx;
+	int lo;
+	int hi;
+}chunk_t;
+
+static void run_chunk(void *arg)
+{
+	chunk_t *chunk = arg;
+	chunk->fn(chunk->ctx, chunk->lo, chunk->hi);
+}
+
+/* fn(ctx, lo, hi) over [0, n) in chunks of at least grain, spread over the pool */
+void apc_parallel_for(int n, int grain, void (*fn)(void *ctx, int lo, int hi), void *ctx)
+{
+	int chunks = grain > 0 ? n / grain : n;
+
+	if (chunks > 4 * pool.count)
+		chunks = 4 * pool.count;
+	if (chunks > MAX_CHUNKS)
+		chunks = MAX_CHUNKS;
+	if (pool.count == 1 || chunks < 2)
+	{
+		fn(ctx, 0, n);
+		return;
+	}
+
+	chunk_t chunk[MAX_CHUNKS];
+	apc_task_t task[MAX_CHUNKS];
+	for (int i = 0; i < chunks; i++)
+	{
+		chunk[i] = (chunk_t){fn, ctx, (int)((long long)n * i / chunks), (int)((long long)n * (i + 1) / chunks)};
+		if (i > 0)
+			apc_spawn(&task[i], run_chunk, &chunk[i]);
+	}
+	run_chunk(&chunk[0]);
+	for (int i = 1; i < chunks; i++)
+		apc_wait(&task[i]);
+}
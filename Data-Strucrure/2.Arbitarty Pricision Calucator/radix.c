@@ -0,0 +1,204 @@
+/*******************************************************************************************************************************************************************
+*Title			: Radix conversion
+*Description		: These functions convert between the base 10^9 limbs and hexadecimal text. Decimal text maps onto the limbs nine digits
+*			: at a time in linear time, but hexadecimal words do not line up with decimal limbs, so a word by word conversion costs
+*			: O(n^2). Both directions split the number in halves around cached powers 2^(32 2^j) instead, which keeps the cost at a
+*			: few multiplications (or divisions) of full size.
+*Prototype		: int bigint_from_hex(bigint_t *a, const char *str);
+*			: char *bigint_to_hex(const bigint_t *a);
+*			: uint32_t *bigint_to_words(const bigint_t *a, int *count);
+*Output			: Status (SUCCESS / FAILURE) / malloc'd string
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include <ctype.h>
+#include "apc.h"
+
+/* Word counts at or below this are converted one word at a time */
+#define WORDS_BASECASE 32
+#define MAX_POWERS 32
+
+/* pow_cache[j] = 2^(32 2^j), built by squaring on first use and kept for later conversions */
+static bigint_t pow_cache[MAX_POWERS];
+static int pow_count;
+
+static const bigint_t *word_power(int j)
+{
+	while (pow_count <= j)
+	{
+		bigint_t *p = &pow_cache[pow_count];
+		bigint_init(p);
+		if (pow_count == 0 ? bigint_set_int(p, 1ll << 32) : bigint_mul(p, &pow_cache[pow_count - 1], &pow_cache[pow_count - 1]))
+			return NULL;
+		pow_count++;
+	}
+	return &pow_cache[j];
+}
+
+/* div_cache[j] holds the reciprocal of pow_cache[j], every split of one level divides by the same power */
+static bigint_divisor_t div_cache[MAX_POWERS];
+static int div_count;
+
+static const bigint_divisor_t *word_divisor(int j)
+{
+	while (div_count <= j)
+	{
+		const bigint_t *p = word_power(div_count);
+		if (p == NULL || bigint_divisor_init(&div_cache[div_count], p) == FAILURE)
+			return NULL;
+		div_count++;
+	}
+	return &div_cache[j];
+}
+
+/* Largest power of two strictly below count, as an exponent */
+static int split_log2(int count)
+{
+	int j = 0;
+	while ((2 << j) < count)
+		j++;
+	return j;
+}
+
+/* x = sum w[i] 2^(32 i) for i < count */
+static int from_words(bigint_t *x, const uint32_t *w, int count)
+{
+	if (count <= WORDS_BASECASE)
+	{
+		bigint_t word;
+		bigint_init(&word);
+		bigint_set_int(x, 0);
+		for (int i = count - 1; i >= 0; i--)
+			if (bigint_mul_1(x, x, 1 << 16) == FAILURE || bigint_mul_1(x, x, 1 << 16) == FAILURE ||
+					bigint_set_int(&word, w[i]) == FAILURE || bigint_add_inplace(x, &word) == FAILURE)
+			{
+				bigint_free(&word);
+				return FAILURE;
+			}
+		bigint_free(&word);
+		return SUCCESS;
+	}
+
+	int j = split_log2(count), half = 1 << j, status = FAILURE;
+	const bigint_t *p = word_power(j);
+	bigint_t high;
+	bigint_init(&high);
+	if (p && from_words(&high, w + half, count - half) == SUCCESS && from_words(x, w, half) == SUCCESS &&
+			bigint_mul(&high, &high, p) == SUCCESS)
+		status = bigint_add_inplace(x, &high);
+	bigint_free(&high);
+	return status;
+}
+
+/* Write exactly count words of x, for 0 <= x < 2^(32 count) */
+static int to_words(const bigint_t *x, uint32_t *w, int count)
+{
+	if (count <= WORDS_BASECASE)
+	{
+		bigint_t q;
+		limb_t lo, hi;
+		bigint_init(&q);
+		if (bigint_copy(&q, x) == FAILURE)
+			return FAILURE;
+		for (int i = 0; i < count; i++)
+		{
+			bigint_divrem_1(&q, &q, 1 << 16, &lo);
+			bigint_divrem_1(&q, &q, 1 << 16, &hi);
+			w[i] = hi << 16 | lo;
+		}
+		bigint_free(&q);
+		return SUCCESS;
+	}
+
+	int j = split_log2(count), half = 1 << j, status = FAILURE;
+	const bigint_divisor_t *d = word_divisor(j);
+	bigint_t q, r;
+	bigint_init(&q);
+	bigint_init(&r);
+	if (d && bigint_divrem_pre(&q, &r, x, d) == SUCCESS && to_words(&r, w, half) == SUCCESS)
+		status = to_words(&q, w + half, count - half);
+	bigint_free(&q);
+	bigint_free(&r);
+	return status;
+}
+
+/* Parse an optionally signed hexadecimal string, with or without a 0x prefix */
+int bigint_from_hex(bigint_t *a, const char *str)
+{
+	int sign = 1;
+
+	if (*str == '-' || *str == '+')
+		sign = (*str++ == '-') ? -1 : 1;
+	if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+		str += 2;
+
+	int len = strlen(str);
+	if (len == 0)
+		return FAILURE;
+	for (int i = 0; i < len; i++)
+		if (!isxdigit((unsigned char)str[i]))
+			return FAILURE;
+
+	int count = (len + 7) / 8;
+	uint32_t *w = malloc((size_t)count * sizeof(uint32_t));
+	if (w == NULL)
+		return FAILURE;
+	for (int i = 0, end = len; i < count; i++, end -= 8)
+	{
+		uint32_t word = 0;
+		for (int k = end > 8 ? end - 8 : 0; k < end; k++)
+			word = word << 4 | (isdigit((unsigned char)str[k]) ? str[k] - '0' : (tolower((unsigned char)str[k]) - 'a' + 10));
+		w[i] = word;
+	}
+
+	int status = from_words(a, w, count);
+	free(w);
+	if (status == SUCCESS)
+	{
+		a->sign = sign;
+		bigint_normalize(a);
+	}
+	return status;
+}
+
+/* Return the 32 bit words of |a|, least significant first, in a malloc'd array of *count words (at least one), NULL on failure */
+uint32_t *bigint_to_words(const bigint_t *a, int *count)
+{
+	/* 10^9 < 2^30, so each limb needs at most 30 bits */
+	int n = (a->size * 30 + 31) / 32 + 1;
+	uint32_t *w = malloc((size_t)n * sizeof(uint32_t));
+	bigint_t mag = *a;
+
+	mag.sign = 1;
+	if (w == NULL || to_words(&mag, w, n) == FAILURE)
+	{
+		free(w);
+		return NULL;
+	}
+	while (n > 1 && w[n - 1] == 0)
+		n--;
+	*count = n;
+	return w;
+}
+
+/* Return a malloc'd "0x" prefixed hexadecimal string of a, NULL on failure */
+char *bigint_to_hex(const bigint_t *a)
+{
+	int count;
+	uint32_t *w = bigint_to_words(a, &count);
+	char *str = w ? malloc((size_t)count * 8 + 4) : NULL;
+
+	if (str == NULL)
+	{
+		free(w);
+		return NULL;
+	}
+
+	char *ptr = str;
+	if (a->sign < 0)
+		*ptr++ = '-';
+	ptr += sprintf(ptr, "0x%x", w[count - 1]);
+	for (int i = count - 2; i >= 0; i--)
+		ptr += sprintf(ptr, "%08x", w[i]);
+	free(w);
+	return str;
+}
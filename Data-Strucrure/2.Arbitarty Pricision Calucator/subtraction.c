@@ -1,6 +1,7 @@
 /*******************************************************************************************************************************************************************
 *Title			: Subtraction
 *Description		: This function performs subtraction of two given large numbers and store the result in the resultant list.
+			: The lists are packed into base 10^9 limb vectors (bigint_t) and the limb kernel does the work.
 *Prototype		: int subtraction(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR);
 *Input Parameters	: head1: Pointer to the first node of the first double linked list.
 			: tail1: Pointer to the last node of the first double linked list.
@@ -11,7 +12,62 @@
 *******************************************************************************************************************************************************************/
 #include "apc.h"
 
+/* Limb kernel: r[0..n) = a[0..n) - b[0..n), returns the borrow out */
+limb_t apc_sub_n(limb_t *r, const limb_t *a, const limb_t *b, int n)
+{
+	limb_t borrow = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		limb_t sub = b[i] + borrow;
+		borrow = a[i] < sub;
+		r[i] = a[i] - sub + (-borrow & APC_BASE);
+	}
+	return borrow;
+}
+
+/* Limb kernel: r[0..n) = a[0..n) - borrow, returns the borrow out */
+limb_t apc_sub_1(limb_t *r, const limb_t *a, int n, limb_t borrow)
+{
+	int i = 0;
+
+	for (; i < n && borrow; i++)
+	{
+		borrow = a[i] == 0;
+		r[i] = borrow ? APC_BASE - 1 : a[i] - 1;
+	}
+	if (r != a)
+		for (; i < n; i++)
+			r[i] = a[i];
+	return borrow;
+}
+
+/* r = |a| - |b| for |a| >= |b|, the sign of r is left to the caller */
+int bigint_sub_abs(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	int n = a->size, m = b->size;
+
+	if (bigint_reserve(r, n) == FAILURE)
+		return FAILURE;
+	limb_t borrow = apc_sub_n(r->limb, a->limb, b->limb, m);
+	apc_sub_1(r->limb + m, a->limb + m, n - m, borrow);
+	r->size = n;
+	bigint_normalize(r);
+	return SUCCESS;
+}
+
+int bigint_sub(bigint_t *r, const bigint_t *a, const bigint_t *b)
+{
+	return bigint_add_sign(r, a, b, -b->sign);
+}
+
+/* acc -= x without allocating once acc has grown to its working size */
+int bigint_sub_inplace(bigint_t *acc, const bigint_t *x)
+{
+	return bigint_add_sign(acc, acc, x, -x->sign);
+}
+
 int subtraction(Dlist **head1, Dlist **tail1, Dlist **head2, Dlist **tail2, Dlist **headR)
 {
-	/* Definition goes here */
+	return dlist_operation(bigint_sub, head1, tail1, head2, tail2, headR);
 }
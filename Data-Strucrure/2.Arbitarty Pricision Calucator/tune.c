@@ -0,0 +1,394 @@
+/*******************************************************************************************************************************************************************
+*Title			: Threshold tuning
+*Description		: This function times the multiplication algorithms against each other on this machine, checks that they agree and picks
+*			: the Karatsuba, Toom-3 and NTT crossover points. The picked values are applied to the running program and printed as
+*			: compiler flags so they can be baked into the build. The NTT is also checked against the schoolbook product, including
+*			: operands of all 999999999 limbs that drive the convolution terms to their largest values.
+*			: apc_bench_threads() times large products on a growing number of threads and checks them against one thread.
+*			: apc_bench_modexp() counts 2048 and 4096 bit modular exponentiations per second on random odd moduli and checks them
+*			: against plain square and multiply with a division per step, and the inverse against a a^-1 = 1.
+*			: apc_bench_alloc() counts the system allocations and pooled buffers behind each operation once the buffers of the
+*			: result and the scratch space have been through one warm up round.
+*Prototype		: int apc_tune(void);
+*			: int apc_bench_threads(int max_threads);
+*			: int apc_bench_modexp(void);
+*			: int apc_bench_alloc(void);
+*Output			: Status (SUCCESS / FAILURE)
+*******************************************************************************************************************************************************************/
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "apc.h"
+
+#define TUNE_MIN_TIME 0.02
+#define APC_MODEXP_MAX_BITS 4096
+
+double apc_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* xorshift64, fixed seed so every run times the same operands */
+static uint64_t next_random(void)
+{
+	static uint64_t state = 0x9e3779b97f4a7c15ull;
+
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+static void random_limbs(limb_t *a, int n)
+{
+	for (int i = 0; i < n; i++)
+		a[i] = next_random() % APC_BASE;
+	if (a[n - 1] == 0)
+		a[n - 1] = 1;
+}
+
+/* Seconds per n x n product with the current thresholds, repeated until the timing is stable */
+static double time_mul(limb_t *r, const limb_t *a, const limb_t *b, int n)
+{
+	int reps = 1;
+	double elapsed;
+
+	for (;;)
+	{
+		double start = apc_now();
+		for (int i = 0; i < reps; i++)
+			apc_mul(r, a, n, b, n);
+		elapsed = apc_now() - start;
+		if (elapsed >= TUNE_MIN_TIME)
+			return elapsed / reps;
+		reps *= 2;
+	}
+}
+
+/*
+ * Find the first size, from lo up to hi, where setting *threshold to the size (one level
+ * of the faster algorithm) beats leaving it disabled, confirmed on two sizes in a row
+ */
+static int crossover(int *threshold, int lo, int hi, const char *name, limb_t *r1, limb_t *r2, limb_t *a, limb_t *b)
+{
+	int found = 0;
+
+	printf("%8s %14s %14s\n", "limbs", "without (us)", name);
+	for (int n = lo; n <= hi; n += n / 8 + 1)
+	{
+		random_limbs(a, n);
+		random_limbs(b, n);
+
+		*threshold = INT_MAX;
+		double slow = time_mul(r1, a, b, n);
+		*threshold = n;
+		double fast = time_mul(r2, a, b, n);
+		printf("%8d %14.2f %14.2f\n", n, slow * 1e6, fast * 1e6);
+
+		if (memcmp(r1, r2, (size_t)2 * n * sizeof(limb_t)))
+		{
+			printf("Error: %s and the smaller algorithm disagree at %d limbs\n", name, n);
+			return -1;
+		}
+		if (fast < slow)
+		{
+			if (found)
+				return found;
+			found = n;
+		}
+		else
+			found = 0;
+	}
+	return found ? found : hi;
+}
+
+/* Compare the transform with the schoolbook product on random and worst case operands */
+static int check_ntt(limb_t *r1, limb_t *r2, limb_t *a, limb_t *b, int max)
+{
+	int sizes[][2] = {{1, 1}, {3, 700}, {257, 255}, {1000, 999}, {max / 2, max / 2}};
+
+	for (int t = 0; t < (int)(sizeof(sizes) / sizeof(sizes[0])); t++)
+		for (int worst = 0; worst < 2; worst++)
+		{
+			int n = sizes[t][0], m = sizes[t][1];
+			random_limbs(a, n);
+			random_limbs(b, m);
+			if (worst)
+			{
+				for (int i = 0; i < n; i++)
+					a[i] = APC_BASE - 1;
+				for (int i = 0; i < m; i++)
+					b[i] = APC_BASE - 1;
+			}
+			apc_mul_basecase(r1, a, n, b, m);
+			if (apc_mul_ntt(r2, a, n, b, m) == FAILURE || memcmp(r1, r2, (size_t)(n + m) * sizeof(limb_t)))
+			{
+				printf("Error: NTT and schoolbook disagree at %d x %d limbs\n", n, m);
+				return FAILURE;
+			}
+		}
+	printf("NTT matches the schoolbook product\n");
+	return SUCCESS;
+}
+
+int apc_tune(void)
+{
+	int max = 16384;
+	limb_t *a = malloc((size_t)6 * max * sizeof(limb_t));
+	if (a == NULL)
+		return FAILURE;
+	limb_t *b = a + max, *r1 = b + max, *r2 = r1 + 2 * max;
+
+	if (check_ntt(r1, r2, a, b, max) == FAILURE)
+	{
+		free(a);
+		return FAILURE;
+	}
+
+	apc_ntt_threshold = INT_MAX;
+	apc_toom3_threshold = INT_MAX;
+	int karatsuba = crossover(&apc_karatsuba_threshold, 8, 256, "karatsuba (us)", r1, r2, a, b);
+	if (karatsuba < 0)
+	{
+		free(a);
+		return FAILURE;
+	}
+	apc_karatsuba_threshold = karatsuba;
+
+	int toom3 = crossover(&apc_toom3_threshold, 2 * karatsuba, max / 4, "toom-3 (us)", r1, r2, a, b);
+	if (toom3 < 0)
+	{
+		free(a);
+		return FAILURE;
+	}
+	apc_toom3_threshold = toom3;
+
+	int ntt = crossover(&apc_ntt_threshold, 2 * karatsuba, max, "ntt (us)", r1, r2, a, b);
+	free(a);
+	if (ntt < 0)
+		return FAILURE;
+	apc_ntt_threshold = ntt;
+
+	printf("Karatsuba threshold: %d limbs, Toom-3 threshold: %d limbs, NTT threshold: %d limbs\n", karatsuba, toom3, ntt);
+	printf("Build with: -DAPC_KARATSUBA_THRESHOLD=%d -DAPC_TOOM3_THRESHOLD=%d -DAPC_NTT_THRESHOLD=%d\n", karatsuba, toom3, ntt);
+	return SUCCESS;
+}
+
+/* Time n x n products on 1 up to max_threads threads, each checked against the single thread product */
+int apc_bench_threads(int max_threads)
+{
+	int sizes[] = {10000, 100000, 1000000};
+	int max = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1], status = SUCCESS;
+
+	if (max_threads < 1)
+		return FAILURE;
+	limb_t *a = malloc((size_t)6 * max * sizeof(limb_t));
+	if (a == NULL)
+		return FAILURE;
+	limb_t *b = a + max, *ref = b + max, *r = ref + 2 * max;
+
+	printf("%8s %8s %12s %8s\n", "limbs", "threads", "time (ms)", "speedup");
+	for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])) && status == SUCCESS; s++)
+	{
+		int n = sizes[s];
+		double base = 0;
+		random_limbs(a, n);
+		random_limbs(b, n);
+		for (int t = 1; t <= max_threads; t++)
+		{
+			if (apc_set_threads(t) == FAILURE)
+			{
+				printf("Error: Unable to start %d threads\n", t);
+				status = FAILURE;
+				break;
+			}
+			double elapsed = time_mul(t == 1 ? ref : r, a, b, n);
+			if (t == 1)
+				base = elapsed;
+			else if (memcmp(ref, r, (size_t)2 * n * sizeof(limb_t)))
+			{
+				printf("Error: %d threads and one thread disagree at %d limbs\n", t, n);
+				status = FAILURE;
+				break;
+			}
+			printf("%8d %8d %12.2f %8.2f\n", n, t, elapsed * 1e3, base / elapsed);
+		}
+	}
+	apc_set_threads(1);
+	free(a);
+	return status;
+}
+
+/* Random number of exactly bits bits, odd and not a multiple of 5 when modulus is set */
+static int random_bits(bigint_t *a, int bits, int modulus)
+{
+	char hex[APC_MODEXP_MAX_BITS / 4 + 1];
+	int digits = bits / 4;
+
+	do
+	{
+		for (int i = 0; i < digits; i++)
+			hex[i] = "0123456789abcdef"[next_random() >> 60];
+		hex[0] = "89abcdef"[next_random() >> 61];
+		if (modulus)
+			hex[digits - 1] = "13579bdf"[next_random() >> 61];
+		hex[digits] = '\0';
+		if (bigint_from_hex(a, hex) == FAILURE)
+			return FAILURE;
+	} while (modulus && a->limb[0] % 5 == 0);
+	return SUCCESS;
+}
+
+/* r = base^exp mod m the slow way, one bit at a time from the top */
+static int powmod_reference(bigint_t *r, const bigint_t *base, const bigint_t *exp, const bigint_t *m)
+{
+	bigint_t t;
+	uint32_t *w;
+	int count, status = FAILURE;
+
+	bigint_init(&t);
+	if ((w = bigint_to_words(exp, &count)) == NULL)
+		return FAILURE;
+	if (bigint_set_int(r, 1) == FAILURE)
+		goto out;
+	for (int i = 32 * count - 1; i >= 0; i--)
+	{
+		if (bigint_mul(&t, r, r) == FAILURE || bigint_divrem(NULL, r, &t, m) == FAILURE)
+			goto out;
+		if (w[i / 32] >> (i % 32) & 1)
+			if (bigint_mul(&t, r, base) == FAILURE || bigint_divrem(NULL, r, &t, m) == FAILURE)
+				goto out;
+	}
+	status = SUCCESS;
+out:
+	free(w);
+	bigint_free(&t);
+	return status;
+}
+
+/* Modular exponentiations per second with full size exponents, for RSA sized moduli */
+int apc_bench_modexp(void)
+{
+	int sizes[] = {2048, APC_MODEXP_MAX_BITS};
+	bigint_t m, base, exp, r, ref, inv;
+	bigint_t *all[] = {&m, &base, &exp, &r, &ref, &inv};
+	int status = FAILURE;
+
+	for (int i = 0; i < 6; i++)
+		bigint_init(all[i]);
+
+	printf("%8s %12s %12s\n", "bits", "modexp/s", "ms/modexp");
+	for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		int bits = sizes[s], reps = 0;
+		if (random_bits(&m, bits, 1) == FAILURE || random_bits(&base, bits - 1, 0) == FAILURE ||
+				random_bits(&exp, bits, 0) == FAILURE)
+			goto out;
+
+		if (bigint_powmod(&r, &base, &exp, &m) == FAILURE || powmod_reference(&ref, &base, &exp, &m) == FAILURE)
+			goto out;
+		if (bigint_cmp(&r, &ref))
+		{
+			printf("Error: modexp and square and multiply disagree at %d bits\n", bits);
+			goto out;
+		}
+		if (bigint_invmod(&inv, &base, &m) == FAILURE || bigint_mul(&ref, &inv, &base) == FAILURE ||
+				bigint_mod(&ref, &ref, &m) == FAILURE || ref.size != 1 || ref.limb[0] != 1)
+		{
+			printf("Error: modular inverse is wrong at %d bits\n", bits);
+			goto out;
+		}
+
+		double start = apc_now(), elapsed;
+		do
+		{
+			if (bigint_powmod(&r, &base, &exp, &m) == FAILURE)
+				goto out;
+			reps++;
+			elapsed = apc_now() - start;
+		} while (elapsed < 1.0);
+		printf("%8d %12.2f %12.3f\n", bits, reps / elapsed, elapsed * 1e3 / reps);
+	}
+	printf("Modular exponentiation matches square and multiply\n");
+	status = SUCCESS;
+out:
+	for (int i = 0; i < 6; i++)
+		bigint_free(all[i]);
+	return status;
+}
+
+/* One operation of the allocation benchmark on operands of a given size, results reuse r and q */
+static int alloc_op(int op, bigint_t *r, bigint_t *q, const bigint_t *a, const bigint_t *b, bigdec_t *d, const bigdec_t *x, const bigdec_t *y)
+{
+	switch (op)
+	{
+		case 0:
+			return bigint_set_int(r, -123456789012345678ll);
+		case 1:
+			return bigint_add(r, a, b);
+		case 2:
+			return bigint_mul(r, a, b);
+		case 3:
+			return bigint_divrem(q, r, a, b);
+		default:
+			return bigdec_div(d, x, y, 9 * a->size);
+	}
+}
+
+/* Allocations per operation for small, medium and large operands, after a warm up round */
+int apc_bench_alloc(void)
+{
+	static const char *name[] = {"set", "add", "mul", "divrem", "decimal div"};
+	int sizes[] = {1, 3, 100, 5000, 200000}, status = FAILURE;
+	bigint_t a, b, r, q;
+	bigdec_t d, x, y;
+
+	bigint_init(&a);
+	bigint_init(&b);
+	bigint_init(&r);
+	bigint_init(&q);
+	bigdec_init(&d);
+	bigdec_init(&x);
+	bigdec_init(&y);
+
+	printf("%8s %12s %8s %12s %12s\n", "limbs", "operation", "reps", "malloc/op", "reused/op");
+	for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		int n = sizes[s], reps = n >= 100000 ? 3 : n >= 1000 ? 20 : 10000;
+		if (bigint_reserve(&a, 2 * n) == FAILURE || bigint_reserve(&b, n) == FAILURE)
+			goto out;
+		random_limbs(a.limb, 2 * n);
+		random_limbs(b.limb, n);
+		a.size = 2 * n;
+		b.size = n;
+		if (bigint_copy(&x.mant, &a) == FAILURE || bigint_copy(&y.mant, &b) == FAILURE)
+			goto out;
+		x.exp = -7;
+		y.exp = 3;
+
+		for (int op = 0; op < (int)(sizeof(name) / sizeof(name[0])); op++)
+		{
+			long heap0, reused0, heap1, reused1;
+			if (alloc_op(op, &r, &q, &a, &b, &d, &x, &y) == FAILURE)
+				goto out;
+			apc_alloc_stats(&heap0, &reused0);
+			for (int i = 0; i < reps; i++)
+				if (alloc_op(op, &r, &q, &a, &b, &d, &x, &y) == FAILURE)
+					goto out;
+			apc_alloc_stats(&heap1, &reused1);
+			printf("%8d %12s %8d %12.2f %12.2f\n", n, name[op], reps, (double)(heap1 - heap0) / reps, (double)(reused1 - reused0) / reps);
+		}
+	}
+	status = SUCCESS;
+out:
+	bigint_free(&a);
+	bigint_free(&b);
+	bigint_free(&r);
+	bigint_free(&q);
+	bigdec_free(&d);
+	bigdec_free(&x);
+	bigdec_free(&y);
+	return status;
+}